@@ -0,0 +1,243 @@
+// HOST FUZZ HARNESS SUPPORT
+//
+// Each harness in this directory defines LLVMFuzzerTestOneInput() and includes this file.  Built
+// with MINUET_LIBFUZZER, the harness links against libFuzzer, which supplies main().  Otherwise
+// this file supplies a standalone main() that accepts the same basic options as libFuzzer:
+//
+//   harness [-runs=N] [-max_total_time=S] [-seed=N] [-max_len=N] [FILE_OR_DIR...]
+//
+// Given files or directories, it replays them once each, like libFuzzer does with -runs=0.
+// Otherwise it generates random inputs until it has run N of them or S seconds have passed,
+// forever if neither is given.  A failed check prints the condition and aborts.  So do the
+// sanitizers the harnesses are built with, and on any such crash the standalone driver saves the
+// input to crash-<hash> in the working directory.
+//
+// Inputs are read as 32-bit words so that the words the standalone driver generates line up with
+// the values the harnesses read.  The driver biases the words toward special values such as NaN,
+// infinities, zero and the integer limits.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fuzz {
+
+// The input being run, saved if a check fails.
+inline const uint8_t* g_data{nullptr};
+inline size_t g_size{0};
+
+[[noreturn]] inline void fail(const char* file, int line, const char* what) {
+  std::fprintf(stderr, "%s:%d: fuzz check failed: %s\n", file, line, what);
+  std::abort();
+}
+
+// Reads values from the input, one 32-bit word each.  Reads past the end return zero.
+class Input {
+public:
+  Input(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool empty() const { return this->offset_ >= this->size_; }
+
+  uint32_t word() {
+    uint32_t value = 0;
+    const size_t n = this->offset_ < this->size_ ? std::min<size_t>(4, this->size_ - this->offset_) : 0;
+    std::memcpy(&value, this->data_ + this->offset_, n);
+    this->offset_ += 4;
+    return value;
+  }
+
+  // Any float, including NaN, infinities and subnormals.
+  float any_float() {
+    const uint32_t bits = this->word();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  int any_int() { return static_cast<int>(this->word()); }
+  bool boolean() { return this->word() & 1; }
+
+  // An integer in [lo, hi].
+  uint32_t range(uint32_t lo, uint32_t hi) { return lo + this->word() % (hi - lo + 1); }
+
+  template <typename T, size_t N>
+  const T& pick(const T (&values)[N]) {
+    return values[this->word() % N];
+  }
+
+private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_{0};
+};
+
+}  // namespace fuzz
+
+#define FUZZ_CHECK(cond) \
+  do { \
+    if (!(cond)) ::fuzz::fail(__FILE__, __LINE__, #cond); \
+  } while (0)
+
+#ifndef MINUET_LIBFUZZER
+
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Make the sanitizers abort on the first error so that the crash handler below sees it.
+extern "C" const char* __asan_default_options() { return "abort_on_error=1"; }
+extern "C" const char* __ubsan_default_options() { return "abort_on_error=1:print_stacktrace=1"; }
+
+namespace fuzz {
+
+// Saves the input being run to crash-<FNV-1a hash>, then lets the signal take its course.  Only
+// uses async-signal-safe calls.
+inline void save_crash(int signal) {
+  if (g_data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < g_size; i++) hash = (hash ^ g_data[i]) * 1099511628211ull;
+    char name[] = "crash-0000000000000000";
+    for (int i = 0; i < 16; i++) name[sizeof(name) - 2 - i] = "0123456789abcdef"[(hash >> (4 * i)) & 0xf];
+    const int file = ::open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file >= 0) {
+      static const char SAVED[] = "Saved the input to ";
+      [[maybe_unused]] ssize_t n = ::write(file, g_data, g_size);
+      ::close(file);
+      n = ::write(STDERR_FILENO, SAVED, sizeof(SAVED) - 1);
+      n = ::write(STDERR_FILENO, name, sizeof(name) - 1);
+      n = ::write(STDERR_FILENO, "\n", 1);
+    }
+    g_data = nullptr;
+  }
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+}
+
+inline int run_one(const std::vector<uint8_t>& input) {
+  g_data = input.data();
+  g_size = input.size();
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+  g_data = nullptr;
+  return 0;
+}
+
+inline bool replay(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+    return false;
+  }
+  const std::vector<uint8_t> input{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  run_one(input);
+  return true;
+}
+
+// A random word: mostly plain random bits and small integers, often a special float.
+inline uint32_t random_word(std::mt19937_64& random) {
+  static constexpr float SPECIAL[] = {
+    NAN, -NAN, INFINITY, -INFINITY, 0.0f, -0.0f, 1.0f, -1.0f, 0.5f,
+    std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+    std::numeric_limits<float>::min(), std::numeric_limits<float>::denorm_min(),
+  };
+  float value;
+  switch (random() % 8) {
+    case 0: value = SPECIAL[random() % std::size(SPECIAL)]; break;
+    case 1: return static_cast<uint32_t>(random() % 16);
+    case 2: return random() % 2 ? 0xffffffffu : 0x80000000u;
+    case 3: value = std::uniform_real_distribution<float>(-100.0f, 100.0f)(random); break;
+    case 4: value = std::uniform_real_distribution<float>(0.0f, 5000.0f)(random); break;
+    default: return static_cast<uint32_t>(random());
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline int main(int argc, char** argv) {
+  long long runs = -1;
+  double max_total_time_s = 0.0;
+  uint64_t seed = std::random_device{}();
+  size_t max_len = 4096;
+  std::vector<std::filesystem::path> paths;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const auto value = [&](const char* option) { return arg.substr(std::strlen(option)); };
+    if (arg.rfind("-runs=", 0) == 0) {
+      runs = std::stoll(value("-runs="));
+    } else if (arg.rfind("-max_total_time=", 0) == 0) {
+      max_total_time_s = std::stod(value("-max_total_time="));
+    } else if (arg.rfind("-seed=", 0) == 0) {
+      seed = std::stoull(value("-seed="));
+    } else if (arg.rfind("-max_len=", 0) == 0) {
+      max_len = std::max<size_t>(std::stoul(value("-max_len=")), 4);
+    } else if (arg.rfind("-", 0) == 0) {
+      std::fprintf(stderr, "Ignoring unsupported option %s\n", arg.c_str());
+    } else {
+      paths.emplace_back(arg);
+    }
+  }
+
+  for (int signal : {SIGABRT, SIGSEGV, SIGBUS, SIGILL, SIGFPE}) std::signal(signal, save_crash);
+
+  if (!paths.empty()) {
+    size_t count = 0;
+    for (const auto& path : paths) {
+      if (std::filesystem::is_directory(path)) {
+        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+          if (entry.is_regular_file() && replay(entry.path())) count++;
+        }
+      } else if (replay(path)) {
+        count++;
+      }
+    }
+    std::printf("Replayed %zu inputs\n", count);
+    return 0;
+  }
+
+  std::printf("Running with seed %llu\n", static_cast<unsigned long long>(seed));
+  std::mt19937_64 random(seed);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> input;
+  long long done = 0;
+  for (; runs < 0 || done < runs; done++) {
+    if (max_total_time_s > 0.0 && done % 256 == 0) {
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (elapsed.count() >= max_total_time_s) break;
+    }
+    // Mostly short inputs, sometimes up to max_len
+    const size_t words = 1 + random() % (random() % 8 ? std::min<size_t>(max_len / 4, 64) : max_len / 4);
+    input.resize(words * 4);
+    for (size_t i = 0; i < words; i++) {
+      const uint32_t word = random_word(random);
+      std::memcpy(input.data() + 4 * i, &word, 4);
+    }
+    // Sometimes cut the last word short
+    if (random() % 16 == 0) input.resize(input.size() - 1 - random() % 3);
+    run_one(input);
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("Done %lld runs in %.1f s\n", done, elapsed.count());
+  return 0;
+}
+
+}  // namespace fuzz
+
+int main(int argc, char** argv) { return fuzz::main(argc, argv); }
+
+#endif  // MINUET_LIBFUZZER
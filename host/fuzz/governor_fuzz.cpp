@@ -0,0 +1,188 @@
+// Fuzzes the governor with arbitrary tunables, a restored thermal model, and a sequence of
+// arbitrary readings and thermostat inputs, including NaN, infinities and values far out of range.
+//
+// Invariants:
+// - set_config() leaves every tunable finite and in its range, and applying the result again
+//   changes nothing.
+// - update() returns a level in [0, cap], where the cap is the quiet cap in the quiet fan mode, and
+//   0 in the off fan mode.
+// - Nothing non-finite reaches the controller state or the thermal model.
+// - From a reset governor, the level never falls as the thermal error grows, whether through a
+//   warmer cabin or a lower setpoint, nor as the CO2 concentration rises.
+#include "esphome.h"
+
+#include "governor.h"
+#include "fuzz.h"
+
+#include <cstring>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+constexpr float governor::GovernorConfig::* FLOAT_FIELDS[] = {
+  &governor::GovernorConfig::outside_margin_c, &governor::GovernorConfig::span_auto_c,
+  &governor::GovernorConfig::span_quiet_c, &governor::GovernorConfig::gamma_auto,
+  &governor::GovernorConfig::gamma_quiet, &governor::GovernorConfig::co2_target_ppm,
+  &governor::GovernorConfig::co2_deadband_ppm, &governor::GovernorConfig::co2_span_ppm,
+  &governor::GovernorConfig::co2_gamma, &governor::GovernorConfig::rh_target_pct,
+  &governor::GovernorConfig::rh_deadband_pct, &governor::GovernorConfig::rh_gamma,
+  &governor::GovernorConfig::rh_span_lo_pct, &governor::GovernorConfig::rh_span_hi_pct,
+  &governor::GovernorConfig::rh_outside_margin_pct,
+};
+
+constexpr ClimateFanMode FAN_MODES[] = {
+  ClimateFanMode::CLIMATE_FAN_ON, ClimateFanMode::CLIMATE_FAN_OFF, ClimateFanMode::CLIMATE_FAN_AUTO,
+  ClimateFanMode::CLIMATE_FAN_LOW, ClimateFanMode::CLIMATE_FAN_MEDIUM, ClimateFanMode::CLIMATE_FAN_HIGH,
+  ClimateFanMode::CLIMATE_FAN_QUIET,
+};
+constexpr ClimateAction ACTIONS[] = {
+  ClimateAction::CLIMATE_ACTION_COOLING, ClimateAction::CLIMATE_ACTION_COOLING, ClimateAction::CLIMATE_ACTION_IDLE,
+  ClimateAction::CLIMATE_ACTION_OFF, ClimateAction::CLIMATE_ACTION_FAN,
+};
+constexpr minuet::LidMode LID_MODES[] = {minuet::LidMode::AUTO, minuet::LidMode::OPEN, minuet::LidMode::CLOSED};
+
+bool in_range(float x, float lo, float hi) { return x >= lo && x <= hi; }
+
+void check_config() {
+  const governor::GovernorConfig& c = governor::g_config;
+  for (const auto field : FLOAT_FIELDS) FUZZ_CHECK(std::isfinite(c.*field));
+  FUZZ_CHECK(c.span_auto_c >= 0.1f && c.span_quiet_c >= 0.1f);
+  FUZZ_CHECK(in_range(c.gamma_auto, 0.1f, 10.0f) && in_range(c.gamma_quiet, 0.1f, 10.0f));
+  FUZZ_CHECK(in_range(c.co2_target_ppm, governor::kMpcOutdoorCO2PPM + 50.0f, 5000.0f));
+  FUZZ_CHECK(in_range(c.co2_deadband_ppm, 0.0f, c.co2_target_ppm - governor::kMpcOutdoorCO2PPM));
+  FUZZ_CHECK(c.co2_span_ppm >= 1.0f && in_range(c.co2_gamma, 0.1f, 10.0f));
+  FUZZ_CHECK(in_range(c.rh_target_pct, 0.0f, 100.0f) && in_range(c.rh_deadband_pct, 0.0f, 50.0f));
+  FUZZ_CHECK(in_range(c.rh_gamma, 0.1f, 10.0f) && c.rh_span_hi_pct > c.rh_span_lo_pct);
+  FUZZ_CHECK(c.max_level_quiet >= governor::kMinOnLevel && c.max_level_quiet <= governor::kMaxLevel);
+
+  const governor::GovernorConfig applied = c;
+  governor::set_config(applied);
+  FUZZ_CHECK(std::memcmp(&applied, &governor::g_config, sizeof(applied)) == 0);
+}
+
+void check_state() {
+  const governor::GovernorState& st = governor::g_state;
+  FUZZ_CHECK(in_range(st.thermal_integral, 0.0f, governor::kMaxLevel));
+  FUZZ_CHECK(std::isfinite(st.thermal_pi_output) && std::isfinite(st.thermal_pi_dt_s));
+  FUZZ_CHECK(st.thermal_pi_level >= 0 && st.thermal_pi_level <= governor::kMaxLevel);
+  FUZZ_CHECK(st.model_level >= 0 && st.model_level <= governor::kMaxLevel);
+  FUZZ_CHECK(std::isfinite(st.model_last_Tin) && std::isfinite(st.model_level_ms));
+  FUZZ_CHECK(std::isfinite(st.Tin_prev) && std::isfinite(st.RHi_prev) && std::isfinite(st.CO2_prev));
+  FUZZ_CHECK(!std::isinf(st.co2_generation));  // NAN until known
+  for (float value : governor::g_model.theta) FUZZ_CHECK(std::isfinite(value));
+  for (const auto& row : governor::g_model.P) {
+    for (float value : row) FUZZ_CHECK(std::isfinite(value));
+  }
+}
+
+struct Readings {
+  float Tin, Tout, RHi, RHo, CO2;
+};
+
+void push_readings(const Readings& r, uint32_t now_ms) {
+  governor::g_channel_Tin.push(r.Tin, now_ms);
+  governor::g_channel_Tout.push(r.Tout, now_ms);
+  governor::g_channel_RHi.push(r.RHi, now_ms);
+  governor::g_channel_RHo.push(r.RHo, now_ms);
+  governor::g_channel_CO2.push(r.CO2, now_ms);
+}
+
+governor::ControlOutput checked_update(const governor::ControlInput& input) {
+  const governor::ControlOutput output = governor::update(input);
+  const int cap = input.fan_mode == ClimateFanMode::CLIMATE_FAN_QUIET ? governor::g_config.max_level_quiet
+                                                                      : governor::kMaxLevel;
+  FUZZ_CHECK(output.fan_speed >= 0 && output.fan_speed <= cap);
+  if (input.fan_mode == ClimateFanMode::CLIMATE_FAN_OFF) FUZZ_CHECK(output.fan_speed == 0);
+  check_state();
+  return output;
+}
+
+// The proportional level for one set of readings from a freshly reset governor.
+int fresh_level(const Readings& r, const governor::ControlInput& input) {
+  governor::reset();
+  for (governor::SensorChannel* channel : {&governor::g_channel_Tin, &governor::g_channel_Tout,
+                                           &governor::g_channel_RHi, &governor::g_channel_RHo,
+                                           &governor::g_channel_CO2}) {
+    channel->clear();
+  }
+  push_readings(r, esphome::millis());
+  return checked_update(input).fan_speed;
+}
+
+// Probes the response to the thermal error and CO2 at two points each.
+void check_monotonic(fuzz::Input& in) {
+  governor::g_thermal_mode = governor::ThermalMode::PROPORTIONAL;
+  governor::g_control_strategy = governor::ControlStrategy::PROPORTIONAL;
+  Readings lo{in.any_float(), in.any_float(), in.any_float(), in.any_float(), in.any_float()};
+  governor::ControlInput input{
+    .ambient_temperature = lo.Tin,
+    .target_temperature = in.any_float(),
+    .action = ClimateAction::CLIMATE_ACTION_COOLING,
+    .fan_mode = in.pick(FAN_MODES),
+    .lid_mode = minuet::LidMode::AUTO,
+  };
+  const float Tin_hi = in.any_float(), target_lo = in.any_float(), CO2_hi = in.any_float();
+
+  const int level = fresh_level(lo, input);
+  if (std::isfinite(lo.Tin) && std::isfinite(Tin_hi) && Tin_hi >= lo.Tin) {
+    Readings hi = lo;
+    hi.Tin = Tin_hi;
+    FUZZ_CHECK(fresh_level(hi, input) >= level);
+  }
+  if (std::isfinite(input.target_temperature) && std::isfinite(target_lo) && target_lo <= input.target_temperature) {
+    governor::ControlInput cooler = input;
+    cooler.target_temperature = target_lo;
+    FUZZ_CHECK(fresh_level(lo, cooler) >= level);
+  }
+  if (std::isfinite(lo.CO2) && std::isfinite(CO2_hi) && CO2_hi >= lo.CO2) {
+    Readings hi = lo;
+    hi.CO2 = CO2_hi;
+    FUZZ_CHECK(fresh_level(hi, input) >= level);
+  }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  fuzz::Input in(data, size);
+
+  // Configuration
+  governor::GovernorConfig config{};
+  for (const auto field : FLOAT_FIELDS) config.*field = in.any_float();
+  config.max_level_quiet = in.any_int();
+  governor::set_config(config);
+  check_config();
+  governor::g_enable_co2_control = in.boolean();
+  governor::g_enable_rh_control = in.boolean();
+  governor::g_thermal_mode = in.boolean() ? governor::ThermalMode::PI : governor::ThermalMode::PROPORTIONAL;
+  governor::g_control_strategy =
+      in.boolean() ? governor::ControlStrategy::PREDICTIVE : governor::ControlStrategy::PROPORTIONAL;
+
+  // A thermal model as restored from flash
+  governor::reset();
+  governor::reset_model();
+  governor::load_model({in.any_float(), in.any_float(), in.any_float(), in.any_float()});
+  check_state();
+
+  // A sequence of readings and thermostat inputs
+  const uint32_t steps = in.range(0, 24);
+  for (uint32_t step = 0; step < steps && !in.empty(); step++) {
+    host::advance_ms(in.range(0, 120000));
+    push_readings({in.any_float(), in.any_float(), in.any_float(), in.any_float(), in.any_float()},
+        esphome::millis());
+    const governor::ControlInput input{
+      .ambient_temperature = in.any_float(),
+      .target_temperature = in.any_float(),
+      .action = in.pick(ACTIONS),
+      .fan_mode = in.pick(FAN_MODES),
+      .lid_mode = in.pick(LID_MODES),
+    };
+    checked_update(input);
+  }
+
+  check_monotonic(in);
+
+  governor::set_config({});
+  return 0;
+}
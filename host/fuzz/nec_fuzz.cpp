@@ -0,0 +1,132 @@
+// Fuzzes the learned NEC remote codes with an arbitrary restored mapping array followed by a
+// sequence of received codes, including repeats and corrupted frames, and learning requests for
+// arbitrary action values.
+//
+// Invariants:
+// - nec_command() accepts exactly the single frames whose command's high byte is the complement of
+//   its low byte, and extracts the low byte.
+// - is_action() holds exactly for the values from LIGHT_TOGGLE to LAST_ACTION, and action_name()
+//   never returns null.
+// - The address tables never exceed MAX_ADDRESSES and every entry they bind is an action backed by
+//   a stored mapping, whatever the restored array held.
+// - Once sanitized, every stored mapping is in the tables, and sanitizing again changes nothing.
+// - A key that was learned successfully dispatches to its action.
+#include "esphome.h"
+
+#include "ir_remote.h"
+#include "fuzz.h"
+
+namespace ir = minuet::ir_remote;
+
+namespace {
+
+using esphome::remote_base::NECData;
+
+bool is_stored(uint16_t address, uint8_t command, ir::Action action) {
+  for (uint32_t packed : ir::mappings()) {
+    const ir::Mapping mapping = ir::Mapping::unpack(packed);
+    if (mapping.address == address && mapping.command == command && mapping.action == action) return true;
+  }
+  return false;
+}
+
+void check_tables() {
+  FUZZ_CHECK(ir::count() <= ir::mappings().size());
+  FUZZ_CHECK(ir::g_table_count <= ir::MAX_ADDRESSES);
+  for (size_t i = 0; i < ir::g_table_count; i++) {
+    const ir::AddressTable& table = ir::g_tables[i];
+    FUZZ_CHECK(ir::find_table(table.address) == &table);
+    for (size_t command = 0; command < table.actions.size(); command++) {
+      const ir::Action action = table.actions[command];
+      if (action == ir::Action::NONE) continue;
+      FUZZ_CHECK(ir::is_action(action));
+      FUZZ_CHECK(is_stored(table.address, uint8_t(command), action));
+    }
+  }
+}
+
+void check_sanitized() {
+  for (uint32_t packed : ir::mappings()) {
+    const ir::Mapping mapping = ir::Mapping::unpack(packed);
+    if (!ir::is_action(mapping.action)) continue;
+    const ir::AddressTable* table = ir::find_table(mapping.address);
+    FUZZ_CHECK(table && ir::is_action(table->actions[mapping.command]));
+  }
+}
+
+void check_code(const NECData& code) {
+  uint8_t command = 0x5a;
+  const bool valid = code.command_repeats == 1 && uint8_t(code.command ^ (code.command >> 8)) == 0xff;
+  FUZZ_CHECK(ir::nec_command(code, command) == valid);
+  FUZZ_CHECK(command == (valid ? uint8_t(code.command) : 0x5a));
+}
+
+void check_action(ir::Action action) {
+  FUZZ_CHECK(ir::is_action(action) == (uint8_t(action) >= 1 && uint8_t(action) <= uint8_t(ir::LAST_ACTION)));
+  FUZZ_CHECK(ir::action_name(action) != nullptr);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  fuzz::Input in(data, size);
+
+  // Mappings as restored from flash
+  for (uint32_t& packed : ir::mappings()) packed = in.word();
+  ir::g_learn_action = ir::Action::NONE;
+  ir::rebuild_tables();
+  check_tables();
+  const size_t stored = ir::count();
+  const size_t dropped = ir::sanitize();
+  FUZZ_CHECK(ir::count() == stored - dropped);
+  FUZZ_CHECK(ir::sanitize() == 0);
+  ir::rebuild_tables();
+  check_tables();
+  check_sanitized();
+
+  while (!in.empty()) {
+    switch (in.range(0, 3)) {
+      case 0:
+      case 1: {
+        // Mostly well-formed single frames so that learning and dispatch are reached
+        const uint16_t address = uint16_t(in.word());
+        const uint8_t low = uint8_t(in.word());
+        NECData code{address, uint16_t(low | ((~low & 0xff) << 8)), 1};
+        if (in.range(0, 3) == 0) code = {address, uint16_t(in.word()), uint16_t(in.word())};
+        check_code(code);
+        const ir::Action learning = ir::g_learn_action;
+        uint8_t command;
+        const bool valid = ir::nec_command(code, command);
+        const bool handled = ir::handle_nec(code);
+        if (!valid) {
+          FUZZ_CHECK(!handled && ir::g_learn_action == learning);
+          break;
+        }
+        if (learning != ir::Action::NONE) {
+          FUZZ_CHECK(handled && !ir::is_learning());
+          const ir::AddressTable* table = ir::find_table(code.address);
+          if (ir::is_action(learning) && table && table->actions[command] == learning) {
+            FUZZ_CHECK(ir::handle_nec(code));
+          }
+        }
+        break;
+      }
+      case 2: {
+        const ir::Action action = ir::Action(uint8_t(in.word()));
+        check_action(action);
+        ir::start_learning(action);
+        break;
+      }
+      case 3:
+        ir::cancel_learning();
+        FUZZ_CHECK(!ir::is_learning());
+        break;
+    }
+    check_tables();
+    check_sanitized();
+  }
+
+  ir::g_learn_action = ir::Action::NONE;
+  ir::clear();
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Fuzzes the records restored from flash: a thermal model record from the first 16 bytes, then
+// one persistent state record per remaining byte.
+//
+// Invariants:
+// - load_model() either takes the record, with its sample count saturated, or leaves the model
+//   untouched, and the saved model is finite and loads back unchanged.
+// - After sanitize() the fan speed is one of the fan's speeds, 1 to 10.
+// - sanitize() reports a change exactly when the record held an invalid value, changes only the
+//   invalid fields, and changes nothing when applied again.
+// - A valid record round-trips through the state unchanged.
+#include "esphome.h"
+
+#include "core.h"
+#include "governor.h"
+#include "fuzz.h"
+
+#include <cstring>
+
+namespace governor = minuet::governor;
+using minuet::PersistentState;
+
+namespace {
+
+void check_model(const governor::ThermalModelRecord& record) {
+  governor::reset_model();
+  const governor::ThermalModelRecord initial = governor::save_model();
+  governor::load_model(record);
+  const governor::ThermalModelRecord saved = governor::save_model();
+
+  bool valid = record[3] >= 1.0f;
+  for (float value : record) valid = valid && std::isfinite(value);
+  if (!valid) {
+    FUZZ_CHECK(saved == initial);
+    return;
+  }
+  FUZZ_CHECK(saved[0] == record[0] && saved[1] == record[1] && saved[2] == record[2]);
+  FUZZ_CHECK(saved[3] == std::floor(std::min(record[3], governor::kModelMaxRecordSamples)));
+  for (float value : saved) FUZZ_CHECK(std::isfinite(value));
+
+  governor::load_model(saved);
+  FUZZ_CHECK(governor::save_model() == saved);
+}
+
+void check_state(uint8_t record) {
+  PersistentState::Storage storage = record;
+  PersistentState& state = PersistentState::from_storage(storage);
+  const PersistentState restored = state;
+  const bool valid = restored.fan_speed >= 1 && restored.fan_speed <= 10;
+
+  FUZZ_CHECK(state.sanitize() == !valid);
+  FUZZ_CHECK(state.fan_speed >= 1 && state.fan_speed <= 10);
+  FUZZ_CHECK(state.fan_on == restored.fan_on && state.fan_exhaust == restored.fan_exhaust
+      && state.lid_open == restored.lid_open);
+  if (valid) FUZZ_CHECK(state.fan_speed == restored.fan_speed && state.to_storage() == record);
+
+  const PersistentState::Storage sanitized = state.to_storage();
+  FUZZ_CHECK(!state.sanitize() && state.to_storage() == sanitized);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  governor::ThermalModelRecord record{};
+  const size_t record_size = std::min(size, sizeof(record));
+  std::memcpy(record.data(), data, record_size);
+  check_model(record);
+
+  for (size_t i = record_size; i < size; i++) check_state(data[i]);
+  return 0;
+}
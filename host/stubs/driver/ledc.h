@@ -0,0 +1,62 @@
+// Host stub of the ESP-IDF LEDC driver.  Records the frequency and duty of each channel so that
+// tests can observe the PWM outputs.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef enum { LEDC_LOW_SPEED_MODE = 0, LEDC_SPEED_MODE_MAX } ledc_mode_t;
+typedef enum { LEDC_TIMER_0 = 0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3, LEDC_TIMER_MAX } ledc_timer_t;
+typedef enum {
+  LEDC_CHANNEL_0 = 0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3,
+  LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7, LEDC_CHANNEL_MAX,
+} ledc_channel_t;
+typedef enum { LEDC_TIMER_8_BIT = 8, LEDC_TIMER_10_BIT = 10, LEDC_TIMER_12_BIT = 12 } ledc_timer_bit_t;
+typedef enum { LEDC_AUTO_CLK = 0 } ledc_clk_cfg_t;
+
+typedef struct {
+  ledc_mode_t speed_mode;
+  ledc_timer_bit_t duty_resolution;
+  ledc_timer_t timer_num;
+  uint32_t freq_hz;
+  ledc_clk_cfg_t clk_cfg;
+} ledc_timer_config_t;
+
+namespace host {
+
+struct LedcChannel {
+  uint32_t duty{0};
+  uint32_t pending_duty{0};
+};
+
+inline std::array<uint32_t, LEDC_TIMER_MAX> g_ledc_freq_hz{};
+inline std::array<LedcChannel, LEDC_CHANNEL_MAX> g_ledc_channels{};
+
+}  // namespace host
+
+inline esp_err_t ledc_timer_config(const ledc_timer_config_t* config) {
+  if (config->timer_num >= LEDC_TIMER_MAX) return ESP_ERR_INVALID_ARG;
+  host::g_ledc_freq_hz[config->timer_num] = config->freq_hz;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_set_freq(ledc_mode_t, ledc_timer_t timer, uint32_t freq_hz) {
+  if (timer >= LEDC_TIMER_MAX) return ESP_ERR_INVALID_ARG;
+  host::g_ledc_freq_hz[timer] = freq_hz;
+  return ESP_OK;
+}
+
+// The duty takes effect on ledc_update_duty(), as on the device.
+inline esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t channel, uint32_t duty) {
+  if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  host::g_ledc_channels[channel].pending_duty = duty;
+  return ESP_OK;
+}
+
+inline esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t channel) {
+  if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  host::g_ledc_channels[channel].duty = host::g_ledc_channels[channel].pending_duty;
+  return ESP_OK;
+}
@@ -0,0 +1,6 @@
+// Host stub of the ESP-IDF section attributes.  Host memory survives a simulated restart anyway.
+#pragma once
+
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
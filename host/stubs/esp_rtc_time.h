@@ -0,0 +1,8 @@
+// Host stub of the ESP-IDF RTC timer, which keeps counting across simulated restarts.
+#pragma once
+
+#include <cstdint>
+
+#include "host_clock.h"
+
+inline uint64_t esp_rtc_get_time_us() { return static_cast<uint64_t>(host::g_rtc_offset_us + host::g_time_us); }
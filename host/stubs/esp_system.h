@@ -0,0 +1,22 @@
+// Host stub of the ESP-IDF reset reason.  Tests set host::g_reset_reason before a simulated boot.
+#pragma once
+
+typedef enum {
+  ESP_RST_UNKNOWN,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+namespace host {
+inline esp_reset_reason_t g_reset_reason{ESP_RST_POWERON};
+}  // namespace host
+
+inline esp_reset_reason_t esp_reset_reason() { return host::g_reset_reason; }
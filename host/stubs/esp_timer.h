@@ -0,0 +1,63 @@
+// Host stub of the ESP-IDF high resolution timer, driven by the host clock.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "host_clock.h"
+
+typedef esp_timer* esp_timer_handle_t;
+
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+  void (*callback)(void* arg);
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+inline int64_t esp_timer_get_time() { return host::now_us(); }
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  auto* timer = new esp_timer{};
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->name = args->name ? args->name : "";
+  host::timers().push_back(timer);
+  *out = timer;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  auto& list = host::timers();
+  list.erase(std::remove(list.begin(), list.end(), timer), list.end());
+  delete timer;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  if (timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->armed = true;
+  timer->period_us = 0;
+  timer->deadline_us = host::now_us() + static_cast<int64_t>(timeout_us);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  if (timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->armed = true;
+  timer->period_us = std::max<uint64_t>(period_us, 1);
+  timer->deadline_us = host::now_us() + static_cast<int64_t>(timer->period_us);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer->armed) return ESP_ERR_INVALID_STATE;
+  timer->armed = false;
+  return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t timer) { return timer->armed; }
@@ -0,0 +1,61 @@
+// HOST PRELUDE
+//
+// Stands in for the part of the main.cpp that ESPHome generates ahead of the Minuet headers: the
+// ESPHome includes, the namespace imports, and the global pointers to the components declared in
+// YAML.  Every test includes this file first, just like main.cpp includes esphome.h first.
+//
+// The components are plain objects that tests may inspect and modify.  Their types and initial
+// values match the declarations in the YAML packages.
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "esphome/components/climate/climate.h"
+#include "esphome/components/climate/climate_mode.h"
+#include "esphome/components/cover/cover.h"
+#include "esphome/components/fan/fan.h"
+#include "esphome/components/globals/globals_component.h"
+#include "esphome/components/mcf8316/mcf8316.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/switch/switch.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/components/thermostat/thermostat_climate.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+using namespace esphome;
+using namespace esphome::climate;
+using namespace esphome::cover;
+
+namespace host {
+
+// Bits of a default minuet::PersistentState: fan speed 1, exhaust.
+inline globals::RestoringGlobalsComponent<uint8_t> persistent_state_raw{0x22};
+inline globals::RestoringGlobalsComponent<std::array<uint32_t, 8>> thermostat_preset_configs_raw{};
+inline globals::RestoringGlobalsComponent<std::array<float, 4>> governor_thermal_model{};
+inline globals::RestoringGlobalsComponent<std::array<uint32_t, 32>> ir_remote_mappings{};
+inline globals::GlobalsComponent<bool (*)()> keypad_accessory_toggle{nullptr};
+inline globals::GlobalsComponent<bool (*)()> keypad_accessory_up{nullptr};
+inline globals::GlobalsComponent<bool (*)()> keypad_accessory_down{nullptr};
+inline switch_::Switch tone_enable{.state = true};  // RESTORE_DEFAULT_ON
+inline thermostat::ThermostatClimate thermostat{};
+inline fan::Fan fan{};
+inline cover::Cover lid{};
+inline mcf8316::MCF8316Component fan_driver{};
+
+}  // namespace host
+
+inline auto* minuet_persistent_state_raw = &host::persistent_state_raw;
+inline auto* minuet_thermostat_preset_configs_raw = &host::thermostat_preset_configs_raw;
+inline auto* minuet_governor_thermal_model = &host::governor_thermal_model;
+inline auto* minuet_ir_remote_mappings = &host::ir_remote_mappings;
+inline auto* minuet_keypad_accessory_toggle = &host::keypad_accessory_toggle;
+inline auto* minuet_keypad_accessory_up = &host::keypad_accessory_up;
+inline auto* minuet_keypad_accessory_down = &host::keypad_accessory_down;
+inline auto* minuet_tone_enable = &host::tone_enable;
+inline auto* minuet_thermostat = &host::thermostat;
+inline auto* minuet_fan = &host::fan;
+inline auto* minuet_lid = &host::lid;
+inline auto* minuet_fan_driver = &host::fan_driver;
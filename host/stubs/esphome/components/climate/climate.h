@@ -0,0 +1,59 @@
+// Host stub of the ESPHome climate device.
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "esphome/components/climate/climate_mode.h"
+
+namespace esphome {
+namespace climate {
+
+class Climate;
+
+class ClimateCall {
+public:
+  explicit ClimateCall(Climate* climate) : climate_(climate) {}
+
+  ClimateCall& set_preset(ClimatePreset preset) {
+    this->preset_ = preset;
+    return *this;
+  }
+  ClimateCall& set_preset(const std::string& custom_preset) {
+    this->custom_preset_ = custom_preset;
+    return *this;
+  }
+  void perform();
+
+private:
+  Climate* climate_;
+  std::optional<ClimatePreset> preset_;
+  std::optional<std::string> custom_preset_;
+};
+
+class Climate {
+public:
+  ClimateCall make_call() { return ClimateCall(this); }
+
+  ClimateMode mode{CLIMATE_MODE_OFF};
+  ClimateAction action{CLIMATE_ACTION_OFF};
+  std::optional<ClimateFanMode> fan_mode;
+  std::optional<ClimatePreset> preset;
+  std::optional<std::string> custom_preset;
+  float current_temperature{0.0f};
+  float target_temperature{0.0f};
+};
+
+inline void ClimateCall::perform() {
+  if (this->preset_) {
+    this->climate_->preset = this->preset_;
+    this->climate_->custom_preset.reset();
+  }
+  if (this->custom_preset_) {
+    this->climate_->custom_preset = this->custom_preset_;
+    this->climate_->preset.reset();
+  }
+}
+
+}  // namespace climate
+}  // namespace esphome
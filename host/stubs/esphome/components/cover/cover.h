@@ -0,0 +1,53 @@
+// Host stub of the ESPHome cover.
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace cover {
+
+inline const float COVER_OPEN = 1.0f;
+inline const float COVER_CLOSED = 0.0f;
+
+enum CoverOperation : uint8_t {
+  COVER_OPERATION_IDLE = 0,
+  COVER_OPERATION_OPENING,
+  COVER_OPERATION_CLOSING,
+};
+
+class Cover;
+
+class CoverCall {
+public:
+  explicit CoverCall(Cover* cover) : cover_(cover) {}
+
+  CoverCall& set_command_open() {
+    this->position_ = COVER_OPEN;
+    return *this;
+  }
+  CoverCall& set_command_close() {
+    this->position_ = COVER_CLOSED;
+    return *this;
+  }
+  void perform();
+
+private:
+  Cover* cover_;
+  float position_{-1.0f};
+};
+
+class Cover {
+public:
+  CoverCall make_call() { return CoverCall(this); }
+  bool is_fully_closed() const { return this->position == COVER_CLOSED; }
+
+  float position{COVER_CLOSED};
+  CoverOperation current_operation{COVER_OPERATION_IDLE};
+};
+
+inline void CoverCall::perform() {
+  if (this->position_ >= 0.0f) this->cover_->position = this->position_;
+}
+
+}  // namespace cover
+}  // namespace esphome
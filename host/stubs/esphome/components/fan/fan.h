@@ -0,0 +1,58 @@
+// Host stub of the ESPHome fan.
+#pragma once
+
+#include <algorithm>
+
+namespace esphome {
+namespace fan {
+
+enum class FanDirection { FORWARD = 0, REVERSE = 1 };
+
+class Fan;
+
+class FanCall {
+public:
+  explicit FanCall(Fan* fan) : fan_(fan) {}
+
+  FanCall& set_state(bool state) {
+    this->state_ = state ? 1 : 0;
+    return *this;
+  }
+  FanCall& set_speed(int speed) {
+    this->speed_ = speed;
+    return *this;
+  }
+  FanCall& set_direction(FanDirection direction) {
+    this->direction_ = static_cast<int>(direction);
+    return *this;
+  }
+  void perform();
+
+private:
+  Fan* fan_;
+  int state_{-1};
+  int speed_{-1};
+  int direction_{-1};
+};
+
+class Fan {
+public:
+  FanCall turn_on() { return FanCall(this).set_state(true); }
+  FanCall turn_off() { return FanCall(this).set_state(false); }
+  FanCall toggle() { return FanCall(this).set_state(!this->state); }
+  FanCall make_call() { return FanCall(this); }
+
+  bool state{false};
+  int speed{1};
+  FanDirection direction{FanDirection::FORWARD};
+  int speed_count{10};
+};
+
+inline void FanCall::perform() {
+  if (this->state_ >= 0) this->fan_->state = this->state_ != 0;
+  if (this->speed_ >= 0) this->fan_->speed = std::clamp(this->speed_, 1, this->fan_->speed_count);
+  if (this->direction_ >= 0) this->fan_->direction = static_cast<FanDirection>(this->direction_);
+}
+
+}  // namespace fan
+}  // namespace esphome
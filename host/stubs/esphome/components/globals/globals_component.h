@@ -0,0 +1,31 @@
+// Host stub of the ESPHome globals.
+#pragma once
+
+#include <utility>
+
+namespace esphome {
+namespace globals {
+
+template <typename T>
+class GlobalsComponent {
+public:
+  using value_type = T;
+
+  GlobalsComponent() = default;
+  explicit GlobalsComponent(T initial_value) : value_(std::move(initial_value)) {}
+
+  T& value() { return this->value_; }
+
+protected:
+  T value_{};
+};
+
+// Restoring globals are loaded from flash during setup at the HARDWARE priority.
+template <typename T>
+class RestoringGlobalsComponent : public GlobalsComponent<T> {
+public:
+  using GlobalsComponent<T>::GlobalsComponent;
+};
+
+}  // namespace globals
+}  // namespace esphome
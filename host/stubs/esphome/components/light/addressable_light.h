@@ -0,0 +1,135 @@
+// Host stub of the ESPHome addressable light with an in-memory pixel buffer.
+//
+// Writing a color to a pixel applies the pixel's color correction exactly as ESPHome does: each
+// channel is scaled by the channel's maximum brightness and by the light's brightness, then
+// looked up in the gamma table.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/light/light_state.h"
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace light {
+
+inline float gamma_correct(float value, float gamma) {
+  if (value <= 0.0f) return 0.0f;
+  if (gamma <= 0.0f) return value;
+  return std::pow(value, gamma);
+}
+
+class ESPColorCorrection {
+public:
+  void set_max_brightness(const Color& max_brightness) { this->max_brightness_ = max_brightness; }
+  void set_local_brightness(uint8_t local_brightness) { this->local_brightness_ = local_brightness; }
+  void calc_gamma_table(float gamma) {
+    for (unsigned i = 0; i < 256; i++) this->gamma_table_[i] = to_uint8_scale(gamma_correct(i / 255.0f, gamma));
+  }
+
+  uint8_t color_correct_red(uint8_t red) const {
+    return this->gamma_table_[esp_scale8(esp_scale8(red, this->max_brightness_.red), this->local_brightness_)];
+  }
+  uint8_t color_correct_green(uint8_t green) const {
+    return this->gamma_table_[esp_scale8(esp_scale8(green, this->max_brightness_.green), this->local_brightness_)];
+  }
+  uint8_t color_correct_blue(uint8_t blue) const {
+    return this->gamma_table_[esp_scale8(esp_scale8(blue, this->max_brightness_.blue), this->local_brightness_)];
+  }
+  uint8_t color_correct_white(uint8_t white) const {
+    return this->gamma_table_[esp_scale8(esp_scale8(white, this->max_brightness_.white), this->local_brightness_)];
+  }
+
+protected:
+  uint8_t gamma_table_[256]{};
+  Color max_brightness_{255, 255, 255, 255};
+  uint8_t local_brightness_{255};
+};
+
+class ESPColorView {
+public:
+  ESPColorView(uint8_t* red, uint8_t* green, uint8_t* blue, uint8_t* white, const ESPColorCorrection* color_correction)
+      : red_(red), green_(green), blue_(blue), white_(white), color_correction_(color_correction) {}
+
+  ESPColorView& operator=(const Color& color) {
+    this->set(color);
+    return *this;
+  }
+
+  void set(const Color& color) {
+    this->set_red(color.r);
+    this->set_green(color.g);
+    this->set_blue(color.b);
+    this->set_white(color.w);
+  }
+  void set_red(uint8_t red) { *this->red_ = this->color_correction_->color_correct_red(red); }
+  void set_green(uint8_t green) { *this->green_ = this->color_correction_->color_correct_green(green); }
+  void set_blue(uint8_t blue) { *this->blue_ = this->color_correction_->color_correct_blue(blue); }
+  void set_white(uint8_t white) { *this->white_ = this->color_correction_->color_correct_white(white); }
+
+  uint8_t get_red_raw() const { return *this->red_; }
+  uint8_t get_green_raw() const { return *this->green_; }
+  uint8_t get_blue_raw() const { return *this->blue_; }
+  uint8_t get_white_raw() const { return *this->white_; }
+
+  void raw_set_color_correction(const ESPColorCorrection* color_correction) {
+    this->color_correction_ = color_correction;
+  }
+
+private:
+  uint8_t* const red_;
+  uint8_t* const green_;
+  uint8_t* const blue_;
+  uint8_t* const white_;
+  const ESPColorCorrection* color_correction_;
+};
+
+class AddressableLight : public LightOutput {
+public:
+  AddressableLight(int32_t size, float gamma) : pixels_(static_cast<size_t>(size) * 4) {
+    this->correction_.calc_gamma_table(gamma);
+  }
+
+  int32_t size() const { return static_cast<int32_t>(this->pixels_.size() / 4); }
+
+  ESPColorView operator[](int32_t index) {
+    uint8_t* pixel = &this->pixels_[static_cast<size_t>(index) * 4];
+    return ESPColorView(pixel, pixel + 1, pixel + 2, pixel + 3, &this->correction_);
+  }
+
+  void set_correction(float red, float green, float blue, float white = 1.0f) {
+    this->correction_.set_max_brightness(
+        Color(to_uint8_scale(red), to_uint8_scale(green), to_uint8_scale(blue), to_uint8_scale(white)));
+  }
+
+  // Applies the brightness of the light and, without an effect, shows its color on every pixel.
+  void update_state(LightState* state) {
+    const LightColorValues& values = state->current_values;
+    this->correction_.set_local_brightness(to_uint8_scale(values.get_brightness() * values.get_state()));
+    if (this->effect_active_) return;
+    const Color color(to_uint8_scale(values.get_red()), to_uint8_scale(values.get_green()),
+                      to_uint8_scale(values.get_blue()), to_uint8_scale(values.get_white()));
+    for (int32_t i = 0; i < this->size(); i++) (*this)[i] = color;
+    this->schedule_show();
+  }
+
+  void schedule_show() { this->shows_++; }
+  uint32_t get_shows() const { return this->shows_; }
+
+  bool is_effect_active() const { return this->effect_active_; }
+  void set_effect_active(bool active) { this->effect_active_ = active; }
+
+  // Raw values of the pixel buffer, four channels per pixel.
+  const std::vector<uint8_t>& raw() const { return this->pixels_; }
+
+protected:
+  std::vector<uint8_t> pixels_;
+  ESPColorCorrection correction_;
+  bool effect_active_{false};
+  uint32_t shows_{0};
+};
+
+}  // namespace light
+}  // namespace esphome
@@ -0,0 +1,47 @@
+// Host stub of the ESPHome addressable light effect.
+#pragma once
+
+#include <string>
+
+#include "esphome/components/light/addressable_light.h"
+#include "esphome/components/light/light_state.h"
+#include "esphome/core/color.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace light {
+
+class AddressableLightEffect : public LightEffect {
+public:
+  explicit AddressableLightEffect(const std::string& name) : LightEffect(name) {}
+
+  void start_internal() override {
+    this->get_addressable_()->set_effect_active(true);
+    this->high_freq_.start();
+    this->start();
+  }
+
+  void stop() override {
+    this->get_addressable_()->set_effect_active(false);
+    this->high_freq_.stop();
+  }
+
+  virtual void apply(AddressableLight& it, const Color& current_color) = 0;
+
+  void apply() override {
+    AddressableLight* it = this->get_addressable_();
+    if (!it->is_effect_active()) return;
+    const LightColorValues& values = this->state_->remote_values;
+    const Color current_color(to_uint8_scale(values.get_red()), to_uint8_scale(values.get_green()),
+                              to_uint8_scale(values.get_blue()), to_uint8_scale(values.get_white()));
+    this->apply(*it, current_color);
+  }
+
+protected:
+  AddressableLight* get_addressable_() const { return static_cast<AddressableLight*>(this->state_->get_output()); }
+
+  HighFrequencyLoopRequester high_freq_;
+};
+
+}  // namespace light
+}  // namespace esphome
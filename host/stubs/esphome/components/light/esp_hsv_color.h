@@ -0,0 +1,39 @@
+// Host stub of the ESPHome HSV color.
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace light {
+
+struct ESPHSVColor {
+  uint8_t hue;
+  uint8_t saturation;
+  uint8_t value;
+
+  constexpr ESPHSVColor(uint8_t hue, uint8_t saturation, uint8_t value)
+      : hue(hue), saturation(saturation), value(value) {}
+
+  // Six-sector conversion, close enough to ESPHome's rainbow mapping for host tests.
+  Color to_rgb() const {
+    const unsigned sector = this->hue * 6u / 256u;
+    const unsigned offset = this->hue * 6u % 256u;
+    const uint8_t v = this->value;
+    const uint8_t p = v * (255u - this->saturation) / 255u;
+    const uint8_t q = v * (255u - this->saturation * offset / 255u) / 255u;
+    const uint8_t t = v * (255u - this->saturation * (255u - offset) / 255u) / 255u;
+    switch (sector) {
+      case 0: return Color(v, t, p);
+      case 1: return Color(q, v, p);
+      case 2: return Color(p, v, t);
+      case 3: return Color(p, q, v);
+      case 4: return Color(t, p, v);
+      default: return Color(v, p, q);
+    }
+  }
+};
+
+}  // namespace light
+}  // namespace esphome
@@ -0,0 +1,91 @@
+// Host stub of the ESPHome light state and effects.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace light {
+
+inline uint8_t to_uint8_scale(float x) {
+  return static_cast<uint8_t>(x <= 0.0f ? 0.0f : x >= 1.0f ? 255.0f : x * 255.0f + 0.5f);
+}
+
+class LightColorValues {
+public:
+  float get_state() const { return this->state_; }
+  float get_brightness() const { return this->brightness_; }
+  float get_red() const { return this->red_; }
+  float get_green() const { return this->green_; }
+  float get_blue() const { return this->blue_; }
+  float get_white() const { return this->white_; }
+  bool is_on() const { return this->state_ != 0.0f; }
+
+  void set_state(bool state) { this->state_ = state ? 1.0f : 0.0f; }
+  void set_brightness(float brightness) { this->brightness_ = brightness; }
+  void set_rgbw(float red, float green, float blue, float white) {
+    this->red_ = red;
+    this->green_ = green;
+    this->blue_ = blue;
+    this->white_ = white;
+  }
+
+private:
+  float state_{0.0f};
+  float brightness_{1.0f};
+  float red_{1.0f}, green_{1.0f}, blue_{1.0f}, white_{1.0f};
+};
+
+class LightOutput {
+public:
+  virtual ~LightOutput() = default;
+};
+
+class LightState;
+
+class LightEffect {
+public:
+  explicit LightEffect(std::string name) : name_(std::move(name)) {}
+  virtual ~LightEffect() = default;
+
+  virtual void start() {}
+  virtual void start_internal() { this->start(); }
+  virtual void stop() {}
+  virtual void apply() = 0;
+  virtual void init() {}
+
+  void init_internal(LightState* state) {
+    this->state_ = state;
+    this->init();
+  }
+
+  const std::string& get_name() const { return this->name_; }
+
+protected:
+  LightState* state_{nullptr};
+  std::string name_;
+};
+
+class LightState {
+public:
+  explicit LightState(LightOutput* output) : output_(output) {}
+
+  LightOutput* get_output() const { return this->output_; }
+  void add_effects(const std::vector<LightEffect*>& effects) {
+    this->effects_.insert(this->effects_.end(), effects.begin(), effects.end());
+  }
+  const std::vector<LightEffect*>& get_effects() const { return this->effects_; }
+
+  LightColorValues current_values;
+  LightColorValues remote_values;
+
+private:
+  LightOutput* output_;
+  std::vector<LightEffect*> effects_;
+};
+
+}  // namespace light
+}  // namespace esphome
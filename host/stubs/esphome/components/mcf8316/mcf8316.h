@@ -0,0 +1,582 @@
+// Host stub of the MCF8316 motor driver component: an emulator of the chip behind the component's
+// interface.
+//
+// The emulator keeps the chip's configuration registers with their EEPROM, the control and status
+// registers, and the nSLEEP and nFAULT pins on the GPIO expander.  Every operation of the component
+// goes through the I2C transactions that reach them, which are counted at this boundary, so tests
+// can measure the bus traffic of the fan driver code and inject bus errors and chip faults.  The
+// fan motor is a host::MotorModel that runs on the host clock.
+//
+// A new instance stands for the component just after setup, with the chip awake and its
+// configuration registers as loaded from the EEPROM.
+//
+// The configuration fields are packed into the 24 EEPROM registers by topic.  Their widths cover
+// the values the fan driver writes, but the bit positions don't follow the datasheet.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "esphome/components/mcf8316/motor_model.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include "host_clock.h"
+
+namespace esphome {
+namespace mcf8316 {
+
+// Register codes for the settings that the fan driver names
+enum class IPDClockFrequency : unsigned { FREQ_50_HZ = 0, FREQ_100_HZ, FREQ_250_HZ, FREQ_500_HZ, FREQ_1000_HZ };
+enum class IPDCurrentThreshold : unsigned { THR_0_25_A = 0, THR_0_5_A, THR_0_75_A, THR_1_0_A, THR_1_25_A, THR_1_5_A };
+enum class CurrentLimit : unsigned {
+  LIMIT_0_125_A = 0, LIMIT_0_25_A, LIMIT_0_5_A, LIMIT_1_0_A, LIMIT_1_5_A, LIMIT_2_0_A, LIMIT_2_5_A, LIMIT_3_0_A,
+  LIMIT_3_5_A, LIMIT_4_0_A, LIMIT_4_5_A, LIMIT_5_0_A, LIMIT_5_5_A, LIMIT_6_0_A, LIMIT_7_0_A, LIMIT_8_0_A,
+};
+enum class OpenLoopAcceleration : unsigned { ACCEL_0_01_HZ_S = 0, ACCEL_0_05_HZ_S, ACCEL_1_0_HZ_S, ACCEL_2_5_HZ_S };
+enum class ClosedLoopSlowAcceleration : unsigned { ACCEL_0_1_HZ_S = 0, ACCEL_1_0_HZ_S, ACCEL_2_0_HZ_S, ACCEL_3_0_HZ_S };
+enum class ClosedLoopAcceleration : unsigned {
+  ACCEL_0_5_HZ_S = 0, ACCEL_1_0_HZ_S, ACCEL_2_5_HZ_S, ACCEL_5_0_HZ_S, ACCEL_7_5_HZ_S, ACCEL_10_0_HZ_S, ACCEL_20_0_HZ_S,
+};
+enum class ClosedLoopDeceleration : unsigned { ACCEL_0_5_HZ_S = 0, ACCEL_NO_LIMIT = 31 };
+
+// Configuration fields
+enum Field : uint8_t {
+  // ISD_CONFIG
+  ISD_EN, BRAKE_EN, HIZ_EN, RESYNC_EN, FW_DRV_RESYN_THR, STAT_DETECT_THR, ISD_BEMF_FILT_ENABLE, ISD_STOP_TIME,
+  ISD_RUN_TIME, ISD_TIMEOUT, BRAKE_CURRENT_PERSIST, FAST_ISD_EN,
+  // REV_DRIVE_CONFIG
+  DIR_CHANGE_MODE, RVS_DR_EN,
+  // MOTOR_STARTUP1
+  MTR_STARTUP, ALIGN_SLOW_RAMP_RATE, IPD_CLK_FREQ, IPD_CURR_THR, IPD_RLS_MODE, IPD_ADV_ANGLE, IPD_REPEAT, OL_ILIMIT,
+  // MOTOR_STARTUP2
+  OL_ACC_A1, OL_ACC_A2, AUTO_HANDOFF_EN, OPN_CL_HANDOFF_THR, FIRST_CYCLE_FREQ_SEL, THETA_ERROR_RAMP_RATE,
+  // CLOSED_LOOP1
+  OVERMODULATION_ENABLE, CL_ACC, CL_DEC, PWM_FREQ_OUT, PWM_MODE, FG_SEL, FG_CONFIG, DEADTIME_COMP_EN,
+  LOW_SPEED_RECIRC_BRAKE_EN, AVS_EN,
+  // CLOSED_LOOP2
+  MTR_STOP, MTR_STOP_BRK_TIME, LEAD_ANGLE, MOTOR_RES,
+  // CLOSED_LOOP3
+  MOTOR_IND, MOTOR_BEMF_CONST, CL_SLOW_ACC,
+  // CLOSED_LOOP4
+  SPD_LOOP_KP, SPD_LOOP_KI, FLUX_WEAK_ENABLE,
+  // FAULT_CONFIG1
+  ILIMIT, HW_LOCK_ILIMIT, LOCK_ILIMIT, LOCK_ILIMIT_MODE, LOCK_ILIMIT_DEG, LCK_RETRY, MTR_LCK_MODE,
+  // FAULT_CONFIG2
+  LOCK1_EN, LOCK2_EN, LOCK3_EN, LOCK_ABN_SPEED, ABNORMAL_BEMF_THR, NO_MTR_THR, HW_LOCK_ILIMIT_MODE,
+  HW_LOCK_ILIMIT_DEG, MIN_VM_MOTOR, MIN_VM_MODE, MAX_VM_MOTOR, MAX_VM_MODE, AUTO_RETRY_TIMES,
+  // SPEED_PROFILES1, SPEED_PROFILES2
+  REF_PROFILE_CONFIG, DUTY_CLAMP1, DUTY_HYS, MIN_DUTY, REF_CLAMP1,
+  // INT_ALGO_1
+  ABNORMAL_BEMF_PERSISTENT_TIME, AUTO_HANDOFF_MIN_BEMF, BRAKE_SPEED_THRESHOLD, IQ_RAMP_EN, ACTIVE_BRAKE_EN,
+  NO_MTR_FLT_CLOSEDLOOP_DIS, IPD_HIGH_RESOLUTION_EN, IPD_TIMEOUT_FAULT_EN, IPD_FREQ_FAULT_EN, VDC_FILTER,
+  // INT_ALGO_2
+  CIRCULAR_CURRENT_LIMIT_ENABLE, SPEED_PIN_GLITCH_FILTER, INPUT_REFERENCE_WINDOW, DYNAMIC_CSA_GAIN_EN,
+  DYNAMIC_VOLTAGE_GAIN_EN,
+  // PIN_CONFIG
+  BRAKE_PIN_MODE, BRK_CONFIG, BRK_MODE, BRK_CURR_THR, BRK_TIME, ALARM_PIN_EN, BRAKE_INPUT,
+  // DEVICE_CONFIG1
+  PULLUP_ENABLE, BUS_VOLT, SLEW_RATE_I2C_PINS, EEP_FAULT_MODE, EEPROM_LOCK_MODE, CRC_ERR_MODE,
+  // DEVICE_CONFIG2
+  MAX_SPEED, EXT_CLK_EN, BUS_POWER_LIMIT_ENABLE,
+  // PERI_CONFIG1
+  MAX_POWER, SPREAD_SPECTRUM_MODULATION_DIS, PWM_DITHER_MODE, PWM_DITHER_DEPTH, VOLTAGE_HYSTERESIS,
+  SATURATION_FLAGS_EN, FG_DIV, DIR_INPUT,
+  // GD_CONFIG1
+  SLEW_RATE, OVP_SEL, OVP_EN, OTW_REP, OCP_DEG, OCP_LVL, OCP_MODE, MIN_ON_TIME,
+  // GD_CONFIG2
+  BUCK_DIS, BUCK_PS_DIS, BUCK_SEL, BUCK_CL,
+  FIELD_COUNT
+};
+
+struct FieldInfo {
+  uint8_t reg;    // index of the EEPROM register, at address 0x80 + 2 * reg
+  uint8_t shift;
+  uint8_t width;
+};
+
+constexpr size_t CONFIG_REGISTERS = 24;
+constexpr uint16_t CONFIG_ADDRESS = 0x80;
+
+// Field widths in the order of Field, with the index of the register that holds them.  The fields
+// of a register are packed from bit 0 up in order; bit 31 is left for parity.
+constexpr std::array<FieldInfo, FIELD_COUNT> FIELDS = [] {
+  constexpr uint8_t LAYOUT[][2] = {
+    {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 4}, {0, 3}, {0, 1}, {0, 2}, {0, 2}, {0, 2}, {0, 2}, {0, 1},
+    {1, 1}, {1, 1},
+    {2, 2}, {2, 4}, {2, 3}, {2, 5}, {2, 1}, {2, 2}, {2, 2}, {2, 4},
+    {3, 4}, {3, 4}, {3, 1}, {3, 5}, {3, 1}, {3, 3},
+    {4, 1}, {4, 5}, {4, 5}, {4, 4}, {4, 1}, {4, 2}, {4, 1}, {4, 1}, {4, 1}, {4, 1},
+    {5, 3}, {5, 4}, {5, 5}, {5, 8},
+    {6, 8}, {6, 8}, {6, 4},
+    {7, 10}, {7, 10}, {7, 1},
+    {8, 4}, {8, 4}, {8, 4}, {8, 4}, {8, 4}, {8, 4}, {8, 4},
+    {9, 1}, {9, 1}, {9, 1}, {9, 3}, {9, 3}, {9, 3}, {9, 4}, {9, 3}, {9, 3}, {9, 1}, {9, 3}, {9, 1}, {9, 3},
+    {10, 2}, {10, 8}, {10, 2}, {10, 4}, {11, 8},
+    {16, 2}, {16, 3}, {16, 4}, {16, 1}, {16, 1}, {16, 1}, {16, 1}, {16, 1}, {16, 1}, {16, 2},
+    {17, 1}, {17, 2}, {17, 2}, {17, 1}, {17, 1},
+    {18, 1}, {18, 1}, {18, 3}, {18, 3}, {18, 4}, {18, 1}, {18, 2},
+    {19, 1}, {19, 2}, {19, 2}, {19, 1}, {19, 2}, {19, 1},
+    {20, 14}, {20, 1}, {20, 1},
+    {21, 11}, {21, 1}, {21, 2}, {21, 2}, {21, 2}, {21, 1}, {21, 4}, {21, 2},
+    {22, 2}, {22, 5}, {22, 1}, {22, 1}, {22, 2}, {22, 1}, {22, 2}, {22, 3},
+    {23, 1}, {23, 1}, {23, 2}, {23, 1},
+  };
+  static_assert(sizeof(LAYOUT) / sizeof(LAYOUT[0]) == FIELD_COUNT, "every field needs a layout");
+  std::array<FieldInfo, FIELD_COUNT> fields{};
+  std::array<uint8_t, CONFIG_REGISTERS> used{};
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    const uint8_t reg = LAYOUT[i][0], width = LAYOUT[i][1];
+    fields[i] = {reg, used[reg], width};
+    used[reg] += width;
+  }
+  for (uint8_t bits : used) {
+    if (bits > 31) throw "register overflow";
+  }
+  return fields;
+}();
+
+// The values of the configuration fields, as written to the configuration registers.
+class Config {
+public:
+  template <typename T>
+  void set(Field field, T value) {
+    const FieldInfo& info = FIELDS[field];
+    const uint32_t raw = static_cast<uint32_t>(value);
+    const uint32_t mask = (1u << info.width) - 1;
+    if (raw > mask) this->overflow_ = true;
+    uint32_t& reg = this->regs_[info.reg];
+    reg = (reg & ~(mask << info.shift)) | ((raw & mask) << info.shift);
+  }
+
+  uint32_t get(Field field) const {
+    const FieldInfo& info = FIELDS[field];
+    return (this->regs_[info.reg] >> info.shift) & ((1u << info.width) - 1);
+  }
+
+  // True if the speed loop has no motor parameters, which are then left for MPET to measure.
+  bool needs_mpet_for_speed_loop() const {
+    return !this->get(MOTOR_RES) || !this->get(MOTOR_IND) || !this->get(MOTOR_BEMF_CONST) || !this->get(SPD_LOOP_KP)
+           || !this->get(SPD_LOOP_KI);
+  }
+
+  // True if a value was too wide for its field.
+  bool overflow() const { return this->overflow_; }
+
+  uint32_t& reg(size_t index) { return this->regs_[index]; }
+  uint32_t reg(size_t index) const { return this->regs_[index]; }
+
+  // Compares the register values.
+  bool operator==(const Config& other) const { return this->regs_ == other.regs_; }
+
+private:
+  std::array<uint32_t, CONFIG_REGISTERS> regs_{};
+  bool overflow_{false};
+};
+
+inline void log_config(const Config& config) {
+  for (size_t i = 0; i < CONFIG_REGISTERS; i++) {
+    ESP_LOGV("mcf8316", "Config register 0x%02X: 0x%08X", static_cast<unsigned>(CONFIG_ADDRESS + 2 * i),
+        static_cast<unsigned>(config.reg(i)));
+  }
+}
+
+constexpr unsigned fg_div_from_motor_poles(unsigned poles) { return poles / 2; }
+constexpr unsigned lead_angle_from_degrees(float degrees) { return static_cast<unsigned>(degrees / 0.12f + 0.5f); }
+constexpr float convert_speed_in_rotor_hz_to_electrical_hz(float hz, unsigned fg_div) { return hz * fg_div; }
+constexpr unsigned max_power_from_watts(float watts) { return static_cast<unsigned>(watts * 4.0f); }
+
+// Control and status registers
+constexpr uint16_t GATE_DRIVER_FAULT_STATUS = 0xE0;
+constexpr uint16_t CONTROLLER_FAULT_STATUS = 0xE2;
+constexpr uint16_t ALGO_STATUS_MPET = 0xE8;
+constexpr uint16_t DEV_CTRL = 0xEA;
+constexpr uint16_t ALGO_CTRL1 = 0xEC;  // digital speed input
+constexpr uint16_t ALGO_CTRL2 = 0xEE;  // MPET commands
+constexpr uint16_t SPEED_FDBK = 0x19C;
+constexpr uint16_t BUS_CURRENT = 0x410;
+constexpr uint16_t PHASE_CURRENT_PEAK = 0x43C;
+constexpr uint16_t VM_VOLTAGE = 0x478;
+
+// DEV_CTRL commands
+constexpr uint32_t DEV_CTRL_EEPROM_WRITE = 0x8A500000;
+constexpr uint32_t DEV_CTRL_CLR_FLT = 1u << 29;
+
+// Faults that can be injected into the emulated chip
+enum class Fault : uint8_t {
+  MOTOR_LOCK,        // controller fault, the motor coasts
+  OVERCURRENT,       // gate driver fault, the motor coasts
+  MPET_BEMF,         // controller fault raised by MPET
+};
+
+class MCF8316Component {
+public:
+  enum ErrorCode : uint8_t { ERROR_NONE = 0, ERROR_I2C, ERROR_TIMEOUT };
+
+  static const char* error_name(ErrorCode error) {
+    switch (error) {
+      case ERROR_NONE: return "none";
+      case ERROR_I2C: return "I2C error";
+      case ERROR_TIMEOUT: return "timeout";
+    }
+    return "unknown";
+  }
+
+  // Bus traffic of the component
+  struct Transactions {
+    uint32_t reads{0};
+    uint32_t writes{0};
+    uint32_t expander_reads{0};
+    uint32_t expander_writes{0};
+    uint32_t errors{0};
+
+    uint32_t total() const { return this->reads + this->writes + this->expander_reads + this->expander_writes; }
+  };
+
+  static constexpr uint32_t POLL_INTERVAL_MS = 100;     // nFAULT polling by loop()
+  static constexpr uint32_t EEPROM_WRITE_MS = 300;      // time for the EEPROM to program
+  static constexpr uint32_t EEPROM_POLL_MS = 100;
+  static constexpr uint32_t MPET_DURATION_MS = 8000;
+
+  host::MotorModel motor{};
+
+  // --- Component interface -----------------------------------------------------------------
+
+  Config make_default_config() const { return Config{}; }
+  const Config& config_shadow() const { return this->shadow_; }
+
+  ErrorCode write_config(const Config& config) {
+    this->update_();
+    for (size_t i = 0; i < CONFIG_REGISTERS; i++) {
+      if (const ErrorCode error = this->write_(CONFIG_ADDRESS + 2 * i, config.reg(i))) return error;
+      this->shadow_.reg(i) = config.reg(i);
+    }
+    this->shadow_ = config;  // with its overflow flag
+    return ERROR_NONE;
+  }
+
+  // Programs the EEPROM from the configuration registers and waits for it to finish.
+  ErrorCode save_config_to_eeprom() {
+    this->update_();
+    if (const ErrorCode error = this->write_(DEV_CTRL, DEV_CTRL_EEPROM_WRITE)) return error;
+    for (uint32_t waited_ms = 0;; waited_ms += EEPROM_POLL_MS) {
+      host::advance_ms(EEPROM_POLL_MS);
+      uint32_t status = 0;
+      if (const ErrorCode error = this->read_(DEV_CTRL, status)) return error;
+      if (!status) return ERROR_NONE;
+      if (waited_ms > 10 * EEPROM_WRITE_MS) return ERROR_TIMEOUT;
+    }
+  }
+
+  ErrorCode write_speed_input(float speed_in_rotor_hz) {
+    this->update_();
+    const float max_rotor_hz = this->max_rotor_hz_();
+    const float fraction = max_rotor_hz > 0.0f ? std::clamp(speed_in_rotor_hz / max_rotor_hz, 0.0f, 1.0f) : 0.0f;
+    return this->write_(ALGO_CTRL1, static_cast<uint32_t>(std::lround(fraction * 32767.0f)));
+  }
+
+  ErrorCode write_direction_input_config(bool counter_clockwise) {
+    return this->write_field_(DIR_INPUT, counter_clockwise ? 2u : 1u);
+  }
+
+  ErrorCode write_brake_input_config(bool brake) { return this->write_field_(BRAKE_INPUT, brake ? 1u : 2u); }
+
+  ErrorCode read_speed_feedback(float* speed_in_rotor_hz) {
+    uint32_t raw = 0;
+    if (const ErrorCode error = this->read_(SPEED_FDBK, raw)) return error;
+    *speed_in_rotor_hz = static_cast<int32_t>(raw) / 1000.0f;
+    return ERROR_NONE;
+  }
+
+  ErrorCode read_bus_current(float* current_in_amps) { return this->read_milli_(BUS_CURRENT, current_in_amps); }
+  ErrorCode read_motor_phase_peak_current(float* current_in_amps) {
+    return this->read_milli_(PHASE_CURRENT_PEAK, current_in_amps);
+  }
+  ErrorCode read_vm_voltage(float* voltage_in_volts) { return this->read_milli_(VM_VOLTAGE, voltage_in_volts); }
+
+  // Drives nSLEEP through the GPIO expander.  The pin stays as it was if the expander write fails.
+  void wake() {
+    this->update_();
+    if (this->awake_) return;
+    if (this->expander_write_()) return;
+    this->awake_ = true;
+  }
+
+  void sleep() {
+    this->update_();
+    if (!this->awake_) return;
+    if (this->expander_write_()) return;
+    this->awake_ = false;
+    // Sleeping clears the control registers but not the configuration registers
+    this->speed_input_ = 0;
+    this->mpet_running_ = false;
+  }
+
+  bool is_awake() const { return this->awake_; }
+
+  // The nFAULT state as of the last poll by loop().
+  bool is_faulted() const { return this->fault_seen_; }
+
+  ErrorCode clear_fault() {
+    this->update_();
+    if (const ErrorCode error = this->write_(DEV_CTRL, DEV_CTRL_CLR_FLT)) return error;
+    if (this->fault_clears_needed_ > 1) {
+      this->fault_clears_needed_--;
+    } else {
+      this->gate_driver_fault_ = this->controller_fault_ = 0;
+      this->fault_clears_needed_ = 0;
+      this->fault_seen_ = false;
+    }
+    return ERROR_NONE;
+  }
+
+  // Starts the motor parameter extraction tool.  With `write_shadow`, loop() copies the measured
+  // parameters into the configuration shadow when it finishes.
+  ErrorCode start_mpet(bool write_shadow) {
+    this->update_();
+    if (const ErrorCode error = this->write_(ALGO_CTRL2, 0xF)) return error;
+    this->mpet_write_shadow_ = write_shadow;
+    return ERROR_NONE;
+  }
+
+  // The component's loop: polls nFAULT, reads the fault status when it asserts, and follows MPET.
+  void loop() {
+    this->update_();
+    const uint32_t now_ms = esphome::millis();
+    if (now_ms - this->last_poll_ms_ < POLL_INTERVAL_MS) return;
+    this->last_poll_ms_ = now_ms;
+    if (this->expander_read_()) return;
+    const bool nfault = this->awake_ && (this->gate_driver_fault_ || this->controller_fault_);
+    if (nfault && !this->fault_seen_) {
+      uint32_t status;
+      this->read_(GATE_DRIVER_FAULT_STATUS, status);
+      this->read_(CONTROLLER_FAULT_STATUS, status);
+    }
+    this->fault_seen_ = nfault;
+    if (this->mpet_polling_) {
+      uint32_t status = 0;
+      if (this->read_(ALGO_STATUS_MPET, status) || status) return;
+      this->mpet_polling_ = false;
+      if (this->mpet_write_shadow_ && !this->controller_fault_) {
+        // Read back the configuration registers that hold the measured parameters
+        for (Field field : {MOTOR_RES, MOTOR_IND, SPD_LOOP_KP}) {
+          const size_t reg = FIELDS[field].reg;
+          if (this->read_(CONFIG_ADDRESS + 2 * reg, this->shadow_.reg(reg))) return;
+        }
+      }
+    }
+  }
+
+  // --- Emulation -----------------------------------------------------------------------------
+
+  const Transactions& transactions() const { return this->transactions_; }
+  void reset_transactions() { this->transactions_ = {}; }
+
+  // Makes `count` transactions fail after the next `skip` ones succeed, including those with the
+  // GPIO expander.
+  void inject_bus_errors(unsigned count, unsigned skip = 0) {
+    this->bus_errors_ = count;
+    this->bus_errors_skip_ = skip;
+  }
+
+  // Raises a fault that takes `clears` writes of CLR_FLT to clear.
+  void inject_fault(Fault fault, unsigned clears = 1) {
+    this->update_();
+    if (fault == Fault::OVERCURRENT) {
+      this->gate_driver_fault_ |= 1u << static_cast<unsigned>(fault);
+    } else {
+      this->controller_fault_ |= 1u << static_cast<unsigned>(fault);
+    }
+    this->fault_clears_needed_ = std::max(this->fault_clears_needed_, clears);
+  }
+
+  bool fault_active() const { return this->gate_driver_fault_ || this->controller_fault_; }
+  bool driving() const { return this->awake_ && !this->fault_active() && (this->speed_input_ || this->mpet_running_); }
+  bool braking() const { return this->awake_ && this->ram_.get(BRAKE_INPUT) == 1; }
+  bool mpet_running() const { return this->mpet_running_; }
+
+  // The configuration that the chip runs with, and the one it loads at power on.
+  const Config& ram() const { return this->ram_; }
+  const Config& eeprom() const { return this->eeprom_; }
+  uint32_t eeprom_writes() const { return this->eeprom_writes_; }
+
+  // Removes and restores power: the configuration reloads from the EEPROM, the faults clear, and the
+  // component sets up again.
+  void power_cycle() {
+    this->update_();
+    this->ram_ = this->shadow_ = this->eeprom_;
+    this->awake_ = true;
+    this->speed_input_ = 0;
+    this->gate_driver_fault_ = this->controller_fault_ = 0;
+    this->fault_clears_needed_ = 0;
+    this->fault_seen_ = false;
+    this->mpet_running_ = this->mpet_polling_ = false;
+    this->eeprom_busy_until_ms_ = 0;
+  }
+
+  // The rotor speed that the speed input asks for, signed by the direction input.
+  float target_rotor_hz() const {
+    const float hz = this->speed_input_ / 32767.0f * this->max_rotor_hz_();
+    return this->ram_.get(DIR_INPUT) == 2 ? -hz : hz;
+  }
+
+private:
+  float max_rotor_hz_() const {
+    const uint32_t fg_div = this->ram_.get(FG_DIV);
+    return fg_div ? this->ram_.get(MAX_SPEED) / 6.0f / fg_div : 0.0f;
+  }
+
+  // Runs the motor and the chip's timers up to the host clock.
+  void update_() {
+    const int64_t now_us = host::now_us();
+    while (this->last_us_ < now_us) {
+      const int64_t step_us = std::min<int64_t>(now_us - this->last_us_, 10000);
+      this->last_us_ += step_us;
+      const float dt_s = step_us * 1e-6f;
+
+      float target_hz = this->target_rotor_hz();
+      if (this->mpet_running_) {
+        target_hz = this->max_rotor_hz_() * 0.25f;
+        this->mpet_elapsed_ms_ += step_us / 1000.0f;
+        if (this->mpet_elapsed_ms_ >= MPET_DURATION_MS) this->finish_mpet_();
+      }
+      // Without motor parameters the speed loop can't commutate and the motor locks
+      if (this->driving() && !this->mpet_running_ && this->ram_.needs_mpet_for_speed_loop()) {
+        this->controller_fault_ |= 1u << static_cast<unsigned>(Fault::MOTOR_LOCK);
+        this->fault_clears_needed_ = std::max(this->fault_clears_needed_, 1u);
+      }
+      this->motor.step(dt_s, target_hz, this->driving(), this->braking());
+    }
+  }
+
+  void finish_mpet_() {
+    this->mpet_running_ = false;
+    if (this->fault_active()) return;
+    if (std::fabs(this->motor.speed_hz) < this->max_rotor_hz_() * 0.1f) {
+      this->controller_fault_ |= 1u << static_cast<unsigned>(Fault::MPET_BEMF);
+      this->fault_clears_needed_ = std::max(this->fault_clears_needed_, 1u);
+      return;
+    }
+    this->ram_.set(MOTOR_RES, this->motor.motor_res);
+    this->ram_.set(MOTOR_IND, this->motor.motor_ind);
+    this->ram_.set(MOTOR_BEMF_CONST, this->motor.motor_bemf_const);
+    this->ram_.set(SPD_LOOP_KP, this->motor.spd_loop_kp);
+    this->ram_.set(SPD_LOOP_KI, this->motor.spd_loop_ki);
+  }
+
+  // One register transaction.  An asleep chip doesn't acknowledge its address.
+  ErrorCode transfer_(bool write, uint16_t address, uint32_t& value) {
+    (write ? this->transactions_.writes : this->transactions_.reads)++;
+    if (this->bus_error_()) return ERROR_I2C;
+    if (!this->awake_) {
+      this->transactions_.errors++;
+      return ERROR_I2C;
+    }
+    if (write) {
+      this->write_register_(address, value);
+    } else {
+      value = this->read_register_(address);
+    }
+    return ERROR_NONE;
+  }
+
+  ErrorCode write_(uint16_t address, uint32_t value) { return this->transfer_(true, address, value); }
+  ErrorCode read_(uint16_t address, uint32_t& value) { return this->transfer_(false, address, value); }
+
+  ErrorCode read_milli_(uint16_t address, float* value) {
+    this->update_();
+    uint32_t raw = 0;
+    if (const ErrorCode error = this->read_(address, raw)) return error;
+    *value = raw / 1000.0f;
+    return ERROR_NONE;
+  }
+
+  // Writes a field through the configuration shadow, so the rest of its register is unchanged.
+  ErrorCode write_field_(Field field, uint32_t value) {
+    this->update_();
+    Config config = this->shadow_;
+    config.set(field, value);
+    const size_t reg = FIELDS[field].reg;
+    if (const ErrorCode error = this->write_(CONFIG_ADDRESS + 2 * reg, config.reg(reg))) return error;
+    this->shadow_.reg(reg) = config.reg(reg);
+    return ERROR_NONE;
+  }
+
+  ErrorCode expander_(uint32_t& counter) {
+    counter++;
+    return this->bus_error_() ? ERROR_I2C : ERROR_NONE;
+  }
+
+  bool bus_error_() {
+    if (this->bus_errors_skip_) {
+      this->bus_errors_skip_--;
+      return false;
+    }
+    if (!this->bus_errors_) return false;
+    this->bus_errors_--;
+    this->transactions_.errors++;
+    return true;
+  }
+  ErrorCode expander_write_() { return this->expander_(this->transactions_.expander_writes); }
+  ErrorCode expander_read_() { return this->expander_(this->transactions_.expander_reads); }
+
+  void write_register_(uint16_t address, uint32_t value) {
+    if (address >= CONFIG_ADDRESS && address < CONFIG_ADDRESS + 2 * CONFIG_REGISTERS && address % 2 == 0) {
+      this->ram_.reg((address - CONFIG_ADDRESS) / 2) = value;
+    } else if (address == DEV_CTRL && value == DEV_CTRL_EEPROM_WRITE) {
+      this->eeprom_ = this->ram_;
+      this->eeprom_writes_++;
+      this->eeprom_busy_until_ms_ = esphome::millis() + EEPROM_WRITE_MS;
+    } else if (address == ALGO_CTRL1) {
+      this->speed_input_ = value & 0x7FFF;
+    } else if (address == ALGO_CTRL2 && !this->fault_active()) {
+      this->mpet_running_ = this->mpet_polling_ = true;
+      this->mpet_elapsed_ms_ = 0.0f;
+    }
+  }
+
+  uint32_t read_register_(uint16_t address) const {
+    const auto milli = [](float value) { return static_cast<uint32_t>(std::lround(std::max(value, 0.0f) * 1000.0f)); };
+    const bool driven = this->driving();
+    switch (address) {
+      case GATE_DRIVER_FAULT_STATUS: return this->gate_driver_fault_;
+      case CONTROLLER_FAULT_STATUS: return this->controller_fault_;
+      case ALGO_STATUS_MPET: return this->mpet_running_ ? 1 : 0;
+      case DEV_CTRL: return esphome::millis() < this->eeprom_busy_until_ms_ ? 1 : 0;
+      case ALGO_CTRL1: return this->speed_input_;
+      case SPEED_FDBK: return static_cast<uint32_t>(static_cast<int32_t>(std::lround(std::fabs(this->motor.speed_hz) * 1000.0f)));
+      case BUS_CURRENT: return milli(this->motor.bus_current_a(driven));
+      case PHASE_CURRENT_PEAK: return milli(this->motor.phase_peak_current_a(driven));
+      case VM_VOLTAGE: return milli(this->motor.vm_voltage(driven));
+    }
+    if (address >= CONFIG_ADDRESS && address < CONFIG_ADDRESS + 2 * CONFIG_REGISTERS) {
+      return this->ram_.reg((address - CONFIG_ADDRESS) / 2);
+    }
+    return 0;
+  }
+
+  Config shadow_{};
+  Config ram_{};
+  Config eeprom_{};
+  uint32_t eeprom_writes_{0};
+  uint32_t eeprom_busy_until_ms_{0};
+  bool awake_{true};  // set up by the component
+  uint32_t speed_input_{0};
+  uint32_t gate_driver_fault_{0};
+  uint32_t controller_fault_{0};
+  unsigned fault_clears_needed_{0};
+  bool fault_seen_{false};
+  uint32_t last_poll_ms_{0};
+  bool mpet_running_{false};
+  bool mpet_polling_{false};
+  bool mpet_write_shadow_{false};
+  float mpet_elapsed_ms_{0.0f};
+  unsigned bus_errors_{0};
+  unsigned bus_errors_skip_{0};
+  int64_t last_us_{host::now_us()};
+  Transactions transactions_{};
+};
+
+}  // namespace mcf8316
+}  // namespace esphome
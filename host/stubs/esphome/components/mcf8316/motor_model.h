@@ -0,0 +1,66 @@
+// HOST FAN MOTOR MODEL
+//
+// A first-order model of the fan motor as seen through the MCF8316 speed loop, used by the MCF8316
+// emulator.  The speed approaches the speed reference with the loop's time constant while the
+// motor is driven, decays with the rotor's inertia against the air while it coasts, and decays
+// faster while braked.  The currents follow the fan's cube law for power.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace host {
+
+struct MotorModel {
+  // Dynamics
+  float drive_time_constant_s{1.5f};
+  float coast_time_constant_s{8.0f};
+  float brake_time_constant_s{1.0f};
+  float max_accel_hz_per_s{20.0f};  // rotor Hz per second while driven
+
+  // Electrical
+  float vm_volts{12.6f};
+  float supply_resistance_ohms{0.05f};
+  float idle_bus_current_a{0.02f};
+  float rated_speed_hz{20.0f};      // 1200 rpm
+  float rated_bus_current_a{1.6f};  // at the rated speed
+  float phase_to_bus_current{1.8f};
+
+  // The parameters that the motor parameter extraction tool (MPET) measures, as register codes
+  unsigned motor_res{74};
+  unsigned motor_ind{98};
+  unsigned motor_bemf_const{103};
+  unsigned spd_loop_kp{115};
+  unsigned spd_loop_ki{293};
+
+  // State: rotor speed in Hz, positive clockwise
+  float speed_hz{0.0f};
+
+  // Advances by `dt_s` toward `target_hz` if driven, otherwise coasting or braking to a stop.
+  void step(float dt_s, float target_hz, bool driven, bool brake) {
+    if (driven) {
+      const float step_hz = (target_hz - this->speed_hz) * (1.0f - std::exp(-dt_s / this->drive_time_constant_s));
+      const float limit_hz = this->max_accel_hz_per_s * dt_s;
+      this->speed_hz += std::clamp(step_hz, -limit_hz, limit_hz);
+    } else {
+      const float tau = brake ? this->brake_time_constant_s : this->coast_time_constant_s;
+      this->speed_hz *= std::exp(-dt_s / tau);
+      if (std::fabs(this->speed_hz) < 0.05f) this->speed_hz = 0.0f;
+    }
+  }
+
+  // Current drawn from the supply while driven.
+  float bus_current_a(bool driven) const {
+    if (!driven) return 0.0f;
+    const float load = std::fabs(this->speed_hz) / this->rated_speed_hz;
+    return this->idle_bus_current_a + this->rated_bus_current_a * load * load * load;
+  }
+
+  float phase_peak_current_a(bool driven) const { return this->bus_current_a(driven) * this->phase_to_bus_current; }
+
+  float vm_voltage(bool driven) const {
+    return this->vm_volts - this->bus_current_a(driven) * this->supply_resistance_ohms;
+  }
+};
+
+}  // namespace host
@@ -0,0 +1,21 @@
+// Host stub of the ESPHome NEC infrared protocol data.
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace remote_base {
+
+struct NECData {
+  uint16_t address;
+  uint16_t command;
+  uint16_t command_repeats;
+
+  bool operator==(const NECData& rhs) const {
+    return this->address == rhs.address && this->command == rhs.command
+           && this->command_repeats == rhs.command_repeats;
+  }
+};
+
+}  // namespace remote_base
+}  // namespace esphome
@@ -0,0 +1,15 @@
+// Host stub of the ESPHome switch.
+#pragma once
+
+namespace esphome {
+namespace switch_ {
+
+class Switch {
+public:
+  void publish_state(bool state) { this->state = state; }
+
+  bool state{false};
+};
+
+}  // namespace switch_
+}  // namespace esphome
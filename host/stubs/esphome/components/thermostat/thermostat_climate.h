@@ -0,0 +1,38 @@
+// Host stub of the ESPHome thermostat.
+#pragma once
+
+#include <map>
+
+#include "esphome/components/climate/climate.h"
+#include "esphome/components/sensor/sensor.h"
+
+namespace esphome {
+namespace thermostat {
+
+struct ThermostatClimateTargetTempConfig {
+  ThermostatClimateTargetTempConfig() = default;
+  explicit ThermostatClimateTargetTempConfig(float default_temperature) : default_temperature(default_temperature) {}
+
+  void set_mode(climate::ClimateMode mode) { this->mode_ = mode; }
+  void set_fan_mode(climate::ClimateFanMode fan_mode) { this->fan_mode_ = fan_mode; }
+
+  float default_temperature{NAN};
+  std::optional<climate::ClimateMode> mode_;
+  std::optional<climate::ClimateFanMode> fan_mode_;
+};
+
+class ThermostatClimate : public climate::Climate {
+public:
+  void set_preset_config(climate::ClimatePreset preset, const ThermostatClimateTargetTempConfig& config) {
+    this->preset_config[preset] = config;
+  }
+  void set_sensor(sensor::Sensor* sensor) { this->sensor = sensor; }
+  void set_humidity_sensor(sensor::Sensor* sensor) { this->humidity_sensor = sensor; }
+
+  std::map<climate::ClimatePreset, ThermostatClimateTargetTempConfig> preset_config;
+  sensor::Sensor* sensor{nullptr};
+  sensor::Sensor* humidity_sensor{nullptr};
+};
+
+}  // namespace thermostat
+}  // namespace esphome
@@ -0,0 +1,58 @@
+// Host stub of the ESPHome color type.
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+inline uint8_t esp_scale8(uint8_t i, uint8_t scale) { return (uint16_t(i) * (1 + uint16_t(scale))) / 256; }
+
+struct Color {
+  union {
+    struct {
+      union {
+        uint8_t r;
+        uint8_t red;
+      };
+      union {
+        uint8_t g;
+        uint8_t green;
+      };
+      union {
+        uint8_t b;
+        uint8_t blue;
+      };
+      union {
+        uint8_t w;
+        uint8_t white;
+      };
+    };
+    uint8_t raw[4];
+    uint32_t raw_32;
+  };
+
+  constexpr Color() : raw_32(0) {}
+  constexpr Color(uint8_t red, uint8_t green, uint8_t blue, uint8_t white = 0) : r(red), g(green), b(blue), w(white) {}
+
+  bool operator==(const Color& rhs) const { return this->raw_32 == rhs.raw_32; }
+  bool operator!=(const Color& rhs) const { return this->raw_32 != rhs.raw_32; }
+
+  Color operator*(uint8_t scale) const {
+    return Color(esp_scale8(this->r, scale), esp_scale8(this->g, scale), esp_scale8(this->b, scale),
+                 esp_scale8(this->w, scale));
+  }
+
+  Color gradient(const Color& to_color, uint8_t amnt) const {
+    const float amnt_f = float(amnt) / 255.0f;
+    return Color(uint8_t(amnt_f * (to_color.r - this->r) + this->r), uint8_t(amnt_f * (to_color.g - this->g) + this->g),
+                 uint8_t(amnt_f * (to_color.b - this->b) + this->b), uint8_t(amnt_f * (to_color.w - this->w) + this->w));
+  }
+
+  static const Color BLACK;
+  static const Color WHITE;
+};
+
+inline const Color Color::BLACK(0, 0, 0, 0);
+inline const Color Color::WHITE(255, 255, 255, 255);
+
+}  // namespace esphome
@@ -0,0 +1,22 @@
+// Host stub of the ESPHome entity base.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+class EntityBase {
+public:
+  explicit EntityBase(std::string object_id = "") : object_id_(std::move(object_id)) {}
+
+  const std::string& get_object_id() const { return this->object_id_; }
+  uint32_t get_object_id_hash() const { return fnv1_hash(this->object_id_); }
+
+protected:
+  std::string object_id_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,13 @@
+// Host stub of the ESPHome clock, driven by the host clock.
+#pragma once
+
+#include <cstdint>
+
+#include "host_clock.h"
+
+namespace esphome {
+
+inline uint32_t millis() { return static_cast<uint32_t>(host::now_us() / 1000); }
+inline uint32_t micros() { return static_cast<uint32_t>(host::now_us()); }
+
+}  // namespace esphome
@@ -0,0 +1,66 @@
+// Host stub of the ESPHome helpers used by the Minuet headers.
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace esphome {
+
+// The 32-bit FNV-1 hash that ESPHome uses for object ids.
+inline uint32_t fnv1_hash(const std::string& str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+__attribute__((format(printf, 1, 2)))
+inline std::string str_sprintf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int length = std::vsnprintf(nullptr, 0, format, args);
+  va_end(args);
+  std::string text(length > 0 ? length : 0, '\0');
+  va_start(args, format);
+  std::vsnprintf(text.data(), text.size() + 1, format, args);
+  va_end(args);
+  return text;
+}
+
+// Seeded identically on every run so that tests are reproducible.
+inline uint32_t random_uint32() {
+  static std::mt19937 generator{0x4d696e75};
+  return generator();
+}
+
+inline float random_float() { return static_cast<float>(random_uint32()) / 4294967296.0f; }
+
+// Requests that the main loop runs as fast as possible.  The host has no main loop so this only
+// keeps count of the requests.
+class HighFrequencyLoopRequester {
+public:
+  void start() {
+    if (!this->started_) requests()++;
+    this->started_ = true;
+  }
+  void stop() {
+    if (this->started_) requests()--;
+    this->started_ = false;
+  }
+  bool is_started() const { return this->started_; }
+  static bool is_high_frequency() { return requests() > 0; }
+
+private:
+  static int& requests() {
+    static int count = 0;
+    return count;
+  }
+  bool started_{false};
+};
+
+}  // namespace esphome
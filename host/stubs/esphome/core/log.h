@@ -0,0 +1,43 @@
+// Host stub of the ESPHome logger.  Messages at or above host::g_log_level go to stderr; nothing is
+// logged by default so that tests and benchmarks stay quiet.
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "esphome/core/helpers.h"
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+
+namespace host {
+inline int g_log_level{ESPHOME_LOG_LEVEL_NONE};
+}  // namespace host
+
+namespace esphome {
+
+__attribute__((format(printf, 3, 4)))
+inline void esp_log_printf_(int level, const char* tag, const char* format, ...) {
+  if (level > host::g_log_level) return;
+  static constexpr char LETTERS[] = "-EWICDV";
+  std::fprintf(stderr, "[%c][%s] ", LETTERS[level], tag);
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+}
+
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
@@ -0,0 +1,59 @@
+// Host stub of the ESPHome preferences, backed by memory.  host::preferences() holds the stored
+// records by key so that tests can seed them or simulate an erased flash.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace host {
+
+inline std::map<uint32_t, std::vector<uint8_t>>& preferences() {
+  static std::map<uint32_t, std::vector<uint8_t>> records;
+  return records;
+}
+
+}  // namespace host
+
+namespace esphome {
+
+class ESPPreferenceObject {
+public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key), valid_(true) {}
+
+  template <typename T>
+  bool save(const T* src) {
+    if (!this->valid_) return false;
+    const auto* bytes = reinterpret_cast<const uint8_t*>(src);
+    host::preferences()[this->key_].assign(bytes, bytes + sizeof(T));
+    return true;
+  }
+
+  template <typename T>
+  bool load(T* dest) {
+    if (!this->valid_) return false;
+    const auto it = host::preferences().find(this->key_);
+    if (it == host::preferences().end() || it->second.size() != sizeof(T)) return false;
+    std::memcpy(dest, it->second.data(), sizeof(T));
+    return true;
+  }
+
+private:
+  uint32_t key_{0};
+  bool valid_{false};
+};
+
+class ESPPreferences {
+public:
+  template <typename T>
+  ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return ESPPreferenceObject(type);
+  }
+};
+
+inline ESPPreferences host_preferences{};
+inline ESPPreferences* global_preferences = &host_preferences;
+
+}  // namespace esphome
@@ -0,0 +1,73 @@
+// HOST CLOCK
+//
+// Virtual time behind the stubbed ESPHome and ESP-IDF clocks.  Nothing advances it except the
+// test, so every run is deterministic.  One-shot and periodic esp_timers fire as the clock passes
+// their deadlines, optionally late by a latency that the test supplies to model dispatch jitter.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct esp_timer {
+  void (*callback)(void*){nullptr};
+  void* arg{nullptr};
+  const char* name{""};
+  bool armed{false};
+  int64_t deadline_us{0};
+  uint64_t period_us{0};  // 0 for one-shot
+};
+
+namespace host {
+
+inline int64_t g_time_us{0};
+
+// Offset of the RTC timer from the virtual clock.  The RTC timer keeps counting across software
+// resets while the clock restarts from zero, see restart().
+inline int64_t g_rtc_offset_us{0};
+
+// Delay between a timer's deadline and its callback running.  Defaults to none.
+inline std::function<int64_t()> g_timer_latency_us{};
+
+inline std::vector<esp_timer*>& timers() {
+  static std::vector<esp_timer*> list;
+  return list;
+}
+
+inline int64_t now_us() { return g_time_us; }
+
+// Advances the clock to `time_us`, running the callbacks of the timers that fall due on the way
+// in the order of their deadlines.
+inline void advance_to_us(int64_t time_us) {
+  for (;;) {
+    esp_timer* next = nullptr;
+    for (esp_timer* timer : timers()) {
+      if (timer->armed && timer->deadline_us <= time_us && (!next || timer->deadline_us < next->deadline_us)) {
+        next = timer;
+      }
+    }
+    if (!next) break;
+    const int64_t latency = g_timer_latency_us ? std::max<int64_t>(g_timer_latency_us(), 0) : 0;
+    g_time_us = std::max(g_time_us, next->deadline_us + latency);
+    if (next->period_us) {
+      next->deadline_us += static_cast<int64_t>(next->period_us);
+    } else {
+      next->armed = false;
+    }
+    next->callback(next->arg);
+  }
+  g_time_us = std::max(g_time_us, time_us);
+}
+
+inline void advance_us(int64_t delta_us) { advance_to_us(g_time_us + delta_us); }
+inline void advance_ms(int64_t delta_ms) { advance_us(delta_ms * 1000); }
+
+// Simulates a software reset: the clock restarts from zero while the RTC timer keeps counting.
+inline void restart() {
+  g_rtc_offset_us += g_time_us;
+  g_time_us = 0;
+  for (esp_timer* timer : timers()) timer->armed = false;
+}
+
+}  // namespace host
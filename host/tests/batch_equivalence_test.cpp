@@ -0,0 +1,166 @@
+// Checks decide_batch() against update() lane by lane and benchmarks its throughput.
+//
+// Each lane must get exactly the level, lid and latches that update() produces for the same
+// readings from a freshly reset governor whose latches hold the lane's state, with the
+// proportional thermal mode and strategy and LidMode::AUTO.
+#include "esphome.h"
+
+#include "governor.h"
+#include "test.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+struct Lanes {
+  std::vector<float> Tin, Tout, RHi, RHo, CO2, target;
+  std::vector<uint8_t> fan_mode, cooling, co2_active, rh_active, level, lid;
+
+  explicit Lanes(size_t n)
+      : Tin(n), Tout(n), RHi(n), RHo(n), CO2(n), target(n), fan_mode(n), cooling(n), co2_active(n), rh_active(n),
+        level(n), lid(n) {}
+
+  size_t size() const { return this->Tin.size(); }
+
+  void decide() {
+    governor::decide_batch(
+        {this->Tin.data(), this->Tout.data(), this->RHi.data(), this->RHo.data(), this->CO2.data(),
+         this->target.data(), this->fan_mode.data(), this->cooling.data()},
+        {this->co2_active.data(), this->rh_active.data()}, {this->level.data(), this->lid.data()}, this->size());
+  }
+};
+
+// Random readings around the thresholds, with missing readings, values out of range, and values
+// exactly on the hysteresis bounds.
+Lanes make_lanes(size_t n, uint32_t seed) {
+  std::mt19937 random(seed);
+  const auto uniform = [&](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(random); };
+  const auto maybe = [&](float value) { return random() % 20 == 0 ? NAN : value; };
+  const governor::GovernorConfig& c = governor::g_config;
+  const float co2_bounds[] = {c.co2_target_ppm, c.co2_target_ppm - c.co2_deadband_ppm,
+                              c.co2_target_ppm + c.co2_deadband_ppm, -10.0f, 6000.0f};
+  const float rh_bounds[] = {c.rh_target_pct, c.rh_target_pct - c.rh_deadband_pct,
+                             c.rh_target_pct + c.rh_deadband_pct, -5.0f, 120.0f};
+  static constexpr ClimateFanMode FAN_MODES[] = {
+    ClimateFanMode::CLIMATE_FAN_ON, ClimateFanMode::CLIMATE_FAN_OFF, ClimateFanMode::CLIMATE_FAN_AUTO,
+    ClimateFanMode::CLIMATE_FAN_LOW, ClimateFanMode::CLIMATE_FAN_MEDIUM, ClimateFanMode::CLIMATE_FAN_HIGH,
+    ClimateFanMode::CLIMATE_FAN_QUIET,
+  };
+
+  Lanes lanes(n);
+  for (size_t k = 0; k < n; k++) {
+    lanes.Tin[k] = maybe(uniform(10.0f, 45.0f));
+    lanes.Tout[k] = maybe(random() % 50 == 0 ? uniform(-60.0f, 100.0f) : uniform(5.0f, 40.0f));
+    lanes.RHi[k] = maybe(random() % 8 == 0 ? rh_bounds[random() % 5] : uniform(20.0f, 95.0f));
+    lanes.RHo[k] = maybe(uniform(10.0f, 100.0f));
+    lanes.CO2[k] = maybe(random() % 8 == 0 ? co2_bounds[random() % 5] : uniform(400.0f, 2500.0f));
+    lanes.target[k] = random() % 100 == 0 ? NAN : std::round(uniform(16.0f, 30.0f) * 2.0f) / 2.0f;
+    lanes.fan_mode[k] = static_cast<uint8_t>(FAN_MODES[random() % std::size(FAN_MODES)]);
+    lanes.cooling[k] = random() % 2;
+    lanes.co2_active[k] = random() % 2;
+    lanes.rh_active[k] = random() % 2;
+  }
+  return lanes;
+}
+
+// The scalar decision for one lane, from a freshly reset governor fed with the lane's readings.
+governor::ControlOutput decide_lane(const Lanes& lanes, size_t k, bool& co2_active, bool& rh_active) {
+  governor::reset();
+  const uint32_t now_ms = esphome::millis();
+  const auto feed = [&](governor::SensorChannel& channel, float value) {
+    channel.clear();
+    channel.push(value, now_ms);
+  };
+  feed(governor::g_channel_Tin, lanes.Tin[k]);
+  feed(governor::g_channel_Tout, lanes.Tout[k]);
+  feed(governor::g_channel_RHi, lanes.RHi[k]);
+  feed(governor::g_channel_RHo, lanes.RHo[k]);
+  feed(governor::g_channel_CO2, lanes.CO2[k]);
+  governor::g_state.co2_active = co2_active;
+  governor::g_state.rh_active = rh_active;
+
+  const governor::ControlInput input{
+    .ambient_temperature = lanes.Tin[k],
+    .target_temperature = lanes.target[k],
+    .action = lanes.cooling[k] ? ClimateAction::CLIMATE_ACTION_COOLING : ClimateAction::CLIMATE_ACTION_IDLE,
+    .fan_mode = static_cast<ClimateFanMode>(lanes.fan_mode[k]),
+    .lid_mode = minuet::LidMode::AUTO,
+  };
+  const governor::ControlOutput output = governor::update(input);
+  co2_active = governor::g_state.co2_active;
+  rh_active = governor::g_state.rh_active;
+  return output;
+}
+
+unsigned compare(const char* name, size_t n, uint32_t seed) {
+  Lanes lanes = make_lanes(n, seed);
+  const Lanes before = lanes;
+  lanes.decide();
+
+  unsigned mismatches = 0;
+  for (size_t k = 0; k < n; k++) {
+    bool co2_active = before.co2_active[k];
+    bool rh_active = before.rh_active[k];
+    const governor::ControlOutput output = decide_lane(before, k, co2_active, rh_active);
+    const bool same = output.fan_speed == lanes.level[k] && output.lid_open == (lanes.lid[k] != 0)
+                      && co2_active == (lanes.co2_active[k] != 0) && rh_active == (lanes.rh_active[k] != 0);
+    if (!same && mismatches++ < 5) {
+      std::printf("  lane %zu: Tin=%g Tout=%g RHi=%g RHo=%g CO2=%g target=%g fan_mode=%u cooling=%u: "
+                  "update %d/%d/%d/%d, batch %u/%u/%u/%u\n",
+          k, before.Tin[k], before.Tout[k], before.RHi[k], before.RHo[k], before.CO2[k], before.target[k],
+          before.fan_mode[k], before.cooling[k], output.fan_speed, output.lid_open, co2_active, rh_active,
+          lanes.level[k], lanes.lid[k], lanes.co2_active[k], lanes.rh_active[k]);
+    }
+  }
+  std::printf("%s: %zu lanes, %u mismatches\n", name, n, mismatches);
+  return mismatches;
+}
+
+void test_equivalence() {
+  CHECK(compare("defaults", 100000, 72) == 0);
+
+  // A configuration away from the defaults, with the quiet cap in play
+  governor::set_config({.span_auto_c = 3.0f, .gamma_auto = 1.7f, .gamma_quiet = 0.8f, .co2_target_ppm = 900.0f,
+                        .co2_deadband_ppm = 40.0f, .co2_gamma = 0.6f, .rh_target_pct = 55.0f, .rh_gamma = 2.0f,
+                        .max_level_quiet = 4});
+  CHECK(compare("tuned", 100000, 720) == 0);
+
+  governor::g_enable_co2_control = false;
+  governor::g_enable_rh_control = false;
+  CHECK(compare("CO2 and RH disabled", 20000, 7200) == 0);
+  governor::g_enable_co2_control = governor::kEnableCO2Control;
+  governor::g_enable_rh_control = governor::kEnableRHControl;
+  governor::set_config({});
+}
+
+void benchmark() {
+  constexpr size_t LANES = 1 << 20;
+  Lanes lanes = make_lanes(LANES, 7272);
+  const double batch_ns = test::time_ns(10, [&] {
+    lanes.decide();
+    test::keep(lanes.level[LANES - 1]);
+  });
+
+  constexpr size_t SCALAR_LANES = 1 << 16;
+  const double scalar_ns = test::time_ns(1, [&] {
+    for (size_t k = 0; k < SCALAR_LANES; k++) {
+      bool co2_active = lanes.co2_active[k];
+      bool rh_active = lanes.rh_active[k];
+      test::keep(decide_lane(lanes, k, co2_active, rh_active).fan_speed);
+    }
+  });
+  std::printf("decide_batch %.1f M lanes/s, update() from a reset governor %.2f M lanes/s\n",
+      LANES / batch_ns * 1e3, SCALAR_LANES / scalar_ns * 1e3);
+}
+
+}  // namespace
+
+int main() {
+  test_equivalence();
+  benchmark();
+  return test::result();
+}
@@ -0,0 +1,136 @@
+// Simulates the blade freeze effect running in a main loop with irregular iterations and checks
+// the phase error of its flashes against the true angle of the rotor.
+//
+// The blades appear to stand still when every flash happens at the same rotor angle modulo the
+// blade spacing, so the error of a flash is the distance from that angle, wrapped to half a blade
+// spacing either way.  The tachometer reading is exact here: the effect has no phase reference so
+// an error in the speed reading makes the blades appear to creep regardless of frame timing.
+#include "esphome.h"
+
+#include "accessory/light/addressable.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace minuet::accessory::light;
+using esphome::light::AddressableLight;
+using esphome::light::LightState;
+
+namespace {
+
+constexpr int32_t PIXELS = 57;
+constexpr unsigned BLADES = 10;
+constexpr float BLADE_SPACING_DEG = 360.f / BLADES;
+constexpr int64_t SPEED_UPDATE_US = 500000;  // the interval that reads the tachometer
+constexpr int64_t RUN_US = 20000000;
+
+struct Result {
+  unsigned flashes{0};
+  float mean_deg{0.f};
+  float p95_deg{0.f};
+  float max_deg{0.f};
+  float reported_mean_deg{0.f};
+};
+
+// Draws the time taken by one iteration of the main loop while it runs at high frequency:
+// mostly a millisecond or two with an occasional longer stall while another component works.
+int64_t loop_interval_us(std::mt19937& random, float stall_probability) {
+  std::uniform_int_distribution<int64_t> usual(300, 2500);
+  std::uniform_int_distribution<int64_t> stall(5000, 12000);
+  std::bernoulli_distribution stalled(stall_probability);
+  return stalled(random) ? stall(random) : usual(random);
+}
+
+Result simulate(LightState& light, AddressableLight& it, float rpm, float stall_probability) {
+  std::mt19937 random(static_cast<uint32_t>(rpm));
+  host::advance_us(1000000);
+  g_phase_stats = {};
+
+  const int64_t start_us = host::now_us();
+  const auto true_angle_deg = [&](int64_t now_us) { return double(rpm) / 60e6 * double(now_us - start_us) * 360.0; };
+
+  g_fan_sync.set_speed(rpm, true);
+  g_blade_freeze_effect.start_internal();
+  CHECK(g_fan_sync.is_active());
+
+  // The effect times its flashes from the angle of the rotor when it starts.
+  std::vector<float> errors;
+  bool lit = false;
+  int64_t next_speed_update_us = start_us + SPEED_UPDATE_US;
+  while (host::now_us() - start_us < RUN_US) {
+    host::advance_us(loop_interval_us(random, stall_probability));
+    if (host::now_us() >= next_speed_update_us) {
+      g_fan_sync.set_speed(rpm, true);
+      next_speed_update_us += SPEED_UPDATE_US;
+    }
+    static_cast<esphome::light::LightEffect&>(g_blade_freeze_effect).apply();
+
+    const bool now_lit = it.raw()[0] != 0;
+    if (now_lit && !lit) {
+      double error = std::fmod(true_angle_deg(host::now_us()), BLADE_SPACING_DEG);
+      if (error > BLADE_SPACING_DEG / 2) error -= BLADE_SPACING_DEG;
+      errors.push_back(float(std::fabs(error)));
+    }
+    lit = now_lit;
+  }
+  g_blade_freeze_effect.stop();
+  CHECK(!g_fan_sync.is_active());
+
+  Result result;
+  result.reported_mean_deg = g_phase_stats.take_mean_deg();
+  result.flashes = errors.size();
+  if (errors.empty()) return result;
+  for (float error : errors) result.mean_deg += error;
+  result.mean_deg /= errors.size();
+  std::sort(errors.begin(), errors.end());
+  result.p95_deg = errors[errors.size() * 95 / 100];
+  result.max_deg = errors.back();
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  AddressableLight it(PIXELS, 2.8f);
+  LightState light(&it);
+  light.current_values.set_state(true);
+  light.remote_values.set_state(true);
+  light.remote_values.set_rgbw(1.f, 1.f, 1.f, 0.f);
+  init_addressable(&light, {12.f, 12.f, 12.f, 12.f}, {1.f, 1.f, 1.f, 1.f}, 2.8f, PIXELS, BLADES);
+  g_channel_tables.update(g_power_limiter.get_max_brightness(), light.current_values);
+
+  std::printf("%6s %6s %8s %8s %8s %8s %10s\n", "rpm", "stalls", "flashes", "mean", "p95", "max", "reported");
+  for (float rpm : {200.f, 600.f, 1200.f}) {
+    for (float stall_probability : {0.f, 0.02f}) {
+      const Result result = simulate(light, it, rpm, stall_probability);
+      std::printf("%6.0f %5.0f%% %8u %7.2f° %7.2f° %7.2f° %9.2f°\n", rpm, stall_probability * 100.f, result.flashes,
+          result.mean_deg, result.p95_deg, result.max_deg, result.reported_mean_deg);
+
+      // The flash rate stays near the limit of the effect once several blades pass per flash.
+      const float blades_per_second = rpm / 60.f * BLADES;
+      const float flashes_per_second = blades_per_second / (int(blades_per_second / 40.f) + 1);
+      CHECK_NEAR(result.flashes, flashes_per_second * RUN_US / 1e6f, flashes_per_second);
+
+      // With regular frames every flash is within the rotation during the longest frame of the
+      // flash angle, and on average within a quarter of that.  The longest frame is 3.5 ms when a
+      // short iteration is skipped because frames are at least a millisecond apart.  The target
+      // for the mean is a sixth of the blade spacing even with stalls.
+      const float max_frame_deg = rpm / 60e6f * 3500.f * 360.f;
+      if (stall_probability == 0.f) {
+        CHECK(result.max_deg <= max_frame_deg);
+        CHECK(result.mean_deg <= max_frame_deg / 4);
+      }
+      CHECK(result.mean_deg <= BLADE_SPACING_DEG / 6);
+
+      // The effect reports the error that it measures against its own estimate of the angle,
+      // which is exact here.  Stalls longer than a blade spacing wrap differently in the
+      // simulation so only compare without them.
+      if (stall_probability == 0.f) CHECK_NEAR(result.reported_mean_deg, result.mean_deg, 0.1f);
+    }
+  }
+  return test::result();
+}
@@ -0,0 +1,169 @@
+// CABIN SIMULATION
+//
+// Closed-loop simulation of the governor against a synthetic cabin.  The sensors report into the
+// governor's channels, the thermostat switches between cooling and idle with the hysteresis that
+// core.yaml configures, and the governor runs once a second as the thermostat poll does.  The
+// level that the governor returns drives the cabin until the next update.
+#pragma once
+
+#include "esphome.h"
+
+#include "governor.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+namespace sim {
+
+namespace governor = minuet::governor;
+
+// The cabin, with rates per minute and L the applied level (0 while the lid is closed):
+//   dTin/dt = (a + b L) (Tout - Tin) + q
+//   dCO2/dt = G - (base + air_change L) (CO2 - outdoor)
+// The air changes default to what the governor assumes until its thermal model is trusted.  The
+// thermal coupling b is lower since the cabin's thermal mass takes longer to exchange than its air.
+struct Cabin {
+  float a{1.0f / 90.0f};  // leakage, 1/min
+  float b{0.005f};        // ventilation per level, 1/min
+  float q{0.1f};          // solar and occupant heat, °C/min
+  double Tin{30.0};
+  double CO2{450.0};
+  float air_change{governor::kModelInitialB};  // air changes per level, 1/min
+
+  void step(int level, float Tout, float generation, float dt_min) {
+    this->Tin += ((this->a + this->b * level) * (Tout - this->Tin) + this->q) * dt_min;
+    const float exchange = governor::kMpcAirChangeBaseMin + this->air_change * level;
+    this->CO2 += (generation - exchange * (this->CO2 - governor::kMpcOutdoorCO2PPM)) * dt_min;
+  }
+};
+
+// The thermostat action, with the cooling deadband and overrun from core.yaml.
+struct Thermostat {
+  float target{24.0f};
+  ClimateFanMode fan_mode{ClimateFanMode::CLIMATE_FAN_AUTO};
+  bool cooling{false};
+
+  static constexpr float DEADBAND_C = 0.5f;
+  static constexpr float OVERRUN_C = 1.0f;
+
+  void update(float Tin) {
+    if (!this->cooling && Tin > this->target + DEADBAND_C) this->cooling = true;
+    else if (this->cooling && Tin < this->target - OVERRUN_C) this->cooling = false;
+  }
+
+  governor::ControlInput input(float Tin) const {
+    return {
+      .ambient_temperature = Tin,
+      .target_temperature = this->target,
+      .action = this->cooling ? ClimateAction::CLIMATE_ACTION_COOLING : ClimateAction::CLIMATE_ACTION_IDLE,
+      .fan_mode = this->fan_mode,
+      .lid_mode = minuet::LidMode::AUTO,
+    };
+  }
+};
+
+// Outdoor conditions at a point in the run.
+struct Conditions {
+  float Tout{22.0f};
+  float generation{0.0f};    // CO2 ppm/min from the occupants
+  float co2_noise_ppm{0.0f};  // standard deviation of the CO2 sensor noise
+};
+
+// Closed-loop metrics.  Fan power follows the cube of its speed, so the energy is given in hours
+// at full speed.
+struct Metrics {
+  double hours{0};
+  double iae_ch{0};         // integral of |Tin - floor| while cooling, °C·h
+  double offset_c{0};       // mean Tin - floor over the last quarter while cooling
+  unsigned level_changes{0};
+  double energy_h{0};
+  double peak_co2{0};
+  double co2_excess_ppmh{0};  // integral of the CO2 above the target, ppm·h
+  int level{0};               // applied at the end of the run
+
+  double level_changes_per_hour() const { return this->hours ? this->level_changes / this->hours : 0; }
+};
+
+static constexpr uint32_t UPDATE_MS = 1000;        // the thermostat poll
+static constexpr uint32_t INDOOR_REPORT_MS = 5000;  // indoor temperature and CO2 sensors
+static constexpr uint32_t OUTDOOR_REPORT_MS = 60000;
+static constexpr int SUBSTEPS = 4;
+
+// Starts a run from a freshly reset governor with fresh sensor channels.
+inline void reset_governor() {
+  governor::reset();
+  governor::g_channel_Tin.clear();
+  governor::g_channel_Tout.clear();
+  governor::g_channel_RHi.clear();
+  governor::g_channel_RHo.clear();
+  governor::g_channel_CO2.clear();
+}
+
+// Runs the closed loop for the given hours.  `conditions(hours)` supplies the outdoor conditions,
+// `decide(input)` the output, which defaults to governor::update().
+template <typename ConditionsFn, typename DecideFn>
+Metrics run(Cabin& cabin, Thermostat& thermostat, double hours, ConditionsFn&& conditions, DecideFn&& decide,
+            bool with_co2 = true) {
+  Metrics metrics{};
+  metrics.hours = hours;
+  metrics.peak_co2 = cabin.CO2;
+  int level = 0;
+  int last_level = -1;
+  double offset_sum = 0;
+  double offset_time = 0;
+  std::mt19937 random(65);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+
+  const int64_t start_us = host::now_us();
+  const uint64_t updates = static_cast<uint64_t>(hours * 3600e3 / UPDATE_MS);
+  for (uint64_t i = 0; i < updates; i++) {
+    const double t_h = static_cast<double>(host::now_us() - start_us) / 3600e6;
+    const Conditions c = conditions(t_h);
+    const uint32_t now_ms = esphome::millis();
+    const uint64_t elapsed_ms = i * UPDATE_MS;
+
+    // Sensors quantize to 0.01 °C and 1 ppm
+    const float Tin = std::round(static_cast<float>(cabin.Tin) * 100.0f) / 100.0f;
+    if (elapsed_ms % INDOOR_REPORT_MS == 0) {
+      governor::g_channel_Tin.push(Tin, now_ms);
+      const float co2 = static_cast<float>(cabin.CO2) + c.co2_noise_ppm * noise(random);
+      if (with_co2) governor::g_channel_CO2.push(std::round(co2), now_ms);
+    }
+    if (elapsed_ms % OUTDOOR_REPORT_MS == 0) governor::g_channel_Tout.push(std::round(c.Tout * 100.0f) / 100.0f, now_ms);
+
+    thermostat.update(Tin);
+    const governor::ControlOutput output = decide(thermostat.input(Tin));
+    level = output.lid_open ? output.fan_speed : 0;
+    if (last_level >= 0 && level != last_level) metrics.level_changes++;
+    last_level = level;
+
+    const double dt_h = UPDATE_MS / 3600e3;
+    if (thermostat.cooling) {
+      const float floor_c = std::max(thermostat.target, c.Tout + governor::g_config.outside_margin_c);
+      metrics.iae_ch += std::fabs(cabin.Tin - floor_c) * dt_h;
+      if (t_h >= hours * 0.75) {
+        offset_sum += (cabin.Tin - floor_c) * dt_h;
+        offset_time += dt_h;
+      }
+    }
+    metrics.energy_h += std::pow(level / static_cast<double>(governor::kMaxLevel), 3) * dt_h;
+    metrics.co2_excess_ppmh += std::max(0.0, cabin.CO2 - governor::g_config.co2_target_ppm) * dt_h;
+    metrics.peak_co2 = std::max(metrics.peak_co2, cabin.CO2);
+
+    for (int s = 0; s < SUBSTEPS; s++) cabin.step(level, c.Tout, c.generation, UPDATE_MS / 60000.0f / SUBSTEPS);
+    host::advance_ms(UPDATE_MS);
+  }
+  metrics.offset_c = offset_time ? offset_sum / offset_time : NAN;
+  metrics.level = level;
+  return metrics;
+}
+
+template <typename ConditionsFn>
+Metrics run(Cabin& cabin, Thermostat& thermostat, double hours, ConditionsFn&& conditions, bool with_co2 = true) {
+  return run(cabin, thermostat, hours, conditions,
+             [](const governor::ControlInput& input) { return governor::update(input); }, with_co2);
+}
+
+}  // namespace sim
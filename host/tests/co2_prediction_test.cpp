@@ -0,0 +1,113 @@
+// Tests that the predictive strategy generates CO2 at the rate that the CO2 controller estimates,
+// and that the prediction then follows a cabin whose occupants differ from the default.
+#include "esphome.h"
+
+#include "governor.h"
+#include "test.h"
+
+#include <cstdio>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+constexpr uint32_t kTickMs = governor::kCO2PeriodMs;
+
+// The synthetic cabin, in ppm/min: dC/dt = G - (base + gain L) (C - outdoor).
+struct Cabin {
+  float generation;
+  double CO2;
+
+  void step(int level, float dt_min) {
+    const float exchange = governor::kMpcAirChangeBaseMin + governor::ventilation_gain() * level;
+    this->CO2 += (this->generation - exchange * (this->CO2 - governor::kMpcOutdoorCO2PPM)) * dt_min;
+  }
+};
+
+governor::SensorBundle bundle(const Cabin& cabin) {
+  governor::SensorBundle b{};
+  b.has_Tin = true;
+  b.Tin = b.Tin_f = 25.0f;
+  b.has_CO2 = true;
+  b.CO2 = b.CO2_f = float(cabin.CO2);
+  return b;
+}
+
+// Runs the CO2 controller against the cabin at a fixed level for the given number of minutes.
+void run(Cabin& cabin, int level, int minutes, uint32_t& t_ms) {
+  governor::g_state.model_level = level;
+  for (const uint32_t end_ms = t_ms + minutes * 60000u; t_ms < end_ms; t_ms += kTickMs) {
+    governor::determine_co2(bundle(cabin), governor::g_state, t_ms);
+    for (int i = 0; i < 10; i++) cabin.step(level, kTickMs / 60000.0f / 10);
+  }
+}
+
+void test_default_until_estimated() {
+  governor::reset();
+  CHECK(std::isnan(governor::g_state.co2_generation));
+  const Cabin cabin{0.0f, 800.0};
+  const governor::Prediction p = governor::predict(bundle(cabin), governor::g_state);
+
+  // Without an estimate the default generation holds the concentration up at low levels.
+  Cabin expected{governor::kMpcCO2GenerationPPMMin, cabin.CO2};
+  for (int i = 0; i < governor::kMpcHorizonMin * 10; i++) expected.step(1, 0.1f);
+  CHECK_NEAR(p.CO2[1], expected.CO2, 5.0f);
+}
+
+void test_follows_estimated_generation() {
+  for (float generation : {0.0f, 8.0f, 45.0f}) {
+    governor::reset();
+    Cabin cabin{generation, 600.0};
+    uint32_t t_ms = 0;
+    run(cabin, 2, 15, t_ms);
+    std::printf("generation %5.1f ppm/min: estimated %5.1f\n", generation, governor::g_state.co2_generation);
+    CHECK_NEAR(governor::g_state.co2_generation, generation, 1.0f + generation * 0.05f);
+
+    // Every candidate level is predicted within a few ppm of the cabin over the horizon.
+    const governor::Prediction p = governor::predict(bundle(cabin), governor::g_state);
+    for (int L = 0; L < governor::kMpcCandidates; L++) {
+      Cabin future = cabin;
+      for (int i = 0; i < governor::kMpcHorizonMin * 10; i++) future.step(L, 0.1f);
+      CHECK_NEAR(p.CO2[L], future.CO2, 5.0f + generation * 0.5f);
+    }
+  }
+}
+
+void test_clamps_estimate() {
+  governor::reset();
+  const Cabin cabin{0.0f, 800.0};
+  governor::g_state.co2_generation = 1000.0f;
+  const governor::Prediction high = governor::predict(bundle(cabin), governor::g_state);
+  governor::g_state.co2_generation = governor::kMpcCO2GenerationMaxPPMMin;
+  const governor::Prediction max = governor::predict(bundle(cabin), governor::g_state);
+  governor::g_state.co2_generation = -50.0f;
+  const governor::Prediction low = governor::predict(bundle(cabin), governor::g_state);
+  governor::g_state.co2_generation = 0.0f;
+  const governor::Prediction zero = governor::predict(bundle(cabin), governor::g_state);
+  for (int L = 0; L < governor::kMpcCandidates; L++) {
+    CHECK(high.CO2[L] == max.CO2[L]);
+    CHECK(low.CO2[L] == zero.CO2[L]);
+  }
+}
+
+void test_forgets_estimate_without_co2() {
+  governor::reset();
+  Cabin cabin{30.0f, 600.0};
+  uint32_t t_ms = 0;
+  run(cabin, 2, 10, t_ms);
+  CHECK(std::isfinite(governor::g_state.co2_generation));
+  governor::SensorBundle b = bundle(cabin);
+  b.has_CO2 = false;
+  governor::determine_co2(b, governor::g_state, t_ms);
+  CHECK(std::isnan(governor::g_state.co2_generation));
+}
+
+}  // namespace
+
+int main() {
+  test_default_until_estimated();
+  test_follows_estimated_generation();
+  test_clamps_estimate();
+  test_forgets_estimate_without_co2();
+  return test::result();
+}
@@ -0,0 +1,169 @@
+// Checks that the controller registry makes the same determinations as the hand-written dispatch
+// that it replaced, and benchmarks the cost of a tick of both.
+#include "esphome.h"
+
+#include "governor.h"
+#include "test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace governor = minuet::governor;
+using governor::ControlInput;
+using governor::Determination;
+using governor::GovernorState;
+using governor::SensorBundle;
+
+namespace {
+
+// The dispatch before the registry: each controller gated on its own inputs, then combined with
+// the tie broken in the order Thermal, CO2, RH.
+struct HandWrittenDispatch {
+  governor::ControllerCache<6> thermal_cache;
+  governor::ControllerCache<4> co2_cache;
+  governor::ControllerCache<4> rh_cache;
+  unsigned runs{0};
+
+  template <size_t N, typename F>
+  Determination run_gated(governor::ControllerCache<N>& cache, uint32_t period_ms,
+                          const std::array<float, N>& inputs, uint32_t now_ms, F&& determine) {
+    if (cache.valid && now_ms - cache.last_ms < period_ms
+        && std::memcmp(cache.inputs.data(), inputs.data(), sizeof(inputs)) == 0) {
+      return cache.determination;
+    }
+    this->runs++;
+    cache.inputs = inputs;
+    cache.determination = determine();
+    cache.last_ms = now_ms;
+    cache.valid = true;
+    return cache.determination;
+  }
+
+  governor::Combined tick(const ControlInput& input, const SensorBundle& b, GovernorState& st, uint32_t now_ms) {
+    const std::array<float, 6> thermal_inputs = {
+      b.has_Tin ? b.Tin_f : NAN, b.has_Tout ? b.Tout : NAN,
+      input.target_temperature, static_cast<float>(input.action),
+      static_cast<float>(input.fan_mode), static_cast<float>(governor::g_thermal_mode),
+    };
+    const Determination t = this->run_gated(this->thermal_cache, governor::kThermalPeriodMs, thermal_inputs, now_ms,
+        [&] { return governor::determine_thermal(input, b, st, now_ms); });
+    const std::array<float, 4> co2_inputs = {
+      b.has_CO2 ? b.CO2_f : NAN, static_cast<float>(governor::g_enable_co2_control),
+      static_cast<float>(st.model_level), static_cast<float>(st.co2_active),
+    };
+    const Determination c = this->run_gated(this->co2_cache, governor::kCO2PeriodMs, co2_inputs, now_ms,
+        [&] { return governor::determine_co2(b, st, now_ms); });
+    const std::array<float, 4> rh_inputs = {
+      b.has_RHi ? b.RHi_f : NAN, b.has_RHo ? b.RHo : NAN,
+      static_cast<float>(governor::g_enable_rh_control), static_cast<float>(st.rh_active),
+    };
+    const Determination h = this->run_gated(this->rh_cache, governor::kRHPeriodMs, rh_inputs, now_ms,
+        [&] { return governor::determine_rh(b, st); });
+
+    governor::Combined combined{};
+    combined.level_raw = std::max({t.level, c.level, h.level});
+    combined.any_active = t.active || c.active || h.active;
+    combined.any_lid_request = t.lid_request || c.lid_request || h.lid_request;
+    int best = 0;
+    if (t.level > best) { best = t.level; combined.active = 1; }
+    if (c.level > best) { best = c.level; combined.active = 2; }
+    if (h.level > best) { best = h.level; combined.active = 3; }
+    return combined;
+  }
+};
+
+struct Tick {
+  ControlInput input;
+  SensorBundle bundle;
+  uint32_t now_ms;
+};
+
+// A day of one second ticks whose sensors report every five seconds and drift randomly.
+std::vector<Tick> make_ticks() {
+  std::mt19937 random(68);
+  std::normal_distribution<float> step(0.0f, 1.0f);
+  std::vector<Tick> ticks;
+  SensorBundle b{};
+  b.has_Tin = b.has_Tout = b.has_RHi = b.has_RHo = b.has_CO2 = true;
+  float Tin = 26.0f, Tout = 20.0f, RHi = 55.0f, RHo = 60.0f, CO2 = 600.0f;
+  ControlInput input{26.0f, 24.0f, ClimateAction::CLIMATE_ACTION_COOLING, ClimateFanMode::CLIMATE_FAN_AUTO,
+                     minuet::LidMode::AUTO};
+  for (uint32_t s = 0; s < 24 * 3600; s++) {
+    if (s % 5 == 0) {
+      Tin = std::clamp(Tin + 0.02f * step(random), 18.0f, 34.0f);
+      RHi = std::clamp(RHi + 0.2f * step(random), 20.0f, 95.0f);
+      CO2 = std::clamp(CO2 + 4.0f * step(random), 420.0f, 2000.0f);
+      b.Tin = b.Tin_f = std::round(Tin * 100.0f) / 100.0f;
+      b.RHi = b.RHi_f = std::round(RHi * 10.0f) / 10.0f;
+      b.CO2 = b.CO2_f = std::round(CO2);
+    }
+    if (s % 60 == 0) {
+      Tout = std::clamp(Tout + 0.05f * step(random), 10.0f, 35.0f);
+      RHo = std::clamp(RHo + 0.3f * step(random), 20.0f, 95.0f);
+      b.Tout = std::round(Tout * 100.0f) / 100.0f;
+      b.RHo = std::round(RHo * 10.0f) / 10.0f;
+    }
+    if (s % 900 == 0) {
+      input.action = random() % 3 ? ClimateAction::CLIMATE_ACTION_COOLING : ClimateAction::CLIMATE_ACTION_IDLE;
+    }
+    input.ambient_temperature = b.Tin;
+    ticks.push_back({input, b, s * 1000});
+  }
+  return ticks;
+}
+
+bool same(const governor::Combined& a, const governor::Combined& b) {
+  return a.level_raw == b.level_raw && a.any_active == b.any_active && a.any_lid_request == b.any_lid_request
+         && a.active == b.active;
+}
+
+}  // namespace
+
+int main() {
+  const std::vector<Tick> ticks = make_ticks();
+
+  // Equivalence, including the runs after gating
+  governor::reset();
+  GovernorState registry_state{};
+  GovernorState hand_state{};
+  HandWrittenDispatch hand;
+  unsigned mismatches = 0;
+  for (const Tick& tick : ticks) {
+    const auto d = governor::g_controllers.determine(tick.input, tick.bundle, registry_state, tick.now_ms);
+    const governor::Combined a = governor::Controllers::combine(d);
+    const governor::Combined b = hand.tick(tick.input, tick.bundle, hand_state, tick.now_ms);
+    mismatches += !same(a, b);
+    registry_state.model_level = hand_state.model_level = a.any_lid_request ? a.level_raw : 0;
+  }
+  CHECK(mismatches == 0);
+  std::printf("%zu ticks, %u mismatches, %u runs by hand, registry %s\n", ticks.size(), mismatches, hand.runs,
+      governor::describe_controller_stats().c_str());
+
+  // Tick cost, with and without gating skips
+  constexpr unsigned ROUNDS = 5;
+  for (bool gated : {true, false}) {
+    const auto ticks_of = [&](auto&& body) {
+      return test::time_ns(ROUNDS, [&] {
+        GovernorState st{};
+        for (const Tick& tick : ticks) {
+          if (!gated) {
+            governor::invalidate_controllers();
+            hand = {};
+          }
+          test::keep(body(tick, st).level_raw);
+        }
+      }) / ticks.size();
+    };
+    const double hand_ns = ticks_of([&](const Tick& tick, GovernorState& st) {
+      return hand.tick(tick.input, tick.bundle, st, tick.now_ms);
+    });
+    const double registry_ns = ticks_of([&](const Tick& tick, GovernorState& st) {
+      return governor::Controllers::combine(governor::g_controllers.determine(tick.input, tick.bundle, st, tick.now_ms));
+    });
+    std::printf("%s: hand-written %6.1f ns/tick, registry %6.1f ns/tick\n", gated ? "gated" : "every controller runs",
+        hand_ns, registry_ns);
+  }
+  return test::result();
+}
@@ -0,0 +1,384 @@
+// Exercises the fan motor controller against the MCF8316 emulator: bus transactions per operation,
+// the speed response through the tachometer, fault and bus error sequences, MPET gating, and the
+// order in which the controller writes the driver inputs.
+#include "esphome.h"
+
+#include "core.h"
+#include "fan_driver.h"
+#include "test.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace fan_driver = minuet::fan_driver;
+namespace mcf8316 = esphome::mcf8316;
+
+using Transactions = mcf8316::MCF8316Component::Transactions;
+
+namespace {
+
+mcf8316::MCF8316Component& chip = host::fan_driver;
+fan_driver::Controller& controller = fan_driver::controller;
+const fan_driver::MotorDescriptor& MOTOR = fan_driver::MOTORS[0];
+
+// Starts over with a freshly set up chip and an uninitialized controller.
+void reset() {
+  chip = mcf8316::MCF8316Component{};
+  controller = fan_driver::Controller{};
+}
+
+// Runs the component loop every 10 ms for `ms`.
+void run_for(uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t += 10) {
+    host::advance_ms(10);
+    chip.loop();
+  }
+}
+
+// The transactions of an operation.
+template <typename F>
+Transactions count(F&& operation) {
+  chip.reset_transactions();
+  operation();
+  return chip.transactions();
+}
+
+bool same(const Transactions& a, const Transactions& b) {
+  return a.reads == b.reads && a.writes == b.writes && a.expander_reads == b.expander_reads
+         && a.expander_writes == b.expander_writes && a.errors == b.errors;
+}
+
+// The rotor speed that a fan speed asks for, positive clockwise.
+float rotor_hz(float speed_rpm, bool exhaust) { return fan_driver::rpm_to_hz(speed_rpm) * (exhaust ? 1.0f : -1.0f); }
+
+void test_config() {
+  mcf8316::Config config;
+  config.set(mcf8316::FG_DIV, 15u);
+  CHECK(!config.overflow());
+  config.set(mcf8316::FG_DIV, 16u);
+  CHECK(config.overflow());
+
+  reset();
+  controller.init(MOTOR);
+  CHECK(!chip.config_shadow().overflow());
+  CHECK(chip.ram() == chip.config_shadow());
+  CHECK(chip.eeprom() == chip.ram());
+  CHECK(chip.eeprom_writes() == 1);
+  CHECK(!chip.config_shadow().needs_mpet_for_speed_loop());
+  CHECK(chip.ram().get(mcf8316::MOTOR_RES) == MOTOR.profile.motor_res);
+  CHECK(chip.ram().get(mcf8316::SPD_LOOP_KI) == MOTOR.profile.spd_loop_ki);
+
+  // The saved configuration survives a power cycle, the inputs set since don't
+  const mcf8316::Config saved = chip.eeprom();
+  CHECK(controller.set_state(600, false, false, false));
+  CHECK(!(chip.ram() == saved));
+  chip.power_cycle();
+  CHECK(chip.ram() == saved);
+  CHECK(chip.target_rotor_hz() == 0.0f);
+}
+
+void test_speed_response() {
+  reset();
+  controller.init(MOTOR);
+  for (float speed_rpm : {600.0f, 1000.0f, 1200.0f, 200.0f}) {
+    for (bool exhaust : {true, false}) {
+      CHECK(controller.set_state(speed_rpm, exhaust, false, false));
+      CHECK_NEAR(chip.target_rotor_hz(), rotor_hz(speed_rpm, exhaust), 0.01f);
+      run_for(15000);
+      CHECK_NEAR(controller.get_tachometer_rpm(), speed_rpm, 5.0f);
+      CHECK_NEAR(chip.motor.speed_hz, rotor_hz(speed_rpm, exhaust), 0.1f);
+    }
+  }
+
+  CHECK(controller.set_state(1200, true, false, false));
+  run_for(15000);
+  const float bus_current = controller.get_bus_current();
+  CHECK(bus_current > 1.0f && bus_current < 2.0f);
+  CHECK_NEAR(controller.get_motor_phase_peak_current(), bus_current * chip.motor.phase_to_bus_current, 0.01f);
+  CHECK_NEAR(controller.get_vm_voltage(), chip.motor.vm_volts - bus_current * chip.motor.supply_resistance_ohms, 0.01f);
+
+  // Stopping puts the chip to sleep and the fan coasts down, faster with the brake
+  CHECK(controller.set_state(0, true, false, false));
+  CHECK(!chip.is_awake());
+  run_for(5000);
+  const float coasting_hz = chip.motor.speed_hz;
+  CHECK(coasting_hz > 5.0f);
+  CHECK(std::isnan(controller.get_bus_current()));
+  run_for(60000);
+  CHECK(chip.motor.speed_hz == 0.0f);
+
+  CHECK(controller.set_state(1200, true, false, false));
+  run_for(15000);
+  CHECK(controller.set_state(0, true, true, true));
+  CHECK(chip.is_awake());
+  run_for(5000);
+  CHECK(chip.motor.speed_hz < coasting_hz / 2);
+}
+
+// Transactions per operation, including the GPIO expander that drives nSLEEP and reads nFAULT.
+void test_transactions() {
+  reset();
+  struct Row {
+    const char* operation;
+    Transactions transactions;
+    Transactions expected;
+  };
+  Row rows[] = {
+    {"init", count([] { controller.init(MOTOR); }), {.reads = 3, .writes = 25}},
+    {"start", count([] { controller.set_state(800, true, false, false); }), {.writes = 3}},
+    {"change speed", count([] { controller.set_state(1000, true, false, false); }), {.writes = 3}},
+    {"reverse", count([] { controller.set_state(1000, false, false, false); }), {.writes = 3}},
+    {"read tachometer", count([] { controller.get_tachometer_rpm(); }), {.reads = 1}},
+    {"read diagnostics", count([] {
+       controller.get_bus_current();
+       controller.get_motor_phase_peak_current();
+       controller.get_vm_voltage();
+     }),
+     {.reads = 3}},
+    {"loop for 1 s", count([] { run_for(1000); }), {.expander_reads = 10}},
+    {"stop to sleep", count([] { controller.set_state(0, true, false, false); }), {.writes = 3, .expander_writes = 1}},
+    {"stop while asleep", count([] { controller.set_state(0, true, false, false); }), {}},
+    {"brake from sleep", count([] { controller.set_state(0, true, true, true); }), {.writes = 3, .expander_writes = 1}},
+    {"fault in loop", count([] {
+       chip.inject_fault(mcf8316::Fault::MOTOR_LOCK);
+       run_for(100);
+     }),
+     {.reads = 2, .expander_reads = 1}},
+    {"stop and clear fault", count([] { controller.set_state(0, true, false, false); }),
+     {.writes = 4, .expander_writes = 1}},
+    {"start MPET from sleep", count([] { controller.start_mpet(); }), {.writes = 2, .expander_writes = 1}},
+    {"shutdown", count([] { controller.shutdown(); }), {.writes = 1, .expander_writes = 1}},
+  };
+
+  std::printf("%-22s %6s %6s %9s %10s %6s\n", "operation", "reads", "writes", "exp reads", "exp writes", "errors");
+  for (const Row& row : rows) {
+    const Transactions& t = row.transactions;
+    std::printf("%-22s %6u %6u %9u %10u %6u\n", row.operation, t.reads, t.writes, t.expander_reads,
+        t.expander_writes, t.errors);
+    if (!same(t, row.expected)) test::fail(__FILE__, __LINE__, row.operation);
+  }
+}
+
+void test_faults() {
+  reset();
+  controller.init(MOTOR);
+
+  // A lock while running: nFAULT is seen by the next poll, the motor coasts, and the fault
+  // recovery stops the fan, which clears the fault
+  CHECK(controller.set_state(1000, true, false, false));
+  run_for(10000);
+  chip.inject_fault(mcf8316::Fault::MOTOR_LOCK);
+  run_for(100);
+  CHECK(chip.is_faulted());
+  run_for(2000);
+  CHECK(chip.motor.speed_hz < fan_driver::rpm_to_hz(1000) * 0.9f);
+  CHECK(controller.set_state(0, true, false, false));
+  CHECK(!chip.fault_active());
+  CHECK(!chip.is_awake());
+  CHECK(controller.set_state(1000, true, false, false));
+  run_for(15000);
+  CHECK_NEAR(controller.get_tachometer_rpm(), 1000.0f, 5.0f);
+
+  // A fault that takes two clears
+  chip.inject_fault(mcf8316::Fault::OVERCURRENT, 2);
+  run_for(100);
+  CHECK(controller.set_state(0, true, false, true));
+  CHECK(chip.fault_active());
+  CHECK(chip.is_faulted());
+  CHECK(controller.set_state(0, true, false, true));
+  CHECK(!chip.fault_active());
+  run_for(100);
+  CHECK(!chip.is_faulted());
+
+  // A failed clear is reported but the stop still succeeds; the next stop clears the fault
+  chip.inject_fault(mcf8316::Fault::MOTOR_LOCK);
+  run_for(100);
+  chip.inject_bus_errors(1, 3);
+  Transactions t = count([] { CHECK(controller.set_state(0, true, false, true)); });
+  CHECK(t.writes == 4 && t.errors == 1);
+  CHECK(chip.fault_active());
+  CHECK(controller.set_state(0, true, false, true));
+  CHECK(!chip.fault_active());
+
+  // A bus error while setting the inputs fails the call and puts the chip to sleep
+  CHECK(controller.set_state(800, true, false, false));
+  chip.inject_bus_errors(1);
+  t = count([] { CHECK(!controller.set_state(1000, true, false, false)); });
+  CHECK(t.writes == 3 && t.errors == 1 && t.expander_writes == 1);
+  CHECK(!chip.is_awake());
+
+  // A failed wake fails the call without writing to the asleep chip
+  chip.inject_bus_errors(1);
+  t = count([] { CHECK(!controller.set_state(1000, true, false, false)); });
+  CHECK(t.writes == 0 && t.expander_writes == 1 && t.errors == 1);
+  CHECK(!chip.is_awake());
+  CHECK(controller.set_state(1000, true, false, false));
+
+  // Reads fail while asleep
+  CHECK(controller.set_state(0, true, false, false));
+  CHECK(std::isnan(controller.get_vm_voltage()));
+  CHECK(controller.get_tachometer_rpm() == 0.0f);
+}
+
+void test_mpet() {
+  fan_driver::MotorDescriptor unmeasured = MOTOR;
+  unmeasured.profile.motor_res = 0;
+  unmeasured.profile.motor_ind = 0;
+  unmeasured.profile.motor_bemf_const = 0;
+  unmeasured.profile.spd_loop_kp = 0;
+  unmeasured.profile.spd_loop_ki = 0;
+
+  reset();
+  controller.init(unmeasured);
+  CHECK(chip.config_shadow().needs_mpet_for_speed_loop());
+
+  // The controller won't start the fan before MPET, and doesn't touch the chip trying
+  Transactions t = count([] { CHECK(!controller.set_state(800, true, false, false)); });
+  CHECK(same(t, {}));
+
+  // Which is just as well: without the motor parameters the speed loop locks
+  chip.write_speed_input(10.0f);
+  run_for(100);
+  CHECK(chip.fault_active());
+  chip.write_speed_input(0.0f);
+  chip.clear_fault();
+
+  // MPET needs the chip awake
+  chip.sleep();
+  chip.inject_bus_errors(1);
+  t = count([] { CHECK(!controller.start_mpet()); });
+  CHECK(t.writes == 0 && !chip.mpet_running());
+
+  // and a cleared fault
+  chip.inject_bus_errors(1, 1);
+  t = count([] { CHECK(!controller.start_mpet()); });
+  CHECK(t.expander_writes == 1 && t.writes == 1 && !chip.mpet_running());
+
+  CHECK(controller.start_mpet());
+  CHECK(chip.mpet_running());
+  run_for(mcf8316::MCF8316Component::MPET_DURATION_MS + 200);
+  CHECK(!chip.mpet_running());
+  CHECK(!chip.fault_active());
+  CHECK(!chip.config_shadow().needs_mpet_for_speed_loop());
+  CHECK(chip.config_shadow().get(mcf8316::MOTOR_BEMF_CONST) == chip.motor.motor_bemf_const);
+
+  CHECK(controller.set_state(800, true, false, false));
+  run_for(15000);
+  CHECK_NEAR(controller.get_tachometer_rpm(), 800.0f, 5.0f);
+  CHECK(!chip.fault_active());
+}
+
+// A second driver type: the emulator with its input writes traced, controlled by its own instance
+// of the controller.
+struct TracingDriver : mcf8316::MCF8316Component {
+  std::string trace;
+
+  ErrorCode write_speed_input(float speed_in_rotor_hz) {
+    this->trace += speed_in_rotor_hz > 0.0f ? "speed " : "stop ";
+    return MCF8316Component::write_speed_input(speed_in_rotor_hz);
+  }
+  ErrorCode write_direction_input_config(bool counter_clockwise) {
+    this->trace += counter_clockwise ? "ccw " : "cw ";
+    return MCF8316Component::write_direction_input_config(counter_clockwise);
+  }
+  ErrorCode write_brake_input_config(bool brake) {
+    this->trace += brake ? "brake " : "release ";
+    return MCF8316Component::write_brake_input_config(brake);
+  }
+};
+
+TracingDriver g_tracing_chip;
+TracingDriver* g_tracing = &g_tracing_chip;
+
+void test_input_order() {
+  fan_driver::BasicController<TracingDriver, g_tracing> tracer;
+  const Transactions before = chip.transactions();
+  tracer.init(MOTOR);
+
+  const auto trace = [&](float speed_rpm, bool exhaust, bool brake) {
+    g_tracing_chip.trace.clear();
+    CHECK(tracer.set_state(speed_rpm, exhaust, brake, true));
+    return g_tracing_chip.trace;
+  };
+  // The direction is set before the speed, the brake engages before the speed drops, and releases
+  // after the speed is set
+  CHECK(trace(800, true, false) == "cw speed release ");
+  CHECK(trace(800, false, false) == "ccw speed release ");
+  CHECK(trace(0, false, true) == "brake stop ccw ");
+  CHECK(trace(800, true, true) == "brake cw speed ");
+  CHECK(trace(0, true, false) == "stop cw release ");
+  CHECK(g_tracing_chip.transactions().writes == 25 + 5 * 3);
+
+  // The instances are independent
+  CHECK(same(chip.transactions(), before));
+}
+
+// Random operations, faults and bus errors.  Whatever happens, a successful call leaves the chip in
+// the requested state, the configuration shadow matches the chip, and the fan recovers.
+void test_fault_fuzz() {
+  unsigned calls = 0, failures = 0, faults = 0, bus_errors = 0;
+  for (uint32_t seed = 0; seed < 40; seed++) {
+    std::mt19937 random(seed);
+    reset();
+    controller.init(MOTOR);
+    for (int step = 0; step < 200; step++) {
+      switch (random() % 8) {
+        case 0:
+          chip.inject_fault(random() % 2 ? mcf8316::Fault::MOTOR_LOCK : mcf8316::Fault::OVERCURRENT, 1 + random() % 3);
+          faults++;
+          break;
+        case 1:
+          chip.inject_bus_errors(1 + random() % 2, random() % 5);
+          bus_errors++;
+          break;
+        default: {
+          const float speed_rpm = random() % 3 ? controller.get_fan_speed_by_index(1 + random() % 10) : 0.0f;
+          const bool exhaust = random() % 2, brake = random() % 4 == 0, keep_awake = random() % 2;
+          calls++;
+          bool ok = false;
+          const Transactions t = count([&] { ok = controller.set_state(speed_rpm, exhaust, brake, keep_awake); });
+          if (!ok) {
+            CHECK(t.errors > 0);
+            failures++;
+          } else if (speed_rpm > 0) {
+            CHECK(chip.is_awake());
+            CHECK_NEAR(chip.target_rotor_hz(), rotor_hz(speed_rpm, exhaust), 0.01f);
+          } else if (!keep_awake && !t.errors) {
+            CHECK(!chip.is_awake());
+          }
+          break;
+        }
+      }
+      run_for(10 * (1 + random() % 200));
+      CHECK(chip.config_shadow() == chip.ram());
+      if (chip.driving()) CHECK(!chip.config_shadow().needs_mpet_for_speed_loop());
+    }
+
+    // Recovery: stopping clears the faults, then the fan starts
+    chip.inject_bus_errors(0);
+    for (int attempt = 0; attempt < 5 && chip.fault_active(); attempt++) {
+      controller.set_state(0, true, false, true);
+      run_for(200);
+    }
+    CHECK(!chip.fault_active());
+    CHECK(controller.set_state(1000, true, false, false));
+    run_for(15000);
+    CHECK_NEAR(controller.get_tachometer_rpm(), 1000.0f, 5.0f);
+  }
+  std::printf("fault fuzz: %u calls, %u failed, %u faults, %u bus error bursts\n", calls, failures, faults,
+      bus_errors);
+}
+
+}  // namespace
+
+int main() {
+  test_config();
+  test_speed_response();
+  test_transactions();
+  test_faults();
+  test_mpet();
+  test_input_order();
+  test_fault_fuzz();
+  return test::result();
+}
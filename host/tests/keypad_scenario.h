@@ -0,0 +1,289 @@
+// KEYPAD SCENARIOS
+//
+// Drives the keypad timing in keypad.h on a virtual clock and checks what it reports against a
+// short script.  Time only advances when the script says so, so a scenario of many seconds runs in
+// microseconds.
+//
+// A script is a list of statements separated by semicolons or newlines.  A statement may start
+// with a time, either absolute (`t=3.1s`) or relative to the previous statement (`+200ms`), and
+// the clock advances to it first.  Durations are in milliseconds unless they end in `s` or `ms`.
+// Keys are named as in keypad.h, with or without the `KEY_` prefix, and can be joined with `+`.
+//
+//   press KEY...           presses the keys, adding to those already down
+//   release [KEY...]       releases the keys, or all of them
+//   bounce KEY DURATION    the key chatters for the duration and then settles in the other state
+//   holds accepted|ignored whether the hold actions accept holds (they do by default)
+//   indicator off|blink|steady
+//                          the condition shown by the indicator
+//   suppressed on|off      whether the indicators are suppressed
+//   blink TICKS            overrides the indicator with a slow blink
+//   expect press KEY       the next unchecked report is a press of the keys
+//   expect hold KEY        the next unchecked report is a hold of the keys
+//   expect taps KEY COUNT  the next unchecked report is the number of taps of a combination
+//   expect nothing         there are no unchecked reports
+//   expect lit|dark        the indicator's state
+//
+// For example: `t=0 press AUTO; t=3.1s expect hold KEY_AUTO; release; t=4s expect nothing`.
+// Reports that are still unchecked at the end of the script fail it.
+#pragma once
+
+#include "keypad.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace scenario {
+
+namespace keypad = minuet::keypad;
+
+// Something reported by the keypad
+struct Event {
+  enum Kind : uint8_t { PRESS, HOLD, TAPS };
+  Kind kind;
+  uint32_t keys;
+  uint32_t count;    // taps, or the number of scans in a row that reported the hold
+  uint32_t time_ms;  // when it was first reported
+
+  bool operator==(const Event&) const = default;
+};
+
+inline std::string key_name(uint32_t keys) {
+  if (const keypad::KeyInfo* info = keypad::find_key(keys)) return info->name;
+  char text[16];
+  std::snprintf(text, sizeof(text), "0x%x", static_cast<unsigned>(keys));
+  return text;
+}
+
+inline std::string describe(const Event& event) {
+  static constexpr const char* KINDS[] = {"press", "hold", "taps"};
+  std::string text = KINDS[event.kind];
+  text += ' ';
+  text += key_name(event.keys);
+  if (event.kind == Event::TAPS) {
+    text += ' ';
+    text += std::to_string(event.count);
+  }
+  char at[32];
+  std::snprintf(at, sizeof(at), " at %.2fs", event.time_ms / 1000.0);
+  text += at;
+  return text;
+}
+
+// Parses a duration such as `3.1s`, `40ms` or `250`.
+inline bool parse_duration(std::string_view text, uint32_t& ms) {
+  double scale = 1.0;
+  if (text.ends_with("ms")) {
+    text.remove_suffix(2);
+  } else if (text.ends_with("s")) {
+    text.remove_suffix(1);
+    scale = 1000.0;
+  }
+  const std::string number(text);
+  char* end = nullptr;
+  const double value = std::strtod(number.c_str(), &end);
+  if (number.empty() || *end || !(value >= 0.0) || value * scale > UINT32_MAX) return false;
+  ms = static_cast<uint32_t>(std::lround(value * scale));
+  return true;
+}
+
+// Parses a key or combination such as `KEY_UP`, `UP`, `KEY_COMBO_AUTO_UP` or `AUTO+UP`.
+inline bool parse_keys(std::string_view text, uint32_t& keys) {
+  keys = 0;
+  while (!text.empty()) {
+    const size_t plus = text.find('+');
+    std::string_view name = text.substr(0, plus);
+    text = plus == std::string_view::npos ? std::string_view{} : text.substr(plus + 1);
+    bool found = false;
+    for (const keypad::KeyInfo& info : keypad::KEYS) {
+      std::string_view candidate = info.name;
+      if (candidate != name && candidate.substr(4) != name) continue;
+      keys |= info.keys;
+      found = true;
+      break;
+    }
+    if (!found) return false;
+  }
+  return keys != 0;
+}
+
+// Scans a keypad and ticks an indicator on a virtual clock as the keypad package does, recording
+// what the keypad reports.  The keypad is any type with the interface of keypad::Keypad.
+template <typename Keypad = keypad::Keypad, typename Indicator = keypad::Indicator>
+class Runner {
+public:
+  static constexpr uint32_t SCAN_MS = 10;       // the keypad scan interval
+  static constexpr uint32_t INDICATOR_MS = 300; // the indicator interval
+
+  // Decides whether a hold action accepts the hold of `keys` after `hold_ms`.
+  using HoldPolicy = bool (*)(uint32_t keys, uint32_t hold_ms);
+  static bool accept_holds(uint32_t, uint32_t) { return true; }
+  static bool ignore_holds(uint32_t, uint32_t) { return false; }
+
+  Keypad keypad{};
+  Indicator indicator{};
+  HoldPolicy hold_policy{accept_holds};
+  uint8_t condition{0};
+  bool suppressed{false};
+
+  uint32_t now_ms() const { return this->now_ms_; }
+  uint32_t keys() const { return this->keys_; }
+  void set_keys(uint32_t keys) { this->keys_ = keys; }
+  bool lit() const { return this->lit_; }
+  const std::vector<Event>& events() const { return this->events_; }
+
+  // Runs the scans and indicator ticks that fall due up to and including `t_ms`.
+  void advance_to(uint32_t t_ms) {
+    while (this->next_scan_ms_ <= t_ms || this->next_tick_ms_ <= t_ms) {
+      if (this->next_scan_ms_ <= this->next_tick_ms_) {
+        this->now_ms_ = this->next_scan_ms_;
+        this->next_scan_ms_ += SCAN_MS;
+        this->scan();
+      } else {
+        this->now_ms_ = this->next_tick_ms_;
+        this->next_tick_ms_ += INDICATOR_MS;
+        this->lit_ = this->indicator.tick(this->condition, this->keypad.take_activity(), this->suppressed);
+      }
+    }
+    this->now_ms_ = t_ms;
+  }
+
+private:
+  void scan() {
+    const uint32_t now_ms = this->now_ms_;
+    this->keypad.scan(
+        this->keys_, now_ms,
+        [&](uint32_t keys) { this->events_.push_back({Event::PRESS, keys, 1, now_ms}); },
+        [&](uint32_t keys, uint32_t hold_ms) {
+          // A hold that isn't accepted is reported again on every scan
+          Event* last = this->events_.empty() ? nullptr : &this->events_.back();
+          if (last && last->kind == Event::HOLD && last->keys == keys && this->last_hold_ms_ + SCAN_MS == now_ms) {
+            last->count++;
+          } else {
+            this->events_.push_back({Event::HOLD, keys, 1, now_ms});
+          }
+          this->last_hold_ms_ = now_ms;
+          return this->hold_policy(keys, hold_ms);
+        },
+        [&](uint32_t keys, uint8_t count) { this->events_.push_back({Event::TAPS, keys, count, now_ms}); });
+  }
+
+  uint32_t now_ms_{0};
+  uint32_t next_scan_ms_{SCAN_MS};
+  uint32_t next_tick_ms_{INDICATOR_MS};
+  uint32_t keys_{0};
+  bool lit_{false};
+  std::vector<Event> events_;
+  uint32_t last_hold_ms_{0};
+};
+
+// Runs a script against a runner.  Returns an empty string if it passes, otherwise what failed.
+template <typename R>
+std::string run(std::string_view script, R& runner) {
+  size_t checked = 0;
+  const auto fail = [&](std::string_view statement, const std::string& what) {
+    char at[32];
+    std::snprintf(at, sizeof(at), " at %.2fs", runner.now_ms() / 1000.0);
+    std::string text = "`";
+    text.append(statement).append("`").append(at).append(": ").append(what);
+    return text;
+  };
+
+  const auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+  while (!script.empty()) {
+    const size_t end = script.find_first_of(";\n");
+    const std::string_view statement = script.substr(0, end);
+    script = end == std::string_view::npos ? std::string_view{} : script.substr(end + 1);
+
+    std::vector<std::string_view> words;
+    std::string_view rest = statement.substr(0, statement.find('#'));
+    while (!rest.empty()) {
+      while (!rest.empty() && is_space(rest.front())) rest.remove_prefix(1);
+      size_t n = 0;
+      while (n < rest.size() && !is_space(rest[n])) n++;
+      if (n) words.push_back(rest.substr(0, n));
+      rest.remove_prefix(n);
+    }
+    if (words.empty()) continue;
+
+    // Time
+    size_t w = 0;
+    uint32_t duration = 0;
+    if (words[0].starts_with("t=") || words[0].starts_with("+")) {
+      const bool relative = words[0][0] == '+';
+      if (!parse_duration(words[0].substr(relative ? 1 : 2), duration)) return fail(statement, "bad time");
+      const uint32_t t_ms = relative ? runner.now_ms() + duration : duration;
+      if (t_ms < runner.now_ms()) return fail(statement, "time goes backwards");
+      runner.advance_to(t_ms);
+      w++;
+    }
+    if (w == words.size()) continue;
+
+    // Command
+    const std::string_view command = words[w++];
+    const size_t argc = words.size() - w;
+    const auto arg = [&](size_t i) { return i < argc ? words[w + i] : std::string_view{}; };
+    uint32_t keys = 0;
+    if (command == "press" && argc >= 1) {
+      for (size_t i = 0; i < argc; i++) {
+        if (!parse_keys(arg(i), keys)) return fail(statement, "unknown key");
+        runner.set_keys(runner.keys() | keys);
+      }
+    } else if (command == "release") {
+      if (argc == 0) runner.set_keys(0);
+      for (size_t i = 0; i < argc; i++) {
+        if (!parse_keys(arg(i), keys)) return fail(statement, "unknown key");
+        runner.set_keys(runner.keys() & ~keys);
+      }
+    } else if (command == "bounce" && argc == 2) {
+      if (!parse_keys(arg(0), keys) || !parse_duration(arg(1), duration)) return fail(statement, "bad bounce");
+      // Contact chatter a little faster than the scans, ending with an odd number of toggles
+      constexpr uint32_t CHATTER_MS = 7;
+      const uint32_t start_ms = runner.now_ms();
+      const uint32_t toggles = (duration / CHATTER_MS) | 1;
+      for (uint32_t i = 0; i < toggles; i++) {
+        runner.advance_to(start_ms + i * CHATTER_MS);
+        runner.set_keys(runner.keys() ^ keys);
+      }
+    } else if (command == "holds" && (arg(0) == "accepted" || arg(0) == "ignored")) {
+      runner.hold_policy = arg(0) == "accepted" ? R::accept_holds : R::ignore_holds;
+    } else if (command == "indicator" && (arg(0) == "off" || arg(0) == "blink" || arg(0) == "steady")) {
+      runner.condition = arg(0) == "off" ? 0 : arg(0) == "blink" ? 1 : 2;
+    } else if (command == "suppressed" && (arg(0) == "on" || arg(0) == "off")) {
+      runner.suppressed = arg(0) == "on";
+    } else if (command == "blink" && argc == 1) {
+      if (!parse_duration(arg(0), duration) || duration > UINT8_MAX) return fail(statement, "bad blink count");
+      runner.indicator.blink(static_cast<uint8_t>(duration));
+    } else if (command == "expect" && (arg(0) == "lit" || arg(0) == "dark")) {
+      if (runner.lit() != (arg(0) == "lit")) return fail(statement, runner.lit() ? "lit" : "dark");
+    } else if (command == "expect" && arg(0) == "nothing") {
+      if (checked < runner.events().size()) return fail(statement, "got " + describe(runner.events()[checked]));
+    } else if (command == "expect" && (arg(0) == "press" || arg(0) == "hold" || arg(0) == "taps")) {
+      const Event::Kind kind = arg(0) == "press" ? Event::PRESS : arg(0) == "hold" ? Event::HOLD : Event::TAPS;
+      uint32_t count = 0;
+      if (!parse_keys(arg(1), keys) || (kind == Event::TAPS && !parse_duration(arg(2), count))) {
+        return fail(statement, "bad expectation");
+      }
+      if (checked == runner.events().size()) return fail(statement, "got nothing");
+      const Event& event = runner.events()[checked++];
+      if (event.kind != kind || event.keys != keys || (kind == Event::TAPS && event.count != count)) {
+        return fail(statement, "got " + describe(event));
+      }
+    } else {
+      return fail(statement, "unknown statement");
+    }
+  }
+  if (checked < runner.events().size()) return "unchecked " + describe(runner.events()[checked]);
+  return {};
+}
+
+inline std::string run(std::string_view script) {
+  Runner<> runner;
+  return run(script, runner);
+}
+
+}  // namespace scenario
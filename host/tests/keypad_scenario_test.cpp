@@ -0,0 +1,460 @@
+// Runs keypad scenarios on a virtual clock, checks keypad.h against the keypad lambdas that it
+// replaced, and measures how many scenarios run per second.
+#include "esphome.h"
+
+#include "keypad_scenario.h"
+#include "test.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace minuet::keypad;
+using scenario::Event;
+
+namespace {
+
+void expect_pass(const char* script) {
+  const std::string failure = scenario::run(script);
+  if (!failure.empty()) {
+    std::fprintf(stderr, "scenario `%s`\n  %s\n", script, failure.c_str());
+    test::fail(__FILE__, __LINE__, "scenario failed");
+  }
+}
+
+void expect_fail(const char* script) {
+  if (scenario::run(script).empty()) {
+    std::fprintf(stderr, "scenario `%s` passed\n", script);
+    test::fail(__FILE__, __LINE__, "scenario should have failed");
+  }
+}
+
+const char* const PRESS_SCENARIOS[] = {
+  "t=0 press UP; t=150ms release; t=300ms expect press KEY_UP",
+  "t=0 press AUTO; t=790ms release; t=1s expect press KEY_AUTO",
+  // Too short, too long, and a glitch shorter than the debounce
+  "t=0 press UP; t=60ms release; t=1s expect nothing",
+  "t=0 press RAIN; t=900ms release; t=2s expect nothing",
+  "t=0 press UP; t=20ms release; t=1s expect nothing",
+  // Combinations formed one key at a time, and keys that don't combine
+  "t=0 press AUTO; +100ms press UP; +200ms release; +100ms expect press KEY_COMBO_AUTO_UP",
+  "t=0 press UP DOWN; +300ms release UP; +50ms release DOWN; +100ms expect nothing",
+  "t=0 press UP+DOWN; +300ms release; +100ms expect press COMBO_OPEN_CLOSE",
+  "t=0 press RAIN; +100ms press UP; +200ms release; +100ms expect nothing",
+  // Pressing a key with DIRECTION held
+  "t=0 press DIRECTION; +100ms press UP; +200ms release UP; +100ms expect press COMBO_DIRECTION_UP;"
+  "+100ms press DOWN; +200ms release DOWN; +100ms expect press COMBO_DIRECTION_DOWN; release; +1s expect nothing",
+};
+
+const char* const HOLD_SCENARIOS[] = {
+  "t=0 press AUTO; t=2.9s expect nothing; t=3.1s expect hold KEY_AUTO; release; t=4s expect nothing",
+  "t=0 press POWER; t=14.9s expect nothing; t=15.1s expect hold POWER; release; +1s expect nothing",
+  "t=0 press AUTO; +100ms press UP; +4.9s expect nothing; +200ms expect hold COMBO_AUTO_UP; release",
+  // Keys without a hold action are only ever pressed or not
+  "t=0 press RAIN; t=20s release; t=21s expect nothing",
+  // A hold that isn't accepted is reported on every scan and never becomes a press
+  "holds ignored; t=0 press UP; t=1.1s expect hold UP; t=1.5s release; t=2s expect nothing",
+  // An accepted hold cancels the keys, but adding a key back forms the combination afresh
+  "t=0 press POWER+DOWN; t=5.1s expect hold COMBO_POWER_DOWN; release DOWN; +200ms expect nothing;"
+  "press DOWN; +200ms release; +100ms expect press COMBO_POWER_DOWN",
+};
+
+const char* const TAP_SCENARIOS[] = {
+  "t=0 press AUTO; +100ms press POWER; +150ms release POWER; +100ms press POWER; +150ms release POWER;"
+  "+100ms press POWER; +150ms release POWER; +500ms expect nothing; release; +100ms expect taps COMBO_AUTO_POWER 3",
+  "t=0 press AUTO; +100ms press DIRECTION; +200ms release DIRECTION; +300ms release; +100ms "
+  "expect taps COMBO_AUTO_DIRECTION 1",
+  // Both counts are reported on release, power first
+  "t=0 press AUTO; +100ms press DIRECTION; +200ms release DIRECTION; +100ms press POWER; +200ms release POWER;"
+  "+100ms press POWER; +200ms release POWER; +100ms release; +100ms expect taps COMBO_AUTO_POWER 2;"
+  "expect taps COMBO_AUTO_DIRECTION 1",
+  // A tap held too long doesn't count
+  "t=0 press AUTO; +100ms press POWER; +900ms release POWER; +100ms release; +100ms expect nothing",
+};
+
+const char* const DEBOUNCE_SCENARIOS[] = {
+  // Chatter on press and on release
+  "t=0 bounce UP 35ms; +200ms bounce UP 35ms; +200ms expect press UP",
+  // Chatter that never settles long enough is ignored
+  "t=0 bounce UP 2s; +10ms release; +1s expect nothing",
+  // Chatter on a second key while the first is held still forms the combination
+  "t=0 press AUTO; +100ms bounce UP 30ms; +200ms release; +100ms expect press COMBO_AUTO_UP",
+};
+
+const char* const INDICATOR_SCENARIOS[] = {
+  "indicator steady; t=0.3s expect lit; t=10s expect lit",
+  "indicator blink; t=0.3s expect lit; t=0.6s expect dark; t=0.9s expect lit",
+  // Suppressed indicators show a change of condition or a key press for 10 ticks
+  "suppressed on; indicator steady; t=3s expect lit; t=3.3s expect dark;"
+  "press UP; +150ms release; t=3.6s expect lit; expect press UP; t=6.6s expect dark",
+  "suppressed on; t=1s blink 14; t=1.5s expect dark; t=1.8s expect lit; t=2.1s expect lit; t=2.4s expect dark;"
+  "t=6s expect dark",
+};
+
+const std::span<const char* const> SCENARIOS[] = {
+  PRESS_SCENARIOS, HOLD_SCENARIOS, TAP_SCENARIOS, DEBOUNCE_SCENARIOS, INDICATOR_SCENARIOS,
+};
+
+void test_scenarios() {
+  for (const auto& scenarios : SCENARIOS) {
+    for (const char* script : scenarios) expect_pass(script);
+  }
+
+  // The runner catches mistakes
+  expect_fail("t=0 press UP; t=150ms release; t=300ms expect press DOWN");
+  expect_fail("t=0 press UP; t=150ms release; t=300ms");
+  expect_fail("t=0 press AUTO; t=2.9s expect hold AUTO");
+  expect_fail("t=0 press NOPE");
+  expect_fail("t=1s press UP; t=0 release");
+  expect_fail("indicator steady; t=0.3s expect dark");
+}
+
+// The keypad lambda and the 300 ms indicator lambda of the keypad package before the timing moved
+// into keypad.h, transcribed with the globals as members and millis() as `now_ms`.  The actions
+// become the press, hold and tap handlers in the order the lambda dispatched them.
+class LegacyKeypad {
+public:
+  template <typename OnPress, typename OnHold, typename OnTaps>
+  void scan(uint32_t key_state, uint32_t now_ms, OnPress&& on_press, OnHold&& on_hold, OnTaps&& on_taps) {
+    // Debounce the keys
+    constexpr uint32_t DEBOUNCE_DURATION = 40;
+    auto& bouncy_key_state = this->bouncy_key_state;
+    auto& bouncy_key_time = this->bouncy_key_time;
+    if (key_state != bouncy_key_state) {
+      bouncy_key_state = key_state;
+      bouncy_key_time = now_ms;
+      return; // wait for key state to be debounced before processing it
+    }
+    if (now_ms - bouncy_key_time < DEBOUNCE_DURATION) {
+      return; // wait for key state to be debounced before processing it
+    }
+
+    // Check whether this key combination is potentially valid
+    const auto VALID_KEY_COMBOS = {
+        KEY_UP, KEY_DOWN, KEY_RAIN, KEY_POWER, KEY_DIRECTION, KEY_AUTO,
+        KEY_4_CLOSE, KEY_4_OPEN, KEY_4_OFF, KEY_4_ON,
+        KEY_COMBO_OPEN_CLOSE,
+        KEY_COMBO_AUTO_UP, KEY_COMBO_AUTO_DOWN, KEY_COMBO_AUTO_DIRECTION, KEY_COMBO_AUTO_POWER, KEY_COMBO_AUTO_OPEN_CLOSE,
+        KEY_COMBO_POWER_UP, KEY_COMBO_POWER_DOWN, KEY_COMBO_POWER_DIRECTION,
+        KEY_COMBO_DIRECTION_UP, KEY_COMBO_DIRECTION_DOWN,
+    };
+    bool key_valid = std::find(VALID_KEY_COMBOS.begin(), VALID_KEY_COMBOS.end(), key_state) != VALID_KEY_COMBOS.end();
+
+    // Key dispatching
+    constexpr uint32_t MIN_PRESS_DURATION = 100;
+    constexpr uint32_t MAX_PRESS_DURATION = 800;
+    constexpr uint32_t MIN_HOLD_UP_DOWN_DURATION = 1000;
+    constexpr uint32_t MIN_HOLD_ACCESSORY_TOGGLE_DURATION = 1000;
+    constexpr uint32_t MIN_HOLD_AUTO_DURATION = 3000;
+    constexpr uint32_t MIN_HOLD_SETTING_DURATION = 5000;
+    constexpr uint32_t MIN_HOLD_FACTORY_RESET_DURATION = 15000;
+    const auto do_press = [&](uint32_t key_state, uint32_t press_duration) {
+      if (press_duration >= MIN_PRESS_DURATION && press_duration <= MAX_PRESS_DURATION) {
+        if (key_state == KEY_COMBO_AUTO_DIRECTION) {
+          this->pending_auto_direction_count += 1;
+        } else if (key_state == KEY_COMBO_AUTO_POWER) {
+          this->pending_auto_power_count += 1;
+        } else if (key_state == KEY_UP || key_state == KEY_DOWN || key_state == KEY_RAIN || key_state == KEY_POWER
+                   || key_state == KEY_DIRECTION || key_state == KEY_AUTO || key_state == KEY_4_ON
+                   || key_state == KEY_4_OFF || key_state == KEY_4_OPEN || key_state == KEY_4_CLOSE
+                   || key_state == KEY_COMBO_OPEN_CLOSE || key_state == KEY_COMBO_AUTO_UP
+                   || key_state == KEY_COMBO_AUTO_DOWN || key_state == KEY_COMBO_DIRECTION_UP
+                   || key_state == KEY_COMBO_DIRECTION_DOWN) {
+          on_press(key_state);
+        }
+      }
+    };
+    const auto do_hold = [&](uint32_t key_state, uint32_t hold_duration) -> bool {
+      if (key_state == KEY_UP && hold_duration >= MIN_HOLD_UP_DOWN_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_DOWN && hold_duration >= MIN_HOLD_UP_DOWN_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_DIRECTION && hold_duration >= MIN_HOLD_ACCESSORY_TOGGLE_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_AUTO && hold_duration >= MIN_HOLD_AUTO_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_AUTO_UP && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_AUTO_DOWN && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_AUTO_OPEN_CLOSE && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_POWER_DOWN && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_POWER_UP && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_COMBO_POWER_DIRECTION && hold_duration >= MIN_HOLD_SETTING_DURATION) {
+        return on_hold(key_state, hold_duration);
+      } else if (key_state == KEY_POWER && hold_duration >= MIN_HOLD_FACTORY_RESET_DURATION) {
+        return on_hold(key_state, hold_duration);
+      }
+      return false;
+    };
+
+    // Wake up suppressed indicators
+    if (key_state) {
+      this->key_pressed_since_indicator_update = true;
+    }
+
+    // Handle pending multiple-tap key presses after the modifier has been released
+    auto& pending_auto_power_count = this->pending_auto_power_count;
+    if (key_state == 0 && pending_auto_power_count) {
+      on_taps(KEY_COMBO_AUTO_POWER, pending_auto_power_count);
+      pending_auto_power_count = 0;
+    }
+    auto& pending_auto_direction_count = this->pending_auto_direction_count;
+    if (key_state == 0 && pending_auto_direction_count) {
+      on_taps(KEY_COMBO_AUTO_DIRECTION, pending_auto_direction_count);
+      pending_auto_direction_count = 0;
+    }
+
+    // Detect key presses
+    auto& last_key_state = this->last_key_state;
+    auto& last_key_valid = this->last_key_valid;
+    auto& last_key_time = this->last_key_time;
+    if (key_state == 0 && last_key_valid) {
+      // A key was released
+      const uint32_t press_duration = now_ms - last_key_time;
+      do_press(last_key_state, press_duration);
+    } else if (key_valid && last_key_state == 0) {
+      // A key was pressed on its own
+      last_key_time = now_ms;
+    } else if (key_valid && key_state != last_key_state && key_state == (key_state | last_key_state)) {
+      // A key was pressed that adds to a previously pressed key to form a combo
+      last_key_time = now_ms;
+    } else if (key_valid && last_key_valid && key_state == last_key_state) {
+      // A key is being held
+      const uint32_t hold_duration = now_ms - last_key_time;
+      if (do_hold(key_state, hold_duration)) {
+        key_valid = false; // cancel further processing of this key
+      }
+    } else if (key_valid && key_state == KEY_AUTO && last_key_valid && (last_key_state & KEY_AUTO) != 0) {
+      // A key that was previously combined with auto has been released while auto remains held
+      const uint32_t press_duration = now_ms - last_key_time;
+      do_press(last_key_state, press_duration);
+      key_valid = false; // cancel processing of the modifier itself
+    } else if (key_valid && key_state == KEY_DIRECTION && last_key_valid && (last_key_state & KEY_DIRECTION) != 0) {
+      // A key that was previously combined with direction has been released while direction remains held
+      const uint32_t press_duration = now_ms - last_key_time;
+      do_press(last_key_state, press_duration);
+      key_valid = false; // cancel processing of the modifier itself
+    } else if (key_valid) {
+      // A different key is pressed now than was pressed before and does not form a valid combo sequence
+      key_valid = false; // cancel further processing of this key
+    }
+    last_key_state = key_state;
+    last_key_valid = key_valid;
+  }
+
+  bool take_activity() {
+    const bool key_pressed = this->key_pressed_since_indicator_update;
+    this->key_pressed_since_indicator_update = false;
+    return key_pressed;
+  }
+
+private:
+  uint32_t bouncy_key_state{0};
+  uint32_t bouncy_key_time{0};
+  uint32_t last_key_state{0};
+  bool last_key_valid{false};
+  uint32_t last_key_time{0};
+  uint8_t pending_auto_power_count{0};
+  uint8_t pending_auto_direction_count{0};
+  bool key_pressed_since_indicator_update{false};
+};
+
+class LegacyIndicator {
+public:
+  void blink(uint8_t ticks) { this->blinks = ticks; }
+
+  bool tick(uint8_t new_condition, bool key_pressed, bool suppressed) {
+    auto& state = this->state;
+    auto& blinks = this->blinks;
+    auto& duration = this->duration;
+    auto& condition = this->condition;
+    if (blinks) {
+      blinks -= 1;
+      state = (blinks & 2);
+      duration = 0;
+    } else {
+      if (condition != new_condition || key_pressed) {
+        condition = new_condition;
+        duration = 10;
+      } else if (duration) {
+        duration -= 1;
+      }
+      if (!condition || (!duration && suppressed)) {
+        state = false;
+      } else {
+        state = (condition == 1) ? !state : true;
+      }
+    }
+    return state;
+  }
+
+private:
+  bool state{false};
+  uint8_t blinks{0};
+  uint8_t condition{0};
+  uint8_t duration{0};
+};
+
+// The presses that the keypad package acts upon.  keypad.h also reports presses of combinations
+// that have no press action, which the package ignores as the lambda did.
+bool has_press_action(uint32_t keys) {
+  switch (keys) {
+    case KEY_UP: case KEY_DOWN: case KEY_RAIN: case KEY_POWER: case KEY_DIRECTION: case KEY_AUTO:
+    case KEY_4_ON: case KEY_4_OFF: case KEY_4_OPEN: case KEY_4_CLOSE: case KEY_COMBO_OPEN_CLOSE:
+    case KEY_COMBO_AUTO_UP: case KEY_COMBO_AUTO_DOWN: case KEY_COMBO_DIRECTION_UP: case KEY_COMBO_DIRECTION_DOWN:
+      return true;
+  }
+  return false;
+}
+
+std::vector<Event> acted_upon(const std::vector<Event>& events) {
+  std::vector<Event> result;
+  for (const Event& event : events) {
+    if (event.kind != Event::PRESS || has_press_action(event.keys)) result.push_back(event);
+  }
+  return result;
+}
+
+// keypad.h and the transcribed lambdas side by side, fed the same keys on the same clock.
+struct Twin {
+  scenario::Runner<> current;
+  scenario::Runner<LegacyKeypad, LegacyIndicator> legacy;
+  unsigned lit_mismatches{0};
+
+  uint32_t now_ms() const { return this->current.now_ms(); }
+  uint32_t keys() const { return this->current.keys(); }
+
+  void set_keys(uint32_t keys) {
+    this->current.set_keys(keys);
+    this->legacy.set_keys(keys);
+  }
+
+  void set_indicator(uint8_t condition, bool suppressed, uint8_t blinks) {
+    this->current.condition = this->legacy.condition = condition;
+    this->current.suppressed = this->legacy.suppressed = suppressed;
+    if (blinks) {
+      this->current.indicator.blink(blinks);
+      this->legacy.indicator.blink(blinks);
+    }
+  }
+
+  // Advances one indicator period at a time to compare the indicators on every tick
+  void advance_to(uint32_t t_ms) {
+    constexpr uint32_t PERIOD_MS = scenario::Runner<>::INDICATOR_MS;
+    for (uint32_t next = (this->now_ms() / PERIOD_MS + 1) * PERIOD_MS; next <= t_ms; next += PERIOD_MS) {
+      this->current.advance_to(next);
+      this->legacy.advance_to(next);
+      this->lit_mismatches += this->current.lit() != this->legacy.lit();
+    }
+    this->current.advance_to(t_ms);
+    this->legacy.advance_to(t_ms);
+  }
+};
+
+// Hold actions accept some holds and not others, as the real ones do depending on the menu
+bool some_holds(uint32_t keys, uint32_t hold_ms) { return (keys * 7 + hold_ms / 250) % 3 == 0; }
+
+// A random session that mostly stays on the keys and timings the keypad cares about: single keys
+// and combinations, taps with a modifier held, holds around the thresholds, chatter and glitches,
+// along with indicator conditions that change now and then.
+void random_session(Twin& twin, uint32_t seed, uint32_t duration_ms) {
+  std::mt19937 random(seed);
+  static constexpr uint32_t SINGLE_KEYS[] = {
+    KEY_UP, KEY_DOWN, KEY_RAIN, KEY_POWER, KEY_DIRECTION, KEY_AUTO, KEY_4_CLOSE, KEY_4_OPEN, KEY_4_OFF, KEY_4_ON,
+  };
+  static constexpr uint32_t DURATIONS[] = {5, 30, 45, 95, 105, 400, 795, 810, 1050, 3050, 5100, 15100};
+  const auto any_key = [&] { return SINGLE_KEYS[random() % std::size(SINGLE_KEYS)]; };
+  twin.current.hold_policy = twin.legacy.hold_policy = some_holds;
+  while (twin.now_ms() < duration_ms) {
+    const uint32_t kind = random() % 8;
+    uint32_t keys = twin.keys();
+    if (kind < 3) {
+      // Press a key on its own or add one that forms a combination
+      keys = keys ? keys | any_key() : any_key();
+      for (unsigned tries = 0; tries < 4 && !find_key(keys); tries++) keys = twin.keys() | any_key();
+    } else if (kind < 5) {
+      keys = random() % 3 ? 0 : keys & (keys - 1);  // release everything or all but the lowest key
+    } else if (kind == 5) {
+      keys ^= any_key();
+      twin.set_keys(keys);
+      twin.advance_to(twin.now_ms() + random() % 12);
+      keys ^= any_key();  // chatter
+    } else if (kind == 6) {
+      const uint8_t condition = random() % 3;
+      const bool suppressed = random() % 2;
+      twin.set_indicator(condition, suppressed, random() % 8 ? 0 : random() % 20);
+    } else if (keys == 0) {
+      // Taps of a key while a modifier is held
+      const uint32_t modifier = random() % 2 ? KEY_AUTO : KEY_DIRECTION;
+      twin.set_keys(modifier);
+      for (uint32_t taps = 1 + random() % 4; taps; taps--) {
+        twin.advance_to(twin.now_ms() + 60 + random() % 200);
+        twin.set_keys(modifier | any_key());
+        twin.advance_to(twin.now_ms() + 60 + random() % 900);
+        keys = modifier;
+        twin.set_keys(keys);
+      }
+    }
+    twin.set_keys(keys);
+    const uint32_t wait_ms = random() % 2 ? DURATIONS[random() % std::size(DURATIONS)] + random() % 25
+                                          : random() % 1500;
+    twin.advance_to(twin.now_ms() + wait_ms);
+  }
+}
+
+// Drives the keypad.h timing and the transcribed lambdas with the same sessions and checks that
+// the package acts upon the same keys at the same times and lights the indicator the same way.
+void test_matches_yaml_timing() {
+  constexpr unsigned SESSIONS = 200;
+  constexpr uint32_t SESSION_MS = 10 * 60 * 1000;
+  size_t reports[3] = {};
+  unsigned mismatches = 0;
+  for (unsigned session = 0; session < SESSIONS; session++) {
+    Twin twin;
+    random_session(twin, session, SESSION_MS);
+    const std::vector<Event> a = acted_upon(twin.current.events());
+    const std::vector<Event>& b = twin.legacy.events();
+    for (const Event& event : b) reports[event.kind]++;
+    if (a == b && twin.lit_mismatches == 0) continue;
+    if (mismatches++ < 3) {
+      size_t i = 0;
+      while (i < a.size() && i < b.size() && a[i] == b[i]) i++;
+      std::fprintf(stderr, "session %u: keypad.h %s, lambda %s, %u indicator ticks differ\n", session,
+          i < a.size() ? scenario::describe(a[i]).c_str() : "-", i < b.size() ? scenario::describe(b[i]).c_str() : "-",
+          twin.lit_mismatches);
+    }
+  }
+  // Every kind of report turns up often enough for the comparison to mean something
+  for (size_t count : reports) CHECK(count > SESSIONS);
+  CHECK(mismatches == 0);
+  std::printf("%u sessions of %u min, %zu presses, %zu holds, %zu taps, %u mismatches\n", SESSIONS,
+      SESSION_MS / 60000, reports[Event::PRESS], reports[Event::HOLD], reports[Event::TAPS], mismatches);
+}
+
+void benchmark() {
+  std::vector<const char*> scripts;
+  for (const auto& scenarios : SCENARIOS) {
+    scripts.insert(scripts.end(), scenarios.begin(), scenarios.end());
+  }
+  constexpr unsigned ROUNDS = 200;
+  const double ns = test::time_ns(ROUNDS, [&] {
+    for (const char* script : scripts) test::keep(scenario::run(script).size());
+  });
+  std::printf("%zu scenarios: %.0f scenarios/s\n", scripts.size(), scripts.size() / ns * 1e9);
+}
+
+}  // namespace
+
+int main() {
+  test_scenarios();
+  test_matches_yaml_timing();
+  benchmark();
+  return test::result();
+}
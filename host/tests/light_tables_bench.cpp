@@ -0,0 +1,130 @@
+// Checks that the channel tables write exactly the raw values that the per-pixel color correction
+// of the light would write, and compares the cost of rendering a frame both ways along with the
+// floating point correction that the tables replaced.
+#include "esphome.h"
+
+#include "accessory/light/addressable.h"
+#include "test.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace minuet::accessory::light;
+using esphome::light::AddressableLight;
+using esphome::light::LightState;
+
+namespace {
+
+// The strip of the light accessory: 57 SK6812 RGBW pixels.
+constexpr int32_t PIXELS = 57;
+constexpr float GAMMA = 2.8f;
+constexpr std::array<float, 4> MILLIAMPS_PER_CHANNEL{12.f, 12.f, 12.f, 12.f};
+constexpr std::array<float, 4> COLOR_CORRECT{1.f, 0.8f, 0.6f, 1.f};
+
+// Exposes the frame writers of the native effects.
+class Probe : public FrameEffect {
+public:
+  Probe() : FrameEffect("Probe", 50) {}
+  using FrameEffect::fill;
+  using FrameEffect::set;
+
+protected:
+  bool render(AddressableLight&, uint32_t, bool) override { return false; }
+};
+
+// Writes a frame through the color correction of the light, as lambda effects do.
+void fill_corrected(AddressableLight& it, const Color& color) {
+  for (int32_t i = 0; i < it.size(); i++) it[i] = color;
+}
+
+// Writes a frame correcting each channel in floating point.
+void fill_float(AddressableLight& it, const Color& color, const std::array<float, 4>& max_brightness,
+    float brightness) {
+  for (int32_t i = 0; i < it.size(); i++) {
+    auto pixel = it[i];
+    pixel.raw_set_color_correction(&g_channel_tables.identity());
+    Color raw;
+    for (unsigned c = 0; c < 4; c++) {
+      const float value = color.raw[c] / 255.f * max_brightness[c] * brightness;
+      raw.raw[c] = esphome::light::to_uint8_scale(esphome::light::gamma_correct(value, GAMMA));
+    }
+    pixel = raw;
+  }
+}
+
+Color frame_color(unsigned frame) {
+  return ESPHSVColor(frame & 0xff, 255, 255).to_rgb() * uint8_t(255 - (frame * 7 & 0x7f));
+}
+
+}  // namespace
+
+int main() {
+  AddressableLight it(PIXELS, GAMMA);
+  LightState light(&it);
+  light.current_values.set_state(true);
+  init_addressable(&light, MILLIAMPS_PER_CHANNEL, COLOR_CORRECT, GAMMA, PIXELS, 3);
+  it.set_correction(COLOR_CORRECT[0], COLOR_CORRECT[1], COLOR_CORRECT[2], COLOR_CORRECT[3]);
+
+  // Equivalence over every value of every channel at a range of brightnesses and power limiter scales.
+  unsigned mismatches = 0;
+  for (float scale : {1.f, 0.73f, 0.31f, 0.02f}) {
+    g_power_limiter.set_budget_milliamps(BOARD_SHARED_CURRENT_LIMIT_MILLIAMPS);
+    const Color max_brightness(esphome::light::to_uint8_scale(COLOR_CORRECT[0] * scale),
+        esphome::light::to_uint8_scale(COLOR_CORRECT[1] * scale),
+        esphome::light::to_uint8_scale(COLOR_CORRECT[2] * scale),
+        esphome::light::to_uint8_scale(COLOR_CORRECT[3] * scale));
+    it.set_correction(COLOR_CORRECT[0] * scale, COLOR_CORRECT[1] * scale, COLOR_CORRECT[2] * scale,
+        COLOR_CORRECT[3] * scale);
+    for (unsigned brightness = 0; brightness <= 255; brightness += 5) {
+      light.current_values.set_brightness(brightness / 255.f);
+      it.set_effect_active(true);
+      it.update_state(&light);
+      g_channel_tables.update(max_brightness, light.current_values);
+      for (unsigned value = 0; value < 256; value++) {
+        const Color color(value, 255 - value, value * 3 & 0xff, value ^ 0x5a);
+        fill_corrected(it, color);
+        const std::vector<uint8_t> expected = it.raw();
+        Probe::fill(it, color);
+        if (it.raw() != expected) mismatches++;
+        Probe::set(it, value % PIXELS, color);
+        if (it.raw() != expected) mismatches++;
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+
+  // Frame cost at full brightness with the power limiter scaling the color correction.
+  const float scale = 0.6f;
+  const std::array<float, 4> max_brightness{COLOR_CORRECT[0] * scale, COLOR_CORRECT[1] * scale,
+      COLOR_CORRECT[2] * scale, COLOR_CORRECT[3] * scale};
+  it.set_correction(max_brightness[0], max_brightness[1], max_brightness[2], max_brightness[3]);
+  light.current_values.set_brightness(1.f);
+  it.update_state(&light);
+  g_channel_tables.update(g_power_limiter.get_max_brightness(), light.current_values);
+
+  constexpr unsigned FRAMES = 20000;
+  unsigned frame = 0;
+  const double float_ns = test::time_ns(FRAMES, [&] {
+    fill_float(it, frame_color(frame++), max_brightness, 1.f);
+    test::keep(it.raw()[0]);
+  });
+  frame = 0;
+  const double corrected_ns = test::time_ns(FRAMES, [&] {
+    fill_corrected(it, frame_color(frame++));
+    test::keep(it.raw()[0]);
+  });
+  frame = 0;
+  const double tables_ns = test::time_ns(FRAMES, [&] {
+    Probe::fill(it, frame_color(frame++));
+    test::keep(it.raw()[0]);
+  });
+
+  std::printf("frame of %d RGBW pixels:\n", PIXELS);
+  std::printf("  float correction   %8.0f ns\n", float_ns);
+  std::printf("  per-pixel lookups  %8.0f ns\n", corrected_ns);
+  std::printf("  channel tables     %8.0f ns\n", tables_ns);
+  std::printf("  tables are %.1fx faster than float and %.2fx faster than per-pixel lookups\n",
+      float_ns / tables_ns, corrected_ns / tables_ns);
+  return test::result();
+}
@@ -0,0 +1,207 @@
+// Tests the safety lock aggregator and benchmarks storms of rapid source toggles against the
+// if/else chain that it replaced.
+#include "safety_lock.h"
+#include "test.h"
+
+#include <array>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using minuet::SafetyLock;
+
+namespace {
+
+void test_set_and_priority() {
+  SafetyLock lock;
+  CHECK(!lock.is_locked());
+  CHECK(lock.top_reason() == SafetyLock::REASON_COUNT);
+  CHECK(std::string(lock.top_reason_name()) == "None");
+  CHECK(lock.describe() == "None");
+
+  CHECK(lock.set(SafetyLock::MANUAL, true));
+  CHECK(!lock.set(SafetyLock::MANUAL, true));
+  CHECK(lock.is_locked());
+  CHECK(lock.top_reason() == SafetyLock::MANUAL);
+
+  CHECK(lock.set(SafetyLock::BATTERY, true));
+  CHECK(lock.top_reason() == SafetyLock::BATTERY);
+  CHECK(lock.mask() == (SafetyLock::bit(SafetyLock::BATTERY) | SafetyLock::bit(SafetyLock::MANUAL)));
+  CHECK(lock.describe() == "Battery, Manual");
+
+  CHECK(lock.set(SafetyLock::BATTERY, false));
+  CHECK(!lock.set(SafetyLock::BATTERY, false));
+  CHECK(lock.top_reason() == SafetyLock::MANUAL);
+  CHECK(lock.is_active(SafetyLock::MANUAL));
+  CHECK(!lock.is_active(SafetyLock::RAIN));
+
+  CHECK(lock.set(SafetyLock::MANUAL, false));
+  CHECK(!lock.is_locked());
+
+  // Every combination reports the highest priority reason, which has the lowest bit.
+  for (unsigned mask = 1; mask < (1u << SafetyLock::REASON_COUNT); mask++) {
+    SafetyLock combination;
+    for (unsigned reason = 0; reason < SafetyLock::REASON_COUNT; reason++) {
+      combination.set(SafetyLock::Reason(reason), mask & (1u << reason));
+    }
+    unsigned top = 0;
+    while (!(mask & (1u << top))) top++;
+    CHECK(combination.mask() == mask);
+    CHECK(combination.top_reason() == SafetyLock::Reason(top));
+    CHECK(std::string(combination.top_reason_name()) == SafetyLock::REASON_NAMES[top]);
+  }
+}
+
+void test_commit() {
+  SafetyLock lock;
+  CHECK(lock.commit() == 0);
+  lock.set(SafetyLock::RAIN, true);
+  CHECK(lock.commit() == 0);
+  CHECK(lock.commit() == SafetyLock::bit(SafetyLock::RAIN));
+  lock.set(SafetyLock::RAIN, false);
+  CHECK(lock.commit() == SafetyLock::bit(SafetyLock::RAIN));
+  CHECK(lock.commit() == 0);
+}
+
+// Models the safety lock update script and the entities that it publishes.
+struct Script {
+  SafetyLock& lock;
+  bool locked{false};
+  std::string reason{"None"};
+  std::string reasons{"None"};
+  unsigned runs{0};
+  unsigned engaged{0};
+  unsigned released{0};
+
+  void run() {
+    this->runs++;
+    const SafetyLock::Mask previous_mask = this->lock.commit();
+    const SafetyLock::Mask mask = this->lock.mask();
+    if (mask == previous_mask) return;
+    this->locked = mask != 0;
+    const char* reason = this->lock.top_reason_name();
+    if (this->reason != reason) this->reason = reason;
+    this->reasons = this->lock.describe();
+    if ((mask != 0) == (previous_mask != 0)) return;
+    (mask ? this->engaged : this->released)++;
+  }
+};
+
+// Toggles random sources in bursts and runs the queued scripts after each burst, as happens when
+// several sources change within one iteration of the main loop.  The actions must follow the
+// edges of the lock state as seen by the script, once per edge.
+void test_storm() {
+  SafetyLock lock;
+  Script script{lock};
+  std::mt19937 random(59);
+  unsigned queued = 0;
+  unsigned edges_engaged = 0;
+  unsigned edges_released = 0;
+  bool seen_locked = false;
+  for (unsigned burst = 0; burst < 20000; burst++) {
+    const unsigned toggles = random() % 4;
+    for (unsigned i = 0; i < toggles; i++) {
+      const auto reason = SafetyLock::Reason(random() % SafetyLock::REASON_COUNT);
+      if (lock.set(reason, random() % 2)) queued++;
+    }
+    // The script observes the mask when the first queued run happens; later runs see no change.
+    if (queued) {
+      if (lock.is_locked() != seen_locked) {
+        seen_locked = lock.is_locked();
+        (seen_locked ? edges_engaged : edges_released)++;
+      }
+    }
+    for (; queued; queued--) script.run();
+
+    CHECK(script.locked == lock.is_locked());
+    CHECK(script.reason == lock.top_reason_name());
+    CHECK(script.reasons == lock.describe());
+  }
+  CHECK(script.engaged == edges_engaged);
+  CHECK(script.released == edges_released);
+  CHECK(script.engaged > 0);
+}
+
+// The aggregation that the safety lock replaced: every source change queued the update script,
+// which walked the sources in priority order and compared the reason string.
+struct ChainScript {
+  bool states[SafetyLock::REASON_COUNT]{};
+  bool locked{false};
+  std::string reason{"None"};
+  unsigned actions{0};
+
+  void run() {
+    bool locked;
+    const char* reason;
+    if (this->states[0]) {
+      locked = true;
+      reason = "Battery";
+    } else if (this->states[1]) {
+      locked = true;
+      reason = "Rain";
+    } else if (this->states[2]) {
+      locked = true;
+      reason = "Accessory";
+    } else if (this->states[3]) {
+      locked = true;
+      reason = "Manual";
+    } else if (this->states[4]) {
+      locked = true;
+      reason = "Automation";
+    } else {
+      locked = false;
+      reason = "None";
+    }
+    this->locked = locked;
+    if (this->reason != reason) this->reason = reason;
+    this->actions++;  // the fan and thermostat actions ran on every run
+  }
+};
+
+void benchmark_storm() {
+  // A storm of source updates, most of which repeat the current state of their source, as a
+  // chattering rain sensor or battery voltage near a threshold produces.
+  constexpr unsigned EVENTS = 1 << 16;
+  static std::array<uint8_t, EVENTS> events;
+  std::mt19937 random(5959);
+  for (auto& event : events) {
+    const unsigned reason = random() % 8 < 6 ? 1 : random() % SafetyLock::REASON_COUNT;
+    event = uint8_t(reason << 1 | (random() % 4 == 0));
+  }
+
+  constexpr unsigned ROUNDS = 50;
+  ChainScript chain;
+  const double chain_ns = test::time_ns(ROUNDS, [&] {
+    for (uint8_t event : events) {
+      chain.states[event >> 1] = event & 1;
+      chain.run();
+    }
+    test::keep(chain.locked);
+  });
+
+  SafetyLock lock;
+  Script script{lock};
+  const double mask_ns = test::time_ns(ROUNDS, [&] {
+    for (uint8_t event : events) {
+      if (lock.set(SafetyLock::Reason(event >> 1), event & 1)) script.run();
+    }
+    test::keep(script.locked);
+  });
+
+  CHECK(chain.locked == script.locked);
+  CHECK(chain.reason == script.reason);
+  std::printf("storm of %u source updates:\n", EVENTS);
+  std::printf("  if/else chain  %8.1f ns/update, %u script runs and actions\n", chain_ns / EVENTS, chain.actions / ROUNDS);
+  std::printf("  bitmask        %8.1f ns/update, %u script runs, %u actions\n", mask_ns / EVENTS,
+      script.runs / ROUNDS, (script.engaged + script.released) / ROUNDS);
+}
+
+}  // namespace
+
+int main() {
+  test_set_and_priority();
+  test_commit();
+  test_storm();
+  benchmark_storm();
+  return test::result();
+}
@@ -0,0 +1,176 @@
+// Tests the sensor front end of the governor: median outlier rejection, slew limits, staleness and
+// the outdoor window, a fuzz run of random readings, and a benchmark of a reading through a channel.
+#include "cabin_sim.h"
+#include "test.h"
+
+#include <bit>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace governor = minuet::governor;
+using governor::Quality;
+using governor::SensorChannel;
+
+namespace {
+
+void test_rejects_spikes() {
+  SensorChannel channel{governor::kMaxRateCO2PPMPerS, governor::kStaleIndoorMs};
+  float value = 0;
+  CHECK(channel.read(0, value) == Quality::MISSING);
+  uint32_t t = 0;
+  for (; t < 60000; t += 5000) channel.push(600.0f, t);
+  CHECK(channel.read(t, value) == Quality::GOOD);
+  CHECK(value == 600.0f);
+
+  // Two spikes within the window don't move the median
+  channel.push(5000.0f, t += 5000);
+  channel.push(600.0f, t += 5000);
+  channel.push(5000.0f, t += 5000);
+  CHECK(channel.read(t, value) == Quality::GOOD);
+  CHECK(value == 600.0f);
+
+  // A step sustained for most of the window passes the median and is slew limited
+  for (int i = 0; i < governor::kMedianWindow; i++) channel.push(600.0f, t += 5000);
+  channel.push(2000.0f, t += 5000);
+  channel.push(2000.0f, t += 5000);
+  channel.push(2000.0f, t += 5000);
+  CHECK(channel.read(t, value) == Quality::LIMITED);
+  CHECK(value == 600.0f + governor::kMaxRateCO2PPMPerS * 5.0f);
+  for (int i = 0; i < 40; i++) channel.push(2000.0f, t += 5000);
+  CHECK(channel.read(t, value) == Quality::GOOD);
+  CHECK(value == 2000.0f);
+}
+
+void test_staleness() {
+  SensorChannel channel{governor::kMaxRateTempCPerS, governor::kStaleIndoorMs};
+  float value = 0;
+  channel.push(25.0f, 1000);
+  CHECK(channel.read(1000 + governor::kStaleIndoorMs, value) == Quality::GOOD);
+  CHECK(channel.read(1001 + governor::kStaleIndoorMs, value) == Quality::STALE);
+
+  // Non-finite readings don't refresh the channel
+  channel.push(NAN, 2000);
+  channel.push(INFINITY, 3000);
+  CHECK(channel.read(1001 + governor::kStaleIndoorMs, value) == Quality::STALE);
+  channel.push(25.5f, 2000 + governor::kStaleIndoorMs);
+  CHECK(channel.read(2000 + governor::kStaleIndoorMs, value) == Quality::GOOD);
+
+  // The stale check survives the millis() rollover
+  SensorChannel wrapping{governor::kMaxRateTempCPerS, governor::kStaleIndoorMs};
+  wrapping.push(25.0f, UINT32_MAX - 1000);
+  CHECK(wrapping.read(5000, value) == Quality::GOOD);
+  CHECK(wrapping.read(governor::kStaleIndoorMs, value) == Quality::STALE);
+}
+
+// The outdoor channels follow a step in a half-hourly weather feed with its next reading.
+void test_outdoor_step() {
+  const governor::SensorChannel& outdoor = governor::g_channel_Tout;
+  SensorChannel channel = outdoor;
+  channel.clear();
+  constexpr uint32_t kFeedPeriodMs = 30 * 60 * 1000;
+  uint32_t t = 0;
+  for (int i = 0; i < governor::kMedianWindow; i++) channel.push(20.0f, t += kFeedPeriodMs);
+  channel.push(25.0f, t += kFeedPeriodMs);
+  float value = 0;
+  CHECK(channel.read(t, value) == Quality::GOOD);
+  CHECK(value == 25.0f);
+}
+
+// A lone CO2 spike that used to slam the fan to full speed leaves it alone.
+void test_spike_in_closed_loop() {
+  sim::reset_governor();
+  sim::Cabin cabin{.q = 0.0f, .Tin = 22.0, .CO2 = 600.0};
+  sim::Thermostat thermostat{.target = 26.0f};
+  const auto calm = [](double) { return sim::Conditions{22.0f, 1.0f}; };
+  sim::run(cabin, thermostat, 0.25, calm);
+  const uint32_t now_ms = esphome::millis();
+  governor::g_channel_CO2.push(5000.0f, now_ms);
+  const governor::ControlOutput output = governor::update(thermostat.input(22.0f));
+  CHECK(!output.lid_open);
+  CHECK(output.fan_speed == 0);
+}
+
+// Feeds random readings, including non-finite and extreme values and random intervals, and checks
+// that the channel only ever reads as a finite value within the range of the finite readings.
+void test_fuzz() {
+  std::mt19937 random(69);
+  const float specials[] = {
+    NAN, INFINITY, -INFINITY, std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+    std::numeric_limits<float>::denorm_min(), -0.0f, 0.0f,
+  };
+  std::uniform_real_distribution<float> normal(-100.0f, 5000.0f);
+  std::uniform_int_distribution<uint32_t> interval(0, 2 * governor::kStaleIndoorMs);
+  for (int run = 0; run < 100; run++) {
+    SensorChannel channel{run % 2 ? governor::kMaxRateCO2PPMPerS : governor::kMaxRateTempCPerS,
+                          governor::kStaleIndoorMs, static_cast<uint8_t>(run % (governor::kMedianWindow + 1))};
+    uint32_t now_ms = random();
+    float lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < 10000; i++) {
+      const unsigned kind = random() % 16;
+      const float value = kind == 0 ? specials[random() % std::size(specials)]
+                        : kind == 1 ? std::bit_cast<float>(static_cast<uint32_t>(random()))
+                        : normal(random);
+      now_ms += kind == 2 ? interval(random) : random() % 10000;
+      channel.push(value, now_ms);
+      if (std::isfinite(value)) {
+        lo = std::min(lo, value);
+        hi = std::max(hi, value);
+      }
+      float out = NAN;
+      const Quality quality = channel.read(now_ms + random() % 1000, out);
+      if (quality >= Quality::LIMITED) {
+        if (!std::isfinite(out) || out < lo || out > hi) {
+          test::fail(__FILE__, __LINE__, "channel output out of range");
+          return;
+        }
+      } else {
+        CHECK(std::isfinite(lo) || quality == Quality::MISSING);
+      }
+    }
+  }
+}
+
+// The cost of a reading through the front end compared with reading the sensor state directly, as
+// read_sensors() did before.
+void benchmark() {
+  constexpr unsigned READINGS = 1 << 16;
+  std::vector<float> values(READINGS);
+  std::mt19937 random(690);
+  std::normal_distribution<float> noise(0.0f, 5.0f);
+  for (float& value : values) value = 800.0f + noise(random);
+
+  constexpr unsigned ROUNDS = 20;
+  float direct = 0;
+  const double direct_ns = test::time_ns(ROUNDS, [&] {
+    for (float value : values) {
+      direct = std::isfinite(value) ? value : direct;
+      test::keep(direct);
+    }
+  });
+  SensorChannel channel{governor::kMaxRateCO2PPMPerS, governor::kStaleIndoorMs};
+  uint32_t now_ms = 0;
+  const double channel_ns = test::time_ns(ROUNDS, [&] {
+    for (float value : values) {
+      channel.push(value, now_ms += 5000);
+      float out;
+      channel.read(now_ms, out);
+      test::keep(out);
+    }
+  });
+  std::printf("per reading: direct %.1f ns, median/slew/staleness channel %.1f ns\n", direct_ns / READINGS,
+      channel_ns / READINGS);
+}
+
+}  // namespace
+
+int main() {
+  test_rejects_spikes();
+  test_staleness();
+  test_outdoor_step();
+  test_spike_in_closed_loop();
+  test_fuzz();
+  benchmark();
+  return test::result();
+}
@@ -0,0 +1,53 @@
+// HOST TEST HELPERS
+//
+// Minimal checks and timing for the host tests.  Each test is a program whose exit status is the
+// result: failed checks are reported and counted, and main() returns test::result().
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace test {
+
+inline int g_failures{0};
+
+inline void fail(const char* file, int line, const char* what) {
+  std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+  g_failures++;
+}
+
+inline int result() {
+  if (g_failures) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+  return g_failures ? 1 : 0;
+}
+
+// Returns the average time in nanoseconds taken by one call of `func` over `iterations` calls.
+template <typename F>
+double time_ns(unsigned iterations, F&& func) {
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; i++) func();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+// Keeps the compiler from optimizing away a value that is only computed for timing.
+template <typename T>
+inline void keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+}  // namespace test
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) ::test::fail(__FILE__, __LINE__, #cond); \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+  do { \
+    if (!(std::fabs(double(a) - double(b)) <= double(tolerance))) { \
+      std::fprintf(stderr, "  %s = %g, %s = %g\n", #a, double(a), #b, double(b)); \
+      ::test::fail(__FILE__, __LINE__, #a " ~= " #b); \
+    } \
+  } while (0)
@@ -0,0 +1,137 @@
+// Simulates a cabin with a known thermal model and checks that the online identification
+// converges to it from a cold start, and that the learned model survives a save and load.
+#include "esphome.h"
+
+#include "governor.h"
+#include "test.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+// The synthetic cabin, with rates in °C/min: dTin/dt = a (Tout - Tin) + b L (Tout - Tin) + q.
+struct Cabin {
+  float a;
+  float b;
+  float q;
+  double Tin;
+
+  void step(float Tout, int level, float dt_min) {
+    this->Tin += (this->a + this->b * level) * (Tout - this->Tin) * dt_min + this->q * dt_min;
+  }
+};
+
+constexpr uint32_t kTickMs = 10 * 1000;  // governor updates in the simulation
+constexpr int kSubsteps = 10;
+
+// Outdoor temperature over the day, with a slow weather swing on top.
+float outdoor_temperature(uint32_t t_ms) {
+  const double hours = t_ms / 3.6e6;
+  return float(22.0 + 8.0 * std::sin(2.0 * M_PI * hours / 24.0) + 2.0 * std::sin(2.0 * M_PI * hours / 67.0));
+}
+
+// Runs the identification against a cabin for the given number of hours and returns the model.
+governor::ThermalModel identify(Cabin cabin, float hours, float noise_c, uint32_t seed, bool print) {
+  governor::reset();
+  governor::reset_model();
+  std::mt19937 random(seed);
+  std::normal_distribution<float> noise(0.0f, noise_c);
+  std::uniform_int_distribution<int> level_choice(0, governor::kMaxLevel);
+
+  int level = 0;
+  uint32_t next_level_ms = 0;
+  const uint32_t end_ms = uint32_t(hours * 3.6e6f);
+  for (uint32_t t_ms = 0; t_ms <= end_ms; t_ms += kTickMs) {
+    const float Tout = outdoor_temperature(t_ms);
+    // The fan changes level every 10 to 30 minutes, as the controllers would over a day.
+    if (t_ms >= next_level_ms) {
+      level = level_choice(random);
+      next_level_ms = t_ms + (10 + random() % 21) * 60 * 1000;
+    }
+
+    // Sensors quantize to 0.01 °C like most digital temperature sensors.
+    governor::SensorBundle b{};
+    b.has_Tin = b.has_Tout = true;
+    b.Tin = b.Tin_f = std::round((float(cabin.Tin) + noise(random)) * 100.0f) / 100.0f;
+    b.Tout = std::round(Tout * 100.0f) / 100.0f;
+    governor::identify_model(b, governor::g_state, t_ms);
+    governor::g_state.model_level = level;
+
+    for (int i = 0; i < kSubsteps; i++) cabin.step(Tout, level, kTickMs / 60000.0f / kSubsteps);
+
+    if (print && t_ms % (4 * 3600 * 1000) == 0 && t_ms) {
+      const auto& m = governor::g_model;
+      std::printf("  %5.1f h  n=%4u  tau=%6.1f min  b=%.4f  q=%+.4f  trusted=%d\n", t_ms / 3.6e6,
+          unsigned(m.samples), m.time_constant_min(), m.b(), m.q(), m.is_trusted());
+    }
+  }
+  return governor::g_model;
+}
+
+void test_converges_from_cold_start() {
+  const Cabin cabin{1.0f / 90.0f, 0.02f, 0.03f, 30.0};
+  std::printf("cabin: tau=%.1f min  b=%.4f  q=%+.4f\n", 1.0f / cabin.a, cabin.b, cabin.q);
+  const governor::ThermalModel m = identify(cabin, 48.0f, 0.0f, 62, true);
+
+  CHECK(m.is_trusted());
+  CHECK_NEAR(m.time_constant_min(), 90.0f, 9.0f);
+  CHECK_NEAR(m.b(), cabin.b, cabin.b * 0.1f);
+  CHECK_NEAR(m.q(), cabin.q, 0.005f);
+}
+
+void test_converges_with_noise() {
+  // A fast, leaky cabin with a noisy sensor.  The estimate is biased by the noise but still
+  // identifies the time constant and ventilation gain within a quarter of their true values.
+  const Cabin cabin{1.0f / 45.0f, 0.04f, 0.0f, 26.0};
+  std::printf("cabin: tau=%.1f min  b=%.4f  q=%+.4f  noise 0.03 °C\n", 1.0f / cabin.a, cabin.b, cabin.q);
+  const governor::ThermalModel m = identify(cabin, 48.0f, 0.03f, 63, true);
+
+  CHECK(m.is_trusted());
+  CHECK_NEAR(m.time_constant_min(), 45.0f, 45.0f * 0.25f);
+  CHECK_NEAR(m.b(), cabin.b, cabin.b * 0.25f);
+  CHECK_NEAR(m.q(), cabin.q, 0.02f);
+}
+
+void test_trusted_only_after_enough_samples() {
+  const Cabin cabin{1.0f / 90.0f, 0.02f, 0.03f, 30.0};
+  const governor::ThermalModel m = identify(cabin, 0.25f, 0.0f, 64, false);
+  CHECK(m.samples < governor::kModelMinSamples);
+  CHECK(!m.is_trusted());
+}
+
+void test_save_and_load() {
+  const Cabin cabin{1.0f / 90.0f, 0.02f, 0.03f, 30.0};
+  identify(cabin, 24.0f, 0.0f, 65, false);
+  const governor::ThermalModelRecord record = governor::save_model();
+  const governor::ThermalModel learned = governor::g_model;
+
+  governor::reset_model();
+  CHECK(!governor::g_model.is_trusted());
+  governor::load_model(record);
+  CHECK(governor::g_model.is_trusted());
+  CHECK(governor::g_model.a() == learned.a());
+  CHECK(governor::g_model.b() == learned.b());
+  CHECK(governor::g_model.q() == learned.q());
+  CHECK(governor::g_model.samples == learned.samples);
+
+  // The initial value of the global, as loaded before the globals are restored, is rejected and
+  // leaves the model alone.
+  governor::load_model(governor::ThermalModelRecord{});
+  CHECK(governor::g_model.samples == learned.samples);
+  governor::load_model({NAN, 0.02f, 0.0f, 100.0f});
+  CHECK(governor::g_model.samples == learned.samples);
+}
+
+}  // namespace
+
+int main() {
+  test_converges_from_cold_start();
+  test_converges_with_noise();
+  test_trusted_only_after_enough_samples();
+  test_save_and_load();
+  return test::result();
+}
@@ -0,0 +1,97 @@
+// Compares the PI thermal mode against the proportional mapping in closed loop on a simulated
+// cabin: the integrated absolute error, the level changes per hour and the fan energy.
+#include "cabin_sim.h"
+#include "test.h"
+
+#include <cstdio>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+struct Scenario {
+  const char* name;
+  sim::Cabin cabin;
+  ClimateFanMode fan_mode;
+  double hours;
+  float (*Tout)(double hours);
+};
+
+sim::Metrics run(const Scenario& scenario, governor::ThermalMode mode) {
+  sim::reset_governor();
+  governor::g_thermal_mode = mode;
+  sim::Cabin cabin = scenario.cabin;
+  sim::Thermostat thermostat{.target = 24.0f, .fan_mode = scenario.fan_mode};
+  const sim::Metrics metrics = sim::run(cabin, thermostat, scenario.hours,
+      [&](double t_h) { return sim::Conditions{scenario.Tout(t_h), 0.0f}; }, false);
+  governor::g_thermal_mode = governor::ThermalMode::PROPORTIONAL;
+  return metrics;
+}
+
+void print(const char* mode, const sim::Metrics& m) {
+  std::printf("  %-12s IAE %6.2f °C·h  offset %+5.2f °C  %5.1f level changes/h  energy %5.2f h\n", mode, m.iae_ch,
+      m.offset_c, m.level_changes_per_hour(), m.energy_h);
+}
+
+// A cool evening outside a cabin heated by the sun and its occupants: the proportional mapping
+// settles where its level balances the heat, above the target.
+float cool_evening(double) { return 21.0f; }
+
+// The outdoor temperature falls through the evening.
+float falling(double t_h) { return static_cast<float>(22.0 - 0.5 * t_h); }
+
+void test_removes_offset() {
+  const Scenario scenarios[] = {
+    {"cool evening, auto", {}, ClimateFanMode::CLIMATE_FAN_AUTO, 6.0, cool_evening},
+    {"falling outdoor, auto", {}, ClimateFanMode::CLIMATE_FAN_AUTO, 6.0, falling},
+    {"cool evening, quiet", {.q = 0.08f}, ClimateFanMode::CLIMATE_FAN_QUIET, 6.0, cool_evening},
+  };
+  for (const Scenario& scenario : scenarios) {
+    std::printf("%s\n", scenario.name);
+    const sim::Metrics p = run(scenario, governor::ThermalMode::PROPORTIONAL);
+    const sim::Metrics pi = run(scenario, governor::ThermalMode::PI);
+    print("proportional", p);
+    print("PI", pi);
+
+    CHECK(pi.iae_ch < p.iae_ch);
+    CHECK(std::fabs(pi.offset_c) < 0.5 * std::fabs(p.offset_c));
+    CHECK(pi.level_changes_per_hour() <= 12.0);
+  }
+}
+
+// The quiet cap holds the fan below what the heat needs for the first hours, then the sun sets.
+// Without anti-windup the integral would reach its clamp during the first hour and keep the fan at
+// the cap long after the load drops.
+void test_anti_windup() {
+  sim::reset_governor();
+  governor::g_thermal_mode = governor::ThermalMode::PI;
+  sim::Cabin cabin{.q = 0.35f, .Tin = 28.0};
+  sim::Thermostat thermostat{.target = 24.0f, .fan_mode = ClimateFanMode::CLIMATE_FAN_QUIET};
+  const auto Tout = [](double) { return sim::Conditions{18.0f, 0.0f}; };
+  sim::run(cabin, thermostat, 3.0, Tout, false);
+  std::printf("saturated for 3 h at the quiet cap: Tin %.2f °C, integral %.2f\n", cabin.Tin,
+      governor::g_state.thermal_integral);
+  CHECK(cabin.Tin > thermostat.target + 1.0f);
+  CHECK(governor::g_state.thermal_integral <= governor::g_config.max_level_quiet + 0.5f);
+
+  // Sunset: the load drops.  Once the cabin reaches the target the fan is already below the cap
+  // instead of running at it while a wound up integral drains.
+  cabin.q = 0.05f;
+  int level_at_target = -1;
+  for (int minute = 0; minute < 180 && level_at_target < 0; minute++) {
+    const sim::Metrics m = sim::run(cabin, thermostat, 1.0 / 60.0, Tout, false);
+    if (cabin.Tin <= thermostat.target) level_at_target = m.level;
+  }
+  std::printf("after sunset: level %d at the target\n", level_at_target);
+  CHECK(level_at_target >= 0);
+  CHECK(level_at_target < governor::g_config.max_level_quiet);
+  governor::g_thermal_mode = governor::ThermalMode::PROPORTIONAL;
+}
+
+}  // namespace
+
+int main() {
+  test_removes_offset();
+  test_anti_windup();
+  return test::result();
+}
@@ -0,0 +1,107 @@
+// Tests restoring the thermostat preset configurations, including the one-time migration of the
+// settings that earlier firmware versions stored for each settings entity.
+#include "esphome.h"
+
+#include "core.h"
+#include "test.h"
+
+#include <string>
+
+namespace {
+
+using esphome::EntityBase;
+using minuet::LidMode;
+
+struct PresetEntities {
+  EntityBase fan_mode{"thermostat_preset_home_fan_mode"};
+  EntityBase lid_mode{"thermostat_preset_home_lid_mode"};
+  EntityBase temperature{"thermostat_preset_home_temperature"};
+
+  minuet::LegacyThermostatPresetSettings load() {
+    return minuet::load_legacy_thermostat_preset_settings(&this->fan_mode, &this->lid_mode, &this->temperature);
+  }
+};
+
+template <typename T>
+void store_legacy(const EntityBase& entity, T value) {
+  auto pref = esphome::global_preferences->make_preference<T>(entity.get_object_id_hash());
+  pref.save(&value);
+}
+
+// Simulates a boot with the stored record and preferences as they are.
+void boot_home(PresetEntities& entities) {
+  host::thermostat.preset_config.clear();
+  minuet::init_thermostat_preset_config(CLIMATE_PRESET_HOME, CLIMATE_MODE_COOL, "Auto", "Auto", 25.f, entities.load());
+}
+
+void reset_storage() {
+  host::thermostat_preset_configs_raw.value() = {};
+  host::preferences().clear();
+}
+
+void test_defaults_without_legacy_settings() {
+  reset_storage();
+  PresetEntities entities;
+  boot_home(entities);
+  const auto& config = minuet::thermostat_preset_config(CLIMATE_PRESET_HOME);
+  CHECK(config.valid);
+  CHECK(config.mode == CLIMATE_MODE_COOL);
+  CHECK(config.fan_mode_index == 0);
+  CHECK(config.lid_mode == unsigned(LidMode::AUTO));
+  CHECK_NEAR(config.get_temperature(), 25.f, 0.001f);
+  CHECK(host::thermostat.preset_config.count(CLIMATE_PRESET_HOME) == 1);
+  CHECK_NEAR(host::thermostat.preset_config[CLIMATE_PRESET_HOME].default_temperature, 25.f, 0.001f);
+}
+
+void test_migrates_legacy_settings_once() {
+  reset_storage();
+  PresetEntities entities;
+  store_legacy<size_t>(entities.fan_mode, 2);  // Low
+  store_legacy<size_t>(entities.lid_mode, 1);  // Open
+  store_legacy<float>(entities.temperature, 23.5f);
+  boot_home(entities);
+
+  const auto& config = minuet::thermostat_preset_config(CLIMATE_PRESET_HOME);
+  CHECK(config.valid);
+  CHECK(config.get_fan_mode() == CLIMATE_FAN_LOW);
+  CHECK(minuet::get_thermostat_preset_lid_mode(CLIMATE_PRESET_HOME) == LidMode::OPEN);
+  CHECK_NEAR(config.get_temperature(), 23.5f, 0.001f);
+  CHECK(host::thermostat.preset_config[CLIMATE_PRESET_HOME].fan_mode_ == CLIMATE_FAN_LOW);
+
+  // Later changes are stored in the record, which takes precedence over the legacy settings.
+  minuet::thermostat_presets_ready = true;
+  minuet::set_thermostat_preset_config(CLIMATE_PRESET_HOME, CLIMATE_MODE_COOL, 1, LidMode::CLOSED, 27.f);
+  minuet::thermostat_presets_ready = false;
+  boot_home(entities);
+  CHECK(config.get_fan_mode() == CLIMATE_FAN_QUIET);
+  CHECK(minuet::get_thermostat_preset_lid_mode(CLIMATE_PRESET_HOME) == LidMode::CLOSED);
+  CHECK_NEAR(config.get_temperature(), 27.f, 0.001f);
+}
+
+void test_rejects_invalid_legacy_settings() {
+  reset_storage();
+  PresetEntities entities;
+  store_legacy<size_t>(entities.fan_mode, 7);
+  store_legacy<size_t>(entities.lid_mode, 2);  // Closed
+  store_legacy<float>(entities.temperature, NAN);
+  boot_home(entities);
+
+  const auto& config = minuet::thermostat_preset_config(CLIMATE_PRESET_HOME);
+  CHECK(config.fan_mode_index == 0);
+  CHECK(minuet::get_thermostat_preset_lid_mode(CLIMATE_PRESET_HOME) == LidMode::CLOSED);
+  CHECK_NEAR(config.get_temperature(), 25.f, 0.001f);
+
+  reset_storage();
+  store_legacy<float>(entities.temperature, 1e6f);
+  boot_home(entities);
+  CHECK_NEAR(config.get_temperature(), 25.f, 0.001f);
+}
+
+}  // namespace
+
+int main() {
+  test_defaults_without_legacy_settings();
+  test_migrates_legacy_settings_once();
+  test_rejects_invalid_legacy_settings();
+  return test::result();
+}
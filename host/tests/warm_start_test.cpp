@@ -0,0 +1,246 @@
+// Tests resuming the governor state from its RTC and flash snapshots across simulated resets and
+// power losses.
+#include "esphome.h"
+
+#include "governor.h"
+#include "test.h"
+
+namespace governor = minuet::governor;
+
+namespace {
+
+constexpr uint32_t kMaxAgeS = 600;
+
+// A wall clock as a time component provides it, once it's set.
+constexpr int64_t kEpochS = 1800000000;
+bool g_clock_set = false;
+int64_t g_boot_epoch_s = kEpochS;
+
+int64_t wall_clock_s() { return g_clock_set ? g_boot_epoch_s + host::g_time_us / 1000000 : 0; }
+
+// Runs for a while as automatic control does, leaving timestamps and latches in the state.
+void run_and_snapshot() {
+  governor::reset();
+  host::advance_ms(3600 * 1000);
+  governor::g_state.co2_active = true;
+  governor::g_state.thermal_integral = 3.5f;
+  governor::g_state.co2_history_count = 8;
+  governor::g_state.co2_history_last_ms = esphome::millis();
+  governor::g_state.co2_generation = 25.0f;
+  governor::g_state.thermal_pi_last_ms = esphome::millis();
+  governor::g_state.thermal_pi_dt_s = 1.0f;
+  governor::g_state.model_sampling = true;
+  governor::g_state.model_last_ms = esphome::millis() - 60000;
+  governor::g_state.model_level_last_ms = esphome::millis();
+  governor::g_state.model_level_ms = 12345.0f;
+  governor::snapshot();
+}
+
+// Also saves the snapshot to flash, which starts out empty.
+void run_and_persist() {
+  host::preferences().clear();
+  governor::restore_snapshot(kMaxAgeS);
+  run_and_snapshot();
+  governor::persist_snapshot();
+}
+
+// Boots after a reset and starts automatic control after the given delay.
+void boot(esp_reset_reason_t reason, uint32_t delay_ms = 5000) {
+  g_boot_epoch_s += host::g_time_us / 1000000;
+  host::restart();
+  host::g_reset_reason = reason;
+  governor::g_state = {};
+  host::advance_ms(100);
+  governor::restore_snapshot(kMaxAgeS);
+  host::advance_ms(delay_ms);
+  governor::start();
+}
+
+// Cuts the power for a while and boots when it returns.  The RTC timer restarts and RTC memory
+// loses its contents.
+void power_cycle(int64_t off_s, uint32_t delay_ms = 5000, esp_reset_reason_t reason = ESP_RST_POWERON) {
+  g_boot_epoch_s += host::g_time_us / 1000000 + off_s;
+  host::restart();
+  host::g_rtc_offset_us = 0;
+  std::memset(&governor::g_snapshot, 0xa5, sizeof(governor::g_snapshot));
+  host::g_reset_reason = reason;
+  governor::g_state = {};
+  host::advance_ms(100);
+  governor::restore_snapshot(kMaxAgeS);
+  host::advance_ms(delay_ms);
+  governor::start();
+}
+
+bool resumed() { return governor::g_state.co2_active && governor::g_state.thermal_integral == 3.5f; }
+
+void test_resumes_after_warm_resets() {
+  for (esp_reset_reason_t reason : {ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT}) {
+    run_and_snapshot();
+    boot(reason);
+    CHECK(resumed());
+
+    // Nothing sampled against the previous boot's clock carries over
+    const governor::GovernorState& st = governor::g_state;
+    CHECK(st.co2_history_count == 0);
+    CHECK(st.co2_history_last_ms == 0);
+    CHECK(std::isnan(st.co2_generation));
+    CHECK(st.thermal_pi_last_ms == 0);
+    CHECK(st.thermal_pi_dt_s == 0.0f);
+    CHECK(!st.model_sampling);
+    CHECK(st.model_last_ms == 0);
+    CHECK(st.model_level_last_ms == 0);
+    CHECK(st.model_level_ms == 0.0f);
+  }
+}
+
+void test_discards_after_other_resets() {
+  for (esp_reset_reason_t reason : {ESP_RST_POWERON, ESP_RST_BROWNOUT, ESP_RST_EXT, ESP_RST_DEEPSLEEP, ESP_RST_UNKNOWN}) {
+    run_and_snapshot();
+    boot(reason);
+    CHECK(!resumed());
+
+    // The snapshot is gone, so a later warm reset doesn't pick it up either
+    boot(ESP_RST_SW);
+    CHECK(!resumed());
+  }
+}
+
+void test_discards_old_snapshots() {
+  run_and_snapshot();
+  host::advance_ms((kMaxAgeS + 1) * 1000ull);
+  boot(ESP_RST_SW);
+  CHECK(!resumed());
+
+  // Too old by the time automatic control starts
+  run_and_snapshot();
+  boot(ESP_RST_SW, (kMaxAgeS + 1) * 1000);
+  CHECK(!resumed());
+}
+
+void test_discards_after_rtc_timer_restart() {
+  // The RTC timer restarted with the reset and has since counted past the stamp of a snapshot
+  // taken early in the previous boot, which would otherwise look a few seconds old.
+  host::g_rtc_offset_us = 0;
+  host::g_time_us = 0;
+  governor::reset();
+  host::advance_ms(2000);
+  governor::g_state.co2_active = true;
+  governor::g_state.thermal_integral = 3.5f;
+  governor::snapshot();
+  host::restart();
+  host::g_rtc_offset_us = 0;
+  host::g_reset_reason = ESP_RST_WDT;
+  governor::g_state = {};
+  host::advance_ms(5000);
+  CHECK(esp_rtc_get_time_us() > governor::g_snapshot.taken_us);
+  governor::restore_snapshot(kMaxAgeS);
+  governor::start();
+  CHECK(!resumed());
+}
+
+void test_discards_corrupt_snapshots() {
+  run_and_snapshot();
+  governor::g_snapshot.state[0] ^= 1;
+  boot(ESP_RST_PANIC);
+  CHECK(!resumed());
+}
+
+void test_resumes_after_power_blip() {
+  governor::g_wall_clock_s = wall_clock_s;
+  g_clock_set = true;
+  for (esp_reset_reason_t reason : {ESP_RST_POWERON, ESP_RST_BROWNOUT}) {
+    run_and_persist();
+    power_cycle(30, 5000, reason);
+    CHECK(resumed());
+    CHECK(governor::g_state.co2_history_count == 0);
+    CHECK(std::isnan(governor::g_state.co2_generation));
+
+    // Only once
+    power_cycle(30);
+    CHECK(!resumed());
+  }
+
+  // Too long without power by the wall clock
+  run_and_persist();
+  power_cycle(kMaxAgeS);
+  CHECK(!resumed());
+  run_and_persist();
+  power_cycle(30, kMaxAgeS * 1000);
+  CHECK(!resumed());
+  governor::g_wall_clock_s = nullptr;
+  g_clock_set = false;
+}
+
+void test_resumes_after_power_blip_without_clock() {
+  // Without a wall clock, or before it's set, the snapshot is taken as fresh shortly after the boot
+  governor::g_wall_clock_s = wall_clock_s;
+  run_and_persist();
+  power_cycle(3600);
+  CHECK(resumed());
+  power_cycle(30);
+  CHECK(!resumed());
+
+  governor::g_wall_clock_s = nullptr;
+  run_and_persist();
+  power_cycle(30);
+  CHECK(resumed());
+  run_and_persist();
+  power_cycle(30, (kMaxAgeS + 1) * 1000);
+  CHECK(!resumed());
+
+  // A snapshot saved before the clock was set can't be dated later
+  governor::g_wall_clock_s = wall_clock_s;
+  run_and_persist();
+  g_clock_set = true;
+  power_cycle(3600);
+  CHECK(resumed());
+  governor::g_wall_clock_s = nullptr;
+  g_clock_set = false;
+}
+
+void test_prefers_rtc_snapshot() {
+  // After a software reset the RTC snapshot is the more recent one, and the one in flash is spent
+  run_and_persist();
+  governor::g_state.thermal_integral = 5.0f;
+  governor::snapshot();
+  boot(ESP_RST_SW);
+  CHECK(governor::g_state.co2_active && governor::g_state.thermal_integral == 5.0f);
+  power_cycle(30);
+  CHECK(!resumed());
+
+  // Without an RTC snapshot, the one in flash is resumed
+  run_and_persist();
+  governor::discard_snapshot();
+  governor::persist_snapshot();
+  governor::g_snapshot.magic = 0;
+  boot(ESP_RST_SW);
+  CHECK(resumed());
+}
+
+void test_discard_erases_flash() {
+  run_and_persist();
+  governor::discard_snapshot();
+  power_cycle(30);
+  CHECK(!resumed());
+
+  // And a corrupt record isn't resumed either
+  run_and_persist();
+  host::preferences().begin()->second[20] ^= 1;
+  power_cycle(30);
+  CHECK(!resumed());
+}
+
+}  // namespace
+
+int main() {
+  test_resumes_after_warm_resets();
+  test_discards_after_other_resets();
+  test_discards_old_snapshots();
+  test_discards_after_rtc_timer_restart();
+  test_discards_corrupt_snapshots();
+  test_resumes_after_power_blip();
+  test_resumes_after_power_blip_without_clock();
+  test_prefers_rtc_snapshot();
+  test_discard_erases_flash();
+  return test::result();
+}
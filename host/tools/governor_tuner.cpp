@@ -0,0 +1,291 @@
+// GOVERNOR TUNER
+//
+// Sweeps the tunable parameters of the governor with a random search, runs each configuration
+// through the closed-loop cabin simulation on a set of scenarios, and ranks the configurations on
+// the Pareto front of fan energy, discomfort and level churn.  The best configuration is printed
+// as the minuet_governor_config substitution.
+//
+// The governor keeps its state in module globals as it does on the device, so the configurations
+// are evaluated by a pool of worker processes rather than threads, one per core by default.  The
+// targets are preferences rather than tunables, so they are not swept; discomfort is measured
+// against them.  The cabin has no humidity, so the RH parameters keep their defaults.
+//
+// Usage: governor_tuner [--samples N] [--jobs N] [--hours H] [--seed S]
+//                       [--energy-weight W] [--churn-weight W] [--scaling]
+#include "cabin_sim.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace governor = minuet::governor;
+
+namespace {
+
+// A swept parameter and its range.
+struct Parameter {
+  float governor::GovernorConfig::*field;
+  float lo;
+  float hi;
+};
+
+constexpr Parameter kParameters[] = {
+  {&governor::GovernorConfig::span_auto_c, 2.0f, 8.0f},
+  {&governor::GovernorConfig::span_quiet_c, 2.0f, 8.0f},
+  {&governor::GovernorConfig::gamma_auto, 0.5f, 2.5f},
+  {&governor::GovernorConfig::gamma_quiet, 1.0f, 3.5f},
+  {&governor::GovernorConfig::co2_deadband_ppm, 25.0f, 150.0f},
+  {&governor::GovernorConfig::co2_span_ppm, 200.0f, 800.0f},
+  {&governor::GovernorConfig::co2_gamma, 0.5f, 2.5f},
+};
+constexpr int kMaxLevelQuietLo = 4;
+constexpr int kMaxLevelQuietHi = 8;
+
+// Discomfort adds the CO2 above the target to the temperature error at 100 ppm·h per °C·h.
+constexpr double kCO2PerDegree = 100.0;
+
+struct Scenario {
+  const char* name;
+  sim::Cabin cabin;
+  ClimateFanMode fan_mode;
+  double hours;
+  sim::Conditions (*conditions)(double hours);
+};
+
+// A warm day with two occupants, four in the evening.
+sim::Conditions sunny_day(double t_h) {
+  const float Tout = static_cast<float>(17.0 + 9.0 * std::sin(M_PI * (t_h - 1.0) / 16.0));
+  const float occupants = t_h >= 11.0 ? 4.0f : 2.0f;
+  return {Tout, 7.0f * occupants};
+}
+
+// A cool night with two people sleeping, using the quiet fan mode.
+sim::Conditions quiet_night(double t_h) { return {static_cast<float>(19.0 - 0.4 * t_h), 12.0f}; }
+
+// A hot afternoon where the outdoor temperature limits what the fan can do.
+sim::Conditions hot_afternoon(double t_h) {
+  return {static_cast<float>(29.0 + 2.0 * std::sin(M_PI * t_h / 8.0)), t_h < 2.0 ? 0.0f : 21.0f};
+}
+
+const Scenario kScenarios[] = {
+  {"sunny day", {.q = 0.12f, .Tin = 24.0}, ClimateFanMode::CLIMATE_FAN_AUTO, 16.0, sunny_day},
+  {"quiet night", {.q = 0.06f, .Tin = 26.0}, ClimateFanMode::CLIMATE_FAN_QUIET, 8.0, quiet_night},
+  {"hot afternoon", {.q = 0.1f, .Tin = 30.0}, ClimateFanMode::CLIMATE_FAN_AUTO, 8.0, hot_afternoon},
+};
+
+// The result of a configuration, summed over the scenarios.
+struct Result {
+  double energy_h;
+  double discomfort;
+  double churn;  // level changes per hour
+  double score;
+  int rank;  // Pareto front, 0 for the non-dominated configurations
+};
+
+Result evaluate(const governor::GovernorConfig& config, double hours_scale) {
+  Result result{};
+  double hours = 0;
+  for (const Scenario& scenario : kScenarios) {
+    sim::reset_governor();
+    governor::reset_model();
+    governor::set_config(config);
+    sim::Cabin cabin = scenario.cabin;
+    sim::Thermostat thermostat{.target = 24.0f, .fan_mode = scenario.fan_mode};
+    const double scenario_hours = scenario.hours * hours_scale;
+    const sim::Metrics m = sim::run(cabin, thermostat, scenario_hours, scenario.conditions);
+    result.energy_h += m.energy_h;
+    result.discomfort += m.iae_ch + m.co2_excess_ppmh / kCO2PerDegree;
+    result.churn += m.level_changes;
+    hours += scenario_hours;
+  }
+  result.churn /= hours;
+  return result;
+}
+
+// Draws a configuration uniformly from the parameter ranges.
+governor::GovernorConfig draw(std::mt19937& random) {
+  governor::GovernorConfig config{};
+  for (const Parameter& p : kParameters) config.*p.field = std::uniform_real_distribution<float>(p.lo, p.hi)(random);
+  config.max_level_quiet = std::uniform_int_distribution<int>(kMaxLevelQuietLo, kMaxLevelQuietHi)(random);
+  // Round to what the configuration is typed as
+  for (const Parameter& p : kParameters) config.*p.field = std::round(config.*p.field * 100.0f) / 100.0f;
+  return config;
+}
+
+// Evaluates the configurations on `jobs` worker processes.  The workers take the next index from a
+// shared counter and write their results into shared memory.
+bool evaluate_all(const std::vector<governor::GovernorConfig>& configs, std::vector<Result>& results, int jobs,
+                  double hours_scale) {
+  struct Shared {
+    std::atomic<size_t> next;
+  };
+  const size_t bytes = sizeof(Shared) + configs.size() * sizeof(Result);
+  void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    std::perror("mmap");
+    return false;
+  }
+  auto* shared = new (memory) Shared{};
+  auto* shared_results = reinterpret_cast<Result*>(static_cast<char*>(memory) + sizeof(Shared));
+
+  std::vector<pid_t> workers;
+  for (int j = 0; j < jobs; j++) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+      std::perror("fork");
+      break;
+    }
+    if (pid == 0) {
+      for (size_t i; (i = shared->next.fetch_add(1)) < configs.size();) {
+        shared_results[i] = evaluate(configs[i], hours_scale);
+      }
+      _exit(0);
+    }
+    workers.push_back(pid);
+  }
+  bool ok = !workers.empty();
+  for (pid_t pid : workers) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  results.assign(shared_results, shared_results + configs.size());
+  munmap(memory, bytes);
+  return ok;
+}
+
+bool dominates(const Result& a, const Result& b) {
+  const bool no_worse = a.energy_h <= b.energy_h && a.discomfort <= b.discomfort && a.churn <= b.churn;
+  const bool better = a.energy_h < b.energy_h || a.discomfort < b.discomfort || a.churn < b.churn;
+  return no_worse && better;
+}
+
+// Sorts the results into successive Pareto fronts and scores them by the weighted sum.
+void rank(std::vector<Result>& results, double energy_weight, double churn_weight) {
+  for (Result& r : results) {
+    r.score = r.discomfort + energy_weight * r.energy_h + churn_weight * r.churn;
+    r.rank = -1;
+  }
+  size_t ranked = 0;
+  for (int front = 0; ranked < results.size(); front++) {
+    std::vector<size_t> members;
+    for (size_t i = 0; i < results.size(); i++) {
+      if (results[i].rank >= 0) continue;
+      bool dominated = false;
+      for (size_t j = 0; j < results.size() && !dominated; j++) {
+        dominated = j != i && results[j].rank < 0 && dominates(results[j], results[i]);
+      }
+      if (!dominated) members.push_back(i);
+    }
+    for (size_t i : members) results[i].rank = front;
+    ranked += members.size();
+  }
+}
+
+void usage() {
+  std::fprintf(stderr,
+      "usage: governor_tuner [--samples N] [--jobs N] [--hours H] [--seed S]\n"
+      "                      [--energy-weight W] [--churn-weight W] [--scaling]\n"
+      "  --samples N        random configurations to evaluate besides the defaults (128)\n"
+      "  --jobs N           worker processes (one per core)\n"
+      "  --hours H          scale of the scenario durations (1)\n"
+      "  --seed S           seed of the random search (71)\n"
+      "  --energy-weight W  discomfort per hour of full-speed fan energy when scoring (2)\n"
+      "  --churn-weight W   discomfort per level change per hour when scoring (0.5)\n"
+      "  --scaling          also report the throughput for 1 to N jobs\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int samples = 128;
+  int jobs = static_cast<int>(std::max(1L, sysconf(_SC_NPROCESSORS_ONLN)));
+  double hours_scale = 1.0;
+  unsigned seed = 71;
+  double energy_weight = 2.0;
+  double churn_weight = 0.5;
+  bool scaling = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--samples" && has_value) samples = std::atoi(argv[++i]);
+    else if (arg == "--jobs" && has_value) jobs = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--hours" && has_value) hours_scale = std::atof(argv[++i]);
+    else if (arg == "--seed" && has_value) seed = static_cast<unsigned>(std::atoi(argv[++i]));
+    else if (arg == "--energy-weight" && has_value) energy_weight = std::atof(argv[++i]);
+    else if (arg == "--churn-weight" && has_value) churn_weight = std::atof(argv[++i]);
+    else if (arg == "--scaling") scaling = true;
+    else if (arg == "--help") {
+      usage();
+      return 0;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (samples < 0 || !(hours_scale > 0.0)) {
+    usage();
+    return 2;
+  }
+
+  // The defaults come first so that every configuration can be compared with them
+  std::mt19937 random(seed);
+  std::vector<governor::GovernorConfig> configs{governor::GovernorConfig{}};
+  for (int i = 0; i < samples; i++) configs.push_back(draw(random));
+
+  std::vector<Result> results;
+  const auto start = std::chrono::steady_clock::now();
+  if (!evaluate_all(configs, results, jobs, hours_scale)) {
+    std::fprintf(stderr, "a worker failed\n");
+    return 1;
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%zu configurations on %d jobs in %.1f s, %.2f configurations/s\n", configs.size(), jobs, seconds,
+      configs.size() / seconds);
+
+  if (scaling) {
+    const std::vector<governor::GovernorConfig> subset(configs.begin(),
+        configs.begin() + std::min<size_t>(configs.size(), 4 * jobs));
+    for (int j = 1; j <= jobs; j++) {
+      std::vector<Result> ignored;
+      const auto t0 = std::chrono::steady_clock::now();
+      evaluate_all(subset, ignored, j, hours_scale);
+      const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      std::printf("  %2d jobs: %.2f configurations/s\n", j, subset.size() / s);
+    }
+  }
+
+  rank(results, energy_weight, churn_weight);
+  std::vector<size_t> order(configs.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return results[a].rank != results[b].rank ? results[a].rank < results[b].rank : results[a].score < results[b].score;
+  });
+
+  const Result& defaults = results[0];
+  std::printf("\n%4s %5s %9s %11s %9s %8s\n", "", "front", "energy", "discomfort", "churn", "score");
+  const auto print = [&](const char* label, const Result& r) {
+    std::printf("%4s %5d %7.2f h %8.2f °C·h %6.1f /h %8.2f\n", label, r.rank, r.energy_h, r.discomfort, r.churn,
+        r.score);
+  };
+  print("def", defaults);
+  for (size_t k = 0; k < std::min<size_t>(order.size(), 10); k++) print(std::to_string(k + 1).c_str(), results[order[k]]);
+
+  // The best scoring configuration on the first front
+  const size_t best = order[0];
+  std::printf("\nBest configuration (%s the defaults):\n", best == 0 ? "keeps" : "replaces");
+  const std::string config = governor::describe_config(configs[best]);
+  std::printf("  YAML: minuet_governor_config: \"%s\"\n", config.c_str());
+  std::printf("  C++:  minuet::governor::GovernorConfig%s\n", config.c_str());
+  return 0;
+}
@@ -0,0 +1,610 @@
+// MINUET ADDRESSABLE LIGHT ACCESSORY
+//
+// Power limiting and native effects for the addressable LED strip.
+//
+// The native effects render directly into the pixel buffer.  Unlike lambda effects, they do not
+// issue light calls so they bypass the light state machine and transitions entirely and cost
+// little more than writing the pixels.
+#pragma once
+
+#include "esphome/components/light/addressable_light.h"
+#include "esphome/components/light/addressable_light_effect.h"
+#include "esphome/components/light/esp_hsv_color.h"
+#include "esphome/components/light/light_state.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace minuet {
+namespace accessory {
+namespace light {
+
+using esphome::Color;
+using esphome::light::AddressableLight;
+using esphome::light::ESPHSVColor;
+using esphome::light::LightState;
+
+// -----------------------------------------------------------------------------
+// Power limiter
+// -----------------------------------------------------------------------------
+
+// The Minuet PCB traces are rated for about 4 A and the supply is protected with a 4 A polyfuse
+// shared by the fan motor, the light, and the rest of the board.  This constant is the current
+// that the light and the fan motor may draw together, less a margin for the rest of the board.
+constexpr float BOARD_SHARED_CURRENT_LIMIT_MILLIAMPS = 3500.f;
+
+// The light is allowed at least this much current even while the fan draws a lot so that it
+// never goes completely dark.
+constexpr float MIN_CURRENT_BUDGET_MILLIAMPS = 50.f;
+
+// Estimates the current drawn by the LED strip from the pixel buffer and scales the brightness of
+// the whole frame to keep the current within a budget.
+//
+// The estimate sums the raw value of each channel of each pixel weighted by the current drawn by
+// that channel at full output as given in the strip configuration.  Raw values already include
+// gamma and color correction so they are proportional to the PWM duty cycle of each LED.
+//
+// The frame is scaled by reducing the maximum brightness of the color correction so effects
+// and transitions don't need to know about the limiter.  Because the scale is applied before
+// gamma correction, the current varies with the scale raised to the power of gamma.
+class PowerLimiter {
+public:
+  void init(LightState* light, const std::array<float, 4>& milliamps_per_channel,
+      const std::array<float, 4>& color_correct, float gamma) {
+    this->light_ = light;
+    this->milliamps_per_channel_ = milliamps_per_channel;
+    this->color_correct_ = color_correct;
+    this->gamma_ = gamma;
+  }
+
+  // Sets the current budget chosen by the user.
+  void set_budget_milliamps(float budget) { this->budget_milliamps_ = budget; }
+
+  // Sets the most recent fan motor bus current reading.  The budget shrinks while the fan draws more current.
+  void set_fan_bus_current(float amps) {
+    if (!std::isnan(amps)) {
+      this->fan_milliamps_ = amps * 1000.f;
+    }
+  }
+
+  // Returns the budget after accounting for the current drawn by the fan.
+  float get_effective_budget_milliamps() const {
+    return std::max(std::min(this->budget_milliamps_, BOARD_SHARED_CURRENT_LIMIT_MILLIAMPS - this->fan_milliamps_),
+        MIN_CURRENT_BUDGET_MILLIAMPS);
+  }
+
+  float get_estimated_milliamps() const { return this->estimated_milliamps_; }
+  float get_scale() const { return this->scale_; }
+
+  // Returns the maximum brightness of each channel in the color correction after scaling.
+  Color get_max_brightness() const {
+    const auto& cc = this->color_correct_;
+    return Color(esphome::light::to_uint8_scale(cc[0] * this->scale_), esphome::light::to_uint8_scale(cc[1] * this->scale_),
+        esphome::light::to_uint8_scale(cc[2] * this->scale_), esphome::light::to_uint8_scale(cc[3] * this->scale_));
+  }
+
+  // Estimates the current drawn by the frame in the pixel buffer and adjusts the scale for subsequent frames.
+  void update();
+
+private:
+  // The scale increases by no more than this factor per update to avoid oscillation when the
+  // estimate is imprecise because the raw values are small.
+  static constexpr float MAX_SCALE_STEP_UP = 1.1f;
+  static constexpr float MIN_SCALE = 0.02f;
+
+  float estimate_milliamps_(AddressableLight& it) const;
+  void apply_scale_(AddressableLight& it, float scale);
+
+  LightState* light_{nullptr};
+  std::array<float, 4> milliamps_per_channel_{};
+  std::array<float, 4> color_correct_{1.f, 1.f, 1.f, 1.f};
+  float gamma_{1.f};
+  float budget_milliamps_{BOARD_SHARED_CURRENT_LIMIT_MILLIAMPS};
+  float fan_milliamps_{0.f};
+  float estimated_milliamps_{0.f};
+  float scale_{1.f};
+};
+
+void PowerLimiter::update() {
+  if (!this->light_) return;
+  auto& it = *static_cast<AddressableLight*>(this->light_->get_output());
+  if (!this->light_->current_values.is_on()) {
+    this->estimated_milliamps_ = 0.f;
+    return;
+  }
+
+  this->estimated_milliamps_ = this->estimate_milliamps_(it);
+  const float demand = this->estimated_milliamps_ / std::pow(this->scale_, this->gamma_);
+  const float budget = this->get_effective_budget_milliamps();
+  float scale = demand > budget ? std::pow(budget / demand, 1.f / this->gamma_) : 1.f;
+  scale = std::max(std::min(scale, this->scale_ * MAX_SCALE_STEP_UP), MIN_SCALE);
+
+  // Reduce the scale immediately but only increase it when the change is noticeable.
+  if (scale < this->scale_ || scale > this->scale_ * 1.02f || (scale == 1.f && this->scale_ != 1.f)) {
+    this->apply_scale_(it, scale);
+  }
+}
+
+float PowerLimiter::estimate_milliamps_(AddressableLight& it) const {
+  uint32_t red = 0, green = 0, blue = 0, white = 0;
+  for (int32_t i = 0; i < it.size(); i++) {
+    auto pixel = it[i];
+    red += pixel.get_red_raw();
+    green += pixel.get_green_raw();
+    blue += pixel.get_blue_raw();
+    white += pixel.get_white_raw();
+  }
+  const auto& ma = this->milliamps_per_channel_;
+  return (red * ma[0] + green * ma[1] + blue * ma[2] + white * ma[3]) / 255.f;
+}
+
+void PowerLimiter::apply_scale_(AddressableLight& it, float scale) {
+  this->scale_ = scale;
+  const auto& cc = this->color_correct_;
+  it.set_correction(cc[0] * scale, cc[1] * scale, cc[2] * scale, cc[3] * scale);
+
+  // Effects redraw with the new correction on their next frame but a static color must be redrawn now.
+  if (!it.is_effect_active()) {
+    it.update_state(this->light_);
+  }
+}
+
+inline PowerLimiter g_power_limiter{};
+
+// -----------------------------------------------------------------------------
+// Channel tables
+// -----------------------------------------------------------------------------
+
+// Maps the value of each color channel directly to the raw value written to the pixel buffer.
+//
+// The light corrects every channel of every pixel as it is written by scaling it twice, by the
+// maximum brightness of the channel and by the brightness of the light, then applying gamma.
+// The tables combine all three into a single lookup with exactly the same result.  They are
+// rebuilt only when the brightness or the color correction changes, which costs a few
+// thousand integer operations, so the native effects never apply the correction per pixel.
+class ChannelTables {
+public:
+  void init(float gamma) {
+    this->correction_.calc_gamma_table(gamma);
+    this->identity_.calc_gamma_table(1.f);
+    this->valid_ = false;
+  }
+
+  // Rebuilds the tables if the maximum brightness or the brightness of the light changed.
+  // Returns true if the tables changed.
+  bool update(const Color& max_brightness, const esphome::light::LightColorValues& values) {
+    const uint8_t local_brightness = esphome::light::to_uint8_scale(values.get_brightness() * values.get_state());
+    if (this->valid_ && max_brightness == this->max_brightness_ && local_brightness == this->local_brightness_) {
+      return false;
+    }
+    this->max_brightness_ = max_brightness;
+    this->local_brightness_ = local_brightness;
+    this->valid_ = true;
+    this->correction_.set_max_brightness(max_brightness);
+    this->correction_.set_local_brightness(local_brightness);
+    for (unsigned value = 0; value < 256; value++) {
+      this->red_[value] = this->correction_.color_correct_red(value);
+      this->green_[value] = this->correction_.color_correct_green(value);
+      this->blue_[value] = this->correction_.color_correct_blue(value);
+      this->white_[value] = this->correction_.color_correct_white(value);
+    }
+    return true;
+  }
+
+  Color to_raw(const Color& color) const {
+    return Color(this->red_[color.r], this->green_[color.g], this->blue_[color.b], this->white_[color.w]);
+  }
+
+  // A correction that leaves values unchanged, for writing raw values to the pixel buffer.
+  const esphome::light::ESPColorCorrection& identity() const { return this->identity_; }
+
+private:
+  esphome::light::ESPColorCorrection correction_;
+  esphome::light::ESPColorCorrection identity_;
+  Color max_brightness_{};
+  uint8_t local_brightness_{0};
+  bool valid_{false};
+  std::array<uint8_t, 256> red_{};
+  std::array<uint8_t, 256> green_{};
+  std::array<uint8_t, 256> blue_{};
+  std::array<uint8_t, 256> white_{};
+};
+
+inline ChannelTables g_channel_tables{};
+
+// -----------------------------------------------------------------------------
+// Frame scheduler
+// -----------------------------------------------------------------------------
+
+// Accumulates the time spent rendering frames for diagnostics.
+struct FrameStats {
+  uint32_t total_us{0};
+  uint32_t frames{0};
+
+  void add(uint32_t elapsed_us) {
+    this->total_us += elapsed_us;
+    this->frames++;
+  }
+
+  // Returns the average time spent rendering a frame since the last call or NAN if no frames were rendered.
+  float take_average_us() {
+    const float average = this->frames ? float(this->total_us) / this->frames : NAN;
+    *this = {};
+    return average;
+  }
+};
+
+inline FrameStats g_frame_stats{};
+
+// An effect that renders frames at a target rate and only shows frames that changed.
+class FrameEffect : public esphome::light::AddressableLightEffect {
+public:
+  FrameEffect(const char* name, uint32_t frames_per_second)
+      : AddressableLightEffect(name), frame_interval_ms_(1000 / frames_per_second) {}
+
+  void start() override {
+    AddressableLightEffect::start();
+    this->force_redraw_ = true;
+  }
+
+  void apply(AddressableLight& it, const Color& current_color) override {
+    const uint32_t now = esphome::millis();
+    if (!this->force_redraw_ && now - this->last_frame_ms_ < this->frame_interval_ms_) return;
+    this->last_frame_ms_ = now;
+
+    // The brightness and color correction are applied when pixels are written so a change requires a redraw.
+    if (g_channel_tables.update(g_power_limiter.get_max_brightness(), this->state_->current_values)) {
+      this->force_redraw_ = true;
+    }
+    if (!(current_color == this->current_color_)) {
+      this->current_color_ = current_color;
+      this->force_redraw_ = true;
+    }
+
+    const uint32_t start_us = esphome::micros();
+    if (this->render(it, now, this->force_redraw_)) {
+      it.schedule_show();
+      g_frame_stats.add(esphome::micros() - start_us);
+    }
+    this->force_redraw_ = false;
+  }
+
+protected:
+  // Renders a frame.  Returns true if any pixels were written.
+  // Pixels must be written when `force` is true even if the frame has not changed.
+  virtual bool render(AddressableLight& it, uint32_t now, bool force) = 0;
+
+  // Sets all pixels to a color using the channel tables.
+  static void fill(AddressableLight& it, const Color& color) {
+    const Color raw = g_channel_tables.to_raw(color);
+    for (int32_t i = 0; i < it.size(); i++) {
+      set_raw(it, i, raw);
+    }
+  }
+
+  // Sets one pixel to a color using the channel tables.
+  static void set(AddressableLight& it, int32_t index, const Color& color) {
+    set_raw(it, index, g_channel_tables.to_raw(color));
+  }
+
+  // The color of the light, which some effects use as their base color.
+  Color current_color_{};
+
+private:
+  static void set_raw(AddressableLight& it, int32_t index, const Color& raw) {
+    auto pixel = it[index];
+    pixel.raw_set_color_correction(&g_channel_tables.identity());
+    pixel = raw;
+  }
+
+  const uint32_t frame_interval_ms_;
+  uint32_t last_frame_ms_{0};
+  bool force_redraw_{true};
+};
+
+// -----------------------------------------------------------------------------
+// Effects
+// -----------------------------------------------------------------------------
+
+// Slowly cycles all pixels through the color wheel.
+class FadeEffect : public FrameEffect {
+public:
+  FadeEffect() : FrameEffect("Fade", 50) {}
+
+protected:
+  static constexpr uint32_t HUE_STEP_MS = 80;
+
+  bool render(AddressableLight& it, uint32_t now, bool force) override {
+    const uint8_t hue = (now / HUE_STEP_MS) & 0xff;
+    if (!force && hue == this->hue_) return false;
+    this->hue_ = hue;
+    fill(it, ESPHSVColor(hue, 255, 255).to_rgb());
+    return true;
+  }
+
+private:
+  uint8_t hue_{0};
+};
+
+// Fades all pixels to a random color every few seconds.
+class RandomEffect : public FrameEffect {
+public:
+  RandomEffect() : FrameEffect("Random", 50) {}
+
+  void start() override {
+    FrameEffect::start();
+    this->from_ = this->to_ = random_color();
+    this->change_ms_ = esphome::millis();
+  }
+
+protected:
+  static constexpr uint32_t HOLD_MS = 7000;
+  static constexpr uint32_t FADE_MS = 1000;
+
+  static Color random_color() { return ESPHSVColor(esphome::random_uint32() & 0xff, 255, 255).to_rgb(); }
+
+  bool render(AddressableLight& it, uint32_t now, bool force) override {
+    uint32_t elapsed = now - this->change_ms_;
+    if (elapsed >= HOLD_MS) {
+      this->from_ = this->to_;
+      this->to_ = random_color();
+      this->change_ms_ = now;
+      this->fading_ = true;
+      elapsed = 0;
+    }
+    if (!force && !this->fading_) return false;
+    if (elapsed >= FADE_MS) {
+      this->fading_ = false;
+      elapsed = FADE_MS;
+    }
+    fill(it, this->from_.gradient(this->to_, elapsed * 255 / FADE_MS));
+    return true;
+  }
+
+private:
+  Color from_{};
+  Color to_{};
+  uint32_t change_ms_{0};
+  bool fading_{false};
+};
+
+// -----------------------------------------------------------------------------
+// Fan synchronization
+// -----------------------------------------------------------------------------
+
+// Tracks the angle of the fan rotor so that effects can render patterns locked to its rotation.
+//
+// The tachometer only reports speed so the angle is extrapolated from the most recent reading
+// using the microsecond timer at the moment each frame is rendered.  Each frame is therefore
+// rendered at the correct angle for when it is shown no matter how irregularly frames arrive,
+// and the phase only drifts by the error in the speed reading until the next one.
+//
+// Angles are fixed point with 2^32 units per turn and are not wrapped so that effects can
+// measure how far the rotor turned between frames.  Exhaust turns in the positive direction.
+class FanSync {
+public:
+  static constexpr int64_t TURN = int64_t(1) << 32;
+
+  void init(unsigned ring_pixels, unsigned blades) {
+    this->ring_pixels_ = std::max(ring_pixels, 1u);
+    this->blades_ = std::max(blades, 1u);
+  }
+
+  unsigned get_ring_pixels() const { return this->ring_pixels_; }
+  unsigned get_blades() const { return this->blades_; }
+
+  // Sets the most recent tachometer reading.
+  void set_speed(float rpm, bool exhaust) {
+    const int64_t now = esp_timer_get_time();
+    this->base_angle_ = this->get_angle(now);
+    this->base_us_ = now;
+    if (std::isnan(rpm) || rpm < 0.f) rpm = 0.f;
+    this->turns_per_us_ = (exhaust ? rpm : -rpm) / 60e6f;
+  }
+
+  bool is_turning() const { return this->turns_per_us_ != 0.f; }
+  float get_turns_per_second() const { return std::fabs(this->turns_per_us_) * 1e6f; }
+
+  // Returns the angle of the rotor at a time from esp_timer_get_time().
+  int64_t get_angle(int64_t now_us) const {
+    return this->base_angle_ + int64_t(this->turns_per_us_ * float(now_us - this->base_us_) * float(TURN));
+  }
+
+  // Effects that use the rotor angle hold a reference while they are running so that the
+  // tachometer is only read when needed and frames are rendered on every loop iteration.
+  void acquire() {
+    if (this->references_++ == 0) {
+      this->high_freq_.start();
+    }
+  }
+  void release() {
+    if (--this->references_ == 0) {
+      this->high_freq_.stop();
+    }
+  }
+  bool is_active() const { return this->references_ != 0; }
+
+private:
+  unsigned ring_pixels_{1};
+  unsigned blades_{1};
+  int64_t base_us_{0};
+  int64_t base_angle_{0};
+  float turns_per_us_{0.f};
+  unsigned references_{0};
+  esphome::HighFrequencyLoopRequester high_freq_;
+};
+
+inline FanSync g_fan_sync{};
+
+// Accumulates the phase error of the flashes of the blade freeze effect for diagnostics.
+struct PhaseStats {
+  float total_deg{0.f};
+  float max_deg{0.f};
+  uint32_t flashes{0};
+
+  void add(float error_deg) {
+    error_deg = std::fabs(error_deg);
+    this->total_deg += error_deg;
+    this->max_deg = std::max(this->max_deg, error_deg);
+    this->flashes++;
+  }
+
+  // Returns the mean absolute phase error in degrees of rotor rotation since the last call or NAN
+  // if there were no flashes.
+  float take_mean_deg() {
+    const float mean = this->flashes ? this->total_deg / this->flashes : NAN;
+    *this = {};
+    return mean;
+  }
+};
+
+inline PhaseStats g_phase_stats{};
+
+// An effect locked to the rotation of the fan.
+class FanSyncEffect : public FrameEffect {
+public:
+  // Renders as fast as the loop allows since the pattern moves with the fan.
+  explicit FanSyncEffect(const char* name) : FrameEffect(name, 1000) {}
+
+  void start() override {
+    FrameEffect::start();
+    g_fan_sync.acquire();
+  }
+
+  void stop() override {
+    g_fan_sync.release();
+    FrameEffect::stop();
+  }
+};
+
+// Flashes the strip once per blade spacing of rotation so that the blades appear to stand still.
+//
+// Flashing at the blade passing frequency would be far faster than frames can be shown at high
+// speeds so the strip flashes every few blades, choosing the number of blades so the flash rate
+// stays below a limit.  Each flash lasts one frame.  The strip stays lit with the color of the
+// light while the fan is stopped.
+//
+// The strip can only be written from the main loop so the flashes are timed by its frames.  Each
+// flash is shown on the frame closest to the moment the rotor reaches the flash angle, which is
+// never more than half a frame interval away when frames are regular, and the remaining phase
+// error is recorded in g_phase_stats.
+class BladeFreezeEffect : public FanSyncEffect {
+public:
+  BladeFreezeEffect() : FanSyncEffect("Blade Freeze") {}
+
+  void start() override {
+    FanSyncEffect::start();
+    this->last_angle_ = g_fan_sync.get_angle(esp_timer_get_time());
+    this->progress_ = 0;
+    this->lit_ = false;
+  }
+
+protected:
+  static constexpr float MAX_FLASHES_PER_SECOND = 40.f;
+
+  bool render(AddressableLight& it, uint32_t now, bool force) override {
+    const int64_t angle = g_fan_sync.get_angle(esp_timer_get_time());
+    const int64_t turned = angle > this->last_angle_ ? angle - this->last_angle_ : this->last_angle_ - angle;
+    this->last_angle_ = angle;
+
+    if (!g_fan_sync.is_turning()) {
+      if (!force && this->lit_) return false;
+      this->lit_ = true;
+      fill(it, this->current_color_);
+      return true;
+    }
+
+    // Choose how many blades pass between flashes at the current speed.
+    const float blades_per_second = g_fan_sync.get_turns_per_second() * g_fan_sync.get_blades();
+    const int64_t blades_per_flash = int64_t(blades_per_second / MAX_FLASHES_PER_SECOND) + 1;
+    const int64_t flash_angle = FanSync::TURN * blades_per_flash / g_fan_sync.get_blades();
+
+    // Flash now if the rotor is closer to the flash angle than it will be on the next frame,
+    // assuming that the next frame turns as far as this one did.
+    this->progress_ += turned;
+    const bool flash = this->progress_ + turned / 2 >= flash_angle;
+    if (flash) {
+      // The phase error is how far past the flash angle the rotor is, or short of it if negative.
+      // The next flash is timed from the flash angle so that errors don't accumulate.
+      const int64_t error = this->progress_ - flash_angle;
+      this->progress_ = error < 0 ? error : error % flash_angle;
+      g_phase_stats.add(float(this->progress_) * 360.f / float(FanSync::TURN));
+    }
+    if (flash == this->lit_ && !force) return false;
+    this->lit_ = flash;
+    fill(it, flash ? this->current_color_ : Color::BLACK);
+    return true;
+  }
+
+private:
+  int64_t last_angle_{0};
+  int64_t progress_{0};
+  bool lit_{false};
+};
+
+// Runs a comet with a fading tail around the ring at the speed and direction of the rotor.
+class RotorCometEffect : public FanSyncEffect {
+public:
+  RotorCometEffect() : FanSyncEffect("Rotor Comet") {}
+
+protected:
+  // Length of the tail as a fraction of the ring.
+  static constexpr unsigned TAIL_FRACTION = 4;
+
+  bool render(AddressableLight& it, uint32_t now, bool force) override {
+    const int64_t angle = g_fan_sync.get_angle(esp_timer_get_time());
+    const uint32_t ring = g_fan_sync.get_ring_pixels();
+
+    // Position of the head on the ring in 1/256 pixel units.
+    const uint32_t head = uint32_t((uint64_t(uint32_t(angle)) * ring) >> 24);
+    if (!force && head == this->head_) return false;
+    this->head_ = head;
+
+    const bool forward = !(angle < this->last_angle_);
+    this->last_angle_ = angle;
+    const uint32_t ring_256 = ring << 8;
+    const uint32_t tail_256 = std::max(ring_256 / TAIL_FRACTION, 256u);
+    for (int32_t i = 0; i < it.size(); i++) {
+      // Distance from the head back along the tail, which trails behind the direction of motion.
+      const uint32_t position = (uint32_t(i) % ring) << 8;
+      const uint32_t distance = forward ? (head + ring_256 - position) % ring_256 : (position + ring_256 - head) % ring_256;
+      const uint8_t level = distance < tail_256 ? 255 - distance * 255 / tail_256 : 0;
+      set(it, i, this->current_color_ * level);
+    }
+    return true;
+  }
+
+private:
+  uint32_t head_{UINT32_MAX};
+  int64_t last_angle_{0};
+};
+
+inline FadeEffect g_fade_effect{};
+inline RandomEffect g_random_effect{};
+inline BladeFreezeEffect g_blade_freeze_effect{};
+inline RotorCometEffect g_rotor_comet_effect{};
+
+// Sets up the power limiter and channel tables for the strip configuration and adds the
+// native effects to the light after the effects declared in YAML.
+void init_addressable(LightState* light, const std::array<float, 4>& milliamps_per_channel,
+    const std::array<float, 4>& color_correct, float gamma, unsigned ring_pixels, unsigned fan_blades) {
+  g_power_limiter.init(light, milliamps_per_channel, color_correct, gamma);
+  g_channel_tables.init(gamma);
+  g_fan_sync.init(ring_pixels, fan_blades);
+  for (auto* effect : std::initializer_list<esphome::light::LightEffect*>{
+      &g_fade_effect, &g_random_effect, &g_blade_freeze_effect, &g_rotor_comet_effect}) {
+    // The light has already been set up so the effects must be initialized here.
+    effect->init_internal(light);
+    light->add_effects({effect});
+  }
+}
+
+} // namespace light
+} // namespace accessory
+} // namespace minuet
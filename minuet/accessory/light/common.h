@@ -197,7 +197,7 @@ void init() {
 
   minuet_light->add_new_remote_values_callback([] {
     if (minuet_light->remote_values.is_on() && minuet_safety_lock->state) {
-      minuet_tone->execute("forbidden");
+      minuet::tone::play("forbidden");
       turn_off(minuet_light);
     }
   });
@@ -3,9 +3,17 @@
 
 #include "esphome/components/fan/fan.h"
 #include "esphome/components/climate/climate_mode.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
 
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
 namespace minuet {
 
@@ -34,6 +42,14 @@ struct PersistentState {
   bool fan_exhaust : 1 {true};
   bool lid_open : 1 {false};
 
+  // Replaces fields that don't hold a valid value, as might be restored from a corrupted or
+  // older record, with their defaults.  Returns true if anything was replaced.
+  constexpr bool sanitize() {
+    if (this->fan_speed >= 1 && this->fan_speed <= 10) return false;
+    this->fan_speed = PersistentState{}.fan_speed;
+    return true;
+  }
+
   // The storage hack is needed because ESPHome global declarations cannot refer to types in user-defined include files.
   using Storage = typename std::remove_reference<decltype(*minuet_persistent_state_raw)>::type::value_type;
   constexpr Storage& to_storage() { return reinterpret_cast<Storage&>(*this); }
@@ -66,20 +82,147 @@ enum class LidMode : uint8_t {
   CLOSED = 2,
 };
 
-std::map<ClimatePreset, LidMode> thermostat_preset_lid_modes;
+// Fan modes that can be chosen for a thermostat preset in the order of the preset fan mode select options.
+constexpr ClimateFanMode THERMOSTAT_PRESET_FAN_MODES[] = {
+  ClimateFanMode::CLIMATE_FAN_AUTO,
+  ClimateFanMode::CLIMATE_FAN_QUIET,
+  ClimateFanMode::CLIMATE_FAN_LOW,
+  ClimateFanMode::CLIMATE_FAN_OFF,
+};
+constexpr const char* THERMOSTAT_PRESET_FAN_MODE_NAMES[] = { "Auto", "Quiet", "Low", "Off" };
+constexpr const char* LID_MODE_NAMES[] = { "Auto", "Open", "Closed" };
+
+// Returns the index of a name in a table of names or 0 if not found.
+template <size_t N>
+constexpr unsigned index_of_name(const char* const (&names)[N], std::string_view name) {
+  for (unsigned i = 0; i < N; i++) {
+    if (name == names[i]) return i;
+  }
+  return 0;
+}
+
+// The configuration of a thermostat preset packed for storage.
+struct ThermostatPresetConfig {
+  bool valid : 1 {false};
+  unsigned mode : 3 {0};           // ClimateMode
+  unsigned fan_mode_index : 2 {0}; // index into THERMOSTAT_PRESET_FAN_MODES
+  unsigned lid_mode : 2 {0};       // LidMode
+  unsigned reserved : 8 {0};
+  int temperature_centidegrees : 16 {0};
+
+  ClimateFanMode get_fan_mode() const { return THERMOSTAT_PRESET_FAN_MODES[this->fan_mode_index]; }
+  float get_temperature() const { return this->temperature_centidegrees / 100.f; }
+  void set_temperature(float celsius) { this->temperature_centidegrees = int(lroundf(celsius * 100.f)); }
+} __attribute__((packed));
+
+static_assert(sizeof(ThermostatPresetConfig) == 4);
 
-void set_thermostat_preset_config(ClimatePreset preset, ClimateMode mode, ClimateFanMode fan_mode,
-    LidMode lid_mode, float default_temperature) {
-  esphome::thermostat::ThermostatClimateTargetTempConfig config(default_temperature);
-  config.set_mode(mode);
-  config.set_fan_mode(fan_mode);
-  thermostat_preset_lid_modes[preset] = lid_mode;
+// The configurations of all thermostat presets indexed by ClimatePreset, persisted as one record.
+// The storage hack is needed for the same reason as in PersistentState.
+using ThermostatPresetStorage = typename std::remove_reference<decltype(*minuet_thermostat_preset_configs_raw)>::type::value_type;
+static_assert(std::tuple_size<ThermostatPresetStorage>::value > ClimatePreset::CLIMATE_PRESET_ACTIVITY);
+static_assert(sizeof(ThermostatPresetStorage::value_type) == sizeof(ThermostatPresetConfig));
+
+ThermostatPresetConfig& thermostat_preset_config(ClimatePreset preset) {
+  return reinterpret_cast<ThermostatPresetConfig&>(minuet_thermostat_preset_configs_raw->value()[size_t(preset)]);
+}
+
+// True once the preset settings entities have been synchronized with the stored configurations.
+// Until then, changes to the entities are ignored because they are only reporting their initial values.
+bool thermostat_presets_ready = false;
+
+void apply_thermostat_preset_config(ClimatePreset preset) {
+  const ThermostatPresetConfig& preset_config = thermostat_preset_config(preset);
+  esphome::thermostat::ThermostatClimateTargetTempConfig config(preset_config.get_temperature());
+  config.set_mode(ClimateMode(preset_config.mode));
+  config.set_fan_mode(preset_config.get_fan_mode());
   minuet_thermostat->set_preset_config(preset, config);
 }
 
+// The settings of a preset as stored by earlier firmware versions in which each settings entity
+// restored its own value.  Each setting is empty if it was never stored.
+struct LegacyThermostatPresetSettings {
+  std::optional<size_t> fan_mode_index;
+  std::optional<size_t> lid_mode;
+  std::optional<float> temperature;
+};
+
+// Loads the value that an entity restored itself, which ESPHome stores in a preference keyed by
+// the hash of the entity's object id.
+template <typename T>
+std::optional<T> load_legacy_entity_value(esphome::EntityBase* entity) {
+  T value;
+  auto pref = esphome::global_preferences->make_preference<T>(entity->get_object_id_hash());
+  if (!pref.load(&value)) return std::nullopt;
+  return value;
+}
+
+// Loads the legacy settings of a preset from its settings entities: the fan mode and lid mode
+// selects stored their index and the temperature number stored its value.
+LegacyThermostatPresetSettings load_legacy_thermostat_preset_settings(esphome::EntityBase* fan_mode_setting,
+    esphome::EntityBase* lid_mode_setting, esphome::EntityBase* temperature_setting) {
+  return {
+    .fan_mode_index = load_legacy_entity_value<size_t>(fan_mode_setting),
+    .lid_mode = load_legacy_entity_value<size_t>(lid_mode_setting),
+    .temperature = load_legacy_entity_value<float>(temperature_setting),
+  };
+}
+
+// Restores the stored configuration of a preset and configures the thermostat with it.
+//
+// If there is no stored configuration, as on the first boot after upgrading from a firmware
+// version that stored each setting separately, the legacy settings are migrated once and the
+// defaults fill in any setting that is missing or out of range.
+void init_thermostat_preset_config(ClimatePreset preset, ClimateMode mode, const char* default_fan_mode,
+    const char* default_lid_mode, float default_temperature, const LegacyThermostatPresetSettings& legacy = {}) {
+  ThermostatPresetConfig& preset_config = thermostat_preset_config(preset);
+  if (!preset_config.valid) {
+    preset_config = {
+      .valid = true,
+      .mode = unsigned(mode),
+      .fan_mode_index = index_of_name(THERMOSTAT_PRESET_FAN_MODE_NAMES, default_fan_mode),
+      .lid_mode = index_of_name(LID_MODE_NAMES, default_lid_mode),
+    };
+    preset_config.set_temperature(default_temperature);
+
+    bool migrated = false;
+    if (legacy.fan_mode_index && *legacy.fan_mode_index < std::size(THERMOSTAT_PRESET_FAN_MODES)) {
+      preset_config.fan_mode_index = *legacy.fan_mode_index;
+      migrated = true;
+    }
+    if (legacy.lid_mode && *legacy.lid_mode < std::size(LID_MODE_NAMES)) {
+      preset_config.lid_mode = *legacy.lid_mode;
+      migrated = true;
+    }
+    if (legacy.temperature && std::fabs(*legacy.temperature) < INT16_MAX / 100.f) {
+      preset_config.set_temperature(*legacy.temperature);
+      migrated = true;
+    }
+    if (migrated) {
+      ESP_LOGI(TAG, "Migrated thermostat preset %u settings: fan mode %s, lid mode %s, temperature %.1f°C",
+          unsigned(preset), THERMOSTAT_PRESET_FAN_MODE_NAMES[preset_config.fan_mode_index],
+          LID_MODE_NAMES[preset_config.lid_mode], preset_config.get_temperature());
+    }
+  }
+  apply_thermostat_preset_config(preset);
+}
+
+void set_thermostat_preset_config(ClimatePreset preset, ClimateMode mode, unsigned fan_mode_index,
+    LidMode lid_mode, float temperature) {
+  if (!thermostat_presets_ready) return;
+  ThermostatPresetConfig& preset_config = thermostat_preset_config(preset);
+  preset_config.valid = true;
+  preset_config.mode = unsigned(mode);
+  preset_config.fan_mode_index = fan_mode_index;
+  preset_config.lid_mode = unsigned(lid_mode);
+  preset_config.set_temperature(temperature);
+  apply_thermostat_preset_config(preset);
+}
+
 LidMode get_thermostat_preset_lid_mode(ClimatePreset preset) {
-  auto it = thermostat_preset_lid_modes.find(preset);
-  return it != thermostat_preset_lid_modes.end() ? it->second : LidMode::AUTO;
+  if (size_t(preset) >= std::tuple_size<ThermostatPresetStorage>::value) return LidMode::AUTO;
+  const ThermostatPresetConfig& preset_config = thermostat_preset_config(preset);
+  return preset_config.valid ? LidMode(preset_config.lid_mode) : LidMode::AUTO;
 }
 
 } // namespace minuet
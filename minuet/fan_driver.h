@@ -208,15 +208,18 @@ constexpr CurrentLimit BOARD_LOCK_ILIMIT = CurrentLimit::LIMIT_4_5_A;
 constexpr CurrentLimit BOARD_HW_LOCK_ILIMIT = CurrentLimit::LIMIT_5_0_A;
 
 // Controls the MCF8316 motor driver chip.
-class Controller {
+//
+// `Driver` provides the MCF8316Component interface and `DRIVER` points to the instance to control.
+template <typename Driver, Driver*& DRIVER>
+class BasicController {
 public:
-  static inline MCF8316Component* driver() { return minuet_fan_driver; }
+  static inline Driver* driver() { return DRIVER; }
 
   void init(const MotorDescriptor& descriptor);
   void shutdown();
 
   bool set_state(float speed_rpm, bool exhaust, bool brake, bool keep_awake);
-  void start_mpet();
+  bool start_mpet();
 
   float get_tachometer_rpm();
   float get_bus_current();
@@ -233,7 +236,8 @@ private:
 };
 
 
-Config Controller::make_config_(const MotorProfile& profile) {
+template <typename Driver, Driver*& DRIVER>
+Config BasicController<Driver, DRIVER>::make_config_(const MotorProfile& profile) {
   Config config = driver()->make_default_config();
 
   // Motor parameters
@@ -449,7 +453,8 @@ Config Controller::make_config_(const MotorProfile& profile) {
   return config;
 }
 
-bool Controller::set_inputs_(float speed_in_rotor_hz, bool direction_counter_clockwise, bool brake_on) {
+template <typename Driver, Driver*& DRIVER>
+bool BasicController<Driver, DRIVER>::set_inputs_(float speed_in_rotor_hz, bool direction_counter_clockwise, bool brake_on) {
   const bool run = speed_in_rotor_hz > 0;
   bool error = false;
   error |= brake_on && driver()->write_brake_input_config(true);
@@ -460,7 +465,8 @@ bool Controller::set_inputs_(float speed_in_rotor_hz, bool direction_counter_clo
   return !error;
 }
 
-void Controller::init(const MotorDescriptor& descriptor) {
+template <typename Driver, Driver*& DRIVER>
+void BasicController<Driver, DRIVER>::init(const MotorDescriptor& descriptor) {
   this->ready_ = false;
 
   ESP_LOGI(TAG, "Initializing fan motor driver for \"%s\" \"%s\"", descriptor.manufacturer, descriptor.model);
@@ -472,7 +478,7 @@ void Controller::init(const MotorDescriptor& descriptor) {
     error = driver()->save_config_to_eeprom();
   }
   if (error) {
-    ESP_LOGE(TAG, "Failed to initialize the fan motor driver: %s", MCF8316Component::error_name(error));
+    ESP_LOGE(TAG, "Failed to initialize the fan motor driver: %s", Driver::error_name(error));
     return;
   }
 
@@ -480,7 +486,8 @@ void Controller::init(const MotorDescriptor& descriptor) {
   this->profile_ = descriptor.profile;
 }
 
-void Controller::shutdown() {
+template <typename Driver, Driver*& DRIVER>
+void BasicController<Driver, DRIVER>::shutdown() {
   ESP_LOGI(TAG, "Shutdown fan motor driver");
 
   if (driver()->is_awake()) {
@@ -490,10 +497,11 @@ void Controller::shutdown() {
   this->ready_ = false;
 }
 
-bool Controller::set_state(float speed_rpm, bool exhaust, bool brake, bool keep_awake) {
+template <typename Driver, Driver*& DRIVER>
+bool BasicController<Driver, DRIVER>::set_state(float speed_rpm, bool exhaust, bool brake, bool keep_awake) {
   ESP_LOGI(TAG, "Set fan state: speed_rpm=%f, exhaust=%d, brake=%d, keep_awake=%d", speed_rpm, exhaust, brake, keep_awake);
   const bool run = speed_rpm > 0;
-  if (!ready_) {
+  if (!this->ready_) {
     if (!run && !brake) return true; // not ready and it's ok because we're not trying to operate the motor
     ESP_LOGW(TAG, "Fan motor not ready");
     return false;
@@ -504,8 +512,12 @@ bool Controller::set_state(float speed_rpm, bool exhaust, bool brake, bool keep_
     return false; // don't poke the speed input
   }
 
-  if (run > 0 || keep_awake) {
+  if (run || keep_awake) {
     driver()->wake();
+    if (!driver()->is_awake()) {
+      ESP_LOGW(TAG, "Failed to wake the fan motor driver");
+      return false;
+    }
   }
 
   if (driver()->is_awake() && !this->set_inputs_(rpm_to_hz(speed_rpm), !exhaust, brake)) {
@@ -518,7 +530,10 @@ bool Controller::set_state(float speed_rpm, bool exhaust, bool brake, bool keep_
 
   if (!run) {
     if (driver()->is_awake() && driver()->is_faulted()) {
-      driver()->clear_fault();
+      ErrorCode error = driver()->clear_fault();
+      if (error) {
+        ESP_LOGW(TAG, "Failed to clear the fan motor driver fault: %s", Driver::error_name(error));
+      }
     }
     if (!keep_awake) {
       driver()->sleep();
@@ -527,18 +542,31 @@ bool Controller::set_state(float speed_rpm, bool exhaust, bool brake, bool keep_
   return true;
 }
 
-void Controller::start_mpet() {
+template <typename Driver, Driver*& DRIVER>
+bool BasicController<Driver, DRIVER>::start_mpet() {
   if (!this->ready_) {
     ESP_LOGW(TAG, "Fan motor not ready");
-    return;
+    return false;
   }
 
   driver()->wake();
-  driver()->clear_fault();
-  driver()->start_mpet(true /*write_shadow*/);
+  if (!driver()->is_awake()) {
+    ESP_LOGE(TAG, "Failed to wake the fan motor driver for MPET");
+    return false;
+  }
+  ErrorCode error = driver()->clear_fault();
+  if (!error) {
+    error = driver()->start_mpet(true /*write_shadow*/);
+  }
+  if (error) {
+    ESP_LOGE(TAG, "Failed to start MPET: %s", Driver::error_name(error));
+    return false;
+  }
+  return true;
 }
 
-float Controller::get_tachometer_rpm() {
+template <typename Driver, Driver*& DRIVER>
+float BasicController<Driver, DRIVER>::get_tachometer_rpm() {
   if (this->ready_) {
     float speed_in_rotor_hz;
     ErrorCode error = driver()->read_speed_feedback(&speed_in_rotor_hz);
@@ -549,7 +577,8 @@ float Controller::get_tachometer_rpm() {
   return 0.f;
 }
 
-float Controller::get_bus_current() {
+template <typename Driver, Driver*& DRIVER>
+float BasicController<Driver, DRIVER>::get_bus_current() {
   if (this->ready_) {
     float current_in_amps;
     ErrorCode error = driver()->read_bus_current(&current_in_amps);
@@ -560,7 +589,8 @@ float Controller::get_bus_current() {
   return NAN;
 }
 
-float Controller::get_motor_phase_peak_current() {
+template <typename Driver, Driver*& DRIVER>
+float BasicController<Driver, DRIVER>::get_motor_phase_peak_current() {
   if (this->ready_) {
     float current_in_amps;
     ErrorCode error = driver()->read_motor_phase_peak_current(&current_in_amps);
@@ -571,7 +601,8 @@ float Controller::get_motor_phase_peak_current() {
   return NAN;
 }
 
-float Controller::get_vm_voltage() {
+template <typename Driver, Driver*& DRIVER>
+float BasicController<Driver, DRIVER>::get_vm_voltage() {
   if (this->ready_) {
     float voltage_in_volts;
     ErrorCode error = driver()->read_vm_voltage(&voltage_in_volts);
@@ -582,10 +613,12 @@ float Controller::get_vm_voltage() {
   return NAN;
 }
 
-float Controller::get_fan_speed_by_index(int index) const {
+template <typename Driver, Driver*& DRIVER>
+float BasicController<Driver, DRIVER>::get_fan_speed_by_index(int index) const {
   return this->ready_ && index >= 1 && index <= 10 ? this->profile_.fan_speed_rpm_table[index - 1] : 0.f;
 }
 
+using Controller = BasicController<MCF8316Component, minuet_fan_driver>;
 Controller controller;
 
 } // namespace fan_driver
@@ -1,20 +1,37 @@
 // MINUET GOVERNOR MODULE
 //
 // Pipeline:
-//  1) Read raw sensor states
+//  1) Read sensor channels (median, rate limit, staleness)
 //  2) Massage & bundle: clamp/null handling (+ optional low-pass)
-//  3) Controllers: Thermal, CO2, RH
-//  4) Combine determinations
-//  5) Apply inhibiting overrides
-//  6) Return result
+//  3) Controllers: Thermal, CO2, RH (see Controllers below to add more)
+//  4) Combine determinations (or predictive minimum-level search)
+//  5) Economizer: choose the airflow direction
+//  6) Apply inhibiting overrides
+//  7) Return result
 #pragma once
 
 #include <cstdint>
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <esp_attr.h>
+#include <esp_rtc_time.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 
 #include "core.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/text_sensor/text_sensor.h"
 
@@ -57,12 +74,28 @@ static constexpr float kGammaAuto  = 1.0f;       // Auto - Linear Ramp-up
 static constexpr float kGammaQuiet = 2.5f;       // Quiet - Power-Optimized Ramp-up
 // Hystersis handled by thermostat component.
 
+// Thermal PI mapping (alternative to the proportional curve above)
+// The proportional gain matches the linear curve: kMaxLevel levels across the mode's span.
+static constexpr float kPiIntegralTimeS  = 1200.0f;  // s, integral time Ti
+static constexpr float kPiTrackingTimeS  = 300.0f;   // s, back-calculation time Tt
+static constexpr uint32_t kPiMaxStepMs   = 5000;     // longer gaps integrate as this much
+static constexpr float kPiLevelHysteresis = 0.3f;    // levels, keeps adjacent levels from dithering
+
 // CO2 controller mapping
 static constexpr bool  kEnableCO2Control    = true;
 static constexpr float kCO2TargetPPM        = 700.0f;
 static constexpr float kCO2DeadbandPPM      = 75.0f;
 static constexpr float kCO2SpanPPM          = 500.0f;
 static constexpr float kCO2Gamma            = 1.25f;
+// CO2 feed-forward: the controller acts on the concentration projected kCO2LookaheadMin ahead
+// along the rising slope, estimated robustly (Theil-Sen) from a short history of CO2_f.  The slope
+// plus the CO2 currently vented gives the occupants' generation rate, from which the level that
+// would hold the target follows; the controller runs at least at that level once active.
+static constexpr float    kCO2LookaheadMin     = 5.0f;     // minutes, 0 disables feed-forward
+static constexpr uint32_t kCO2SlopeSampleMs    = 30 * 1000;
+static constexpr int      kCO2SlopeSamples     = 12;       // 5.5 min window
+static constexpr int      kCO2SlopeMinSamples  = 4;
+static constexpr float    kCO2MaxSlopePPMMin   = 200.0f;   // clamp against sensor glitches
 
 // RH controller mapping
 static constexpr bool  kEnableRHControl       = true;
@@ -73,21 +106,131 @@ static constexpr float kRHSpanLoPct           = 60.0f;   // %
 static constexpr float kRHSpanHiPct           = 100.0f;  // %
 static constexpr float kRHOutsideMarginPct    = 5.0f;    // don't evacuate if RHo >= RHi + margin
 
+// Economizer (direction selection)
+// Intake is chosen when the outdoor air carries sufficiently less enthalpy than the indoor air,
+// otherwise the fan exhausts the warmer air that collects near the ceiling.  Without humidity
+// readings the comparison falls back to dry-bulb temperature.
+static constexpr float kEconomizerPressureKPa        = 101.325f; // standard sea-level pressure
+static constexpr float kEconomizerIntakeOnKJkg       = 3.0f;     // enter intake at h_in - h_out >= on
+static constexpr float kEconomizerIntakeOffKJkg      = 1.0f;     // leave intake at h_in - h_out <= off
+static constexpr float kEconomizerIntakeOnC          = 1.5f;     // dry-bulb fallback thresholds
+static constexpr float kEconomizerIntakeOffC         = 0.5f;
+static_assert(kEconomizerIntakeOffKJkg < kEconomizerIntakeOnKJkg, "economizer needs hysteresis");
+static_assert(kEconomizerIntakeOffC < kEconomizerIntakeOnC, "economizer needs hysteresis");
+
+// Thermal model identification (recursive least squares)
+// Model, with rates in °C/min and the applied level L in [0, kMaxLevel]:
+//   dTin/dt = a * (Tout - Tin) + b * L * (Tout - Tin) + q
+// where 1/a is the passive cabin time constant, b is the ventilation gain per fan level and q is
+// the net internal and solar heat gain.
+static constexpr uint32_t kModelSamplePeriodMs = 60 * 1000;  // regression step
+static constexpr float kModelForgetting        = 0.995f;     // RLS forgetting factor (~200 samples)
+static constexpr float kModelInitialCovariance = 100.0f;     // P0 = c * I
+static constexpr float kModelMinExcitationC    = 0.5f;       // skip samples with |Tout - Tin| below
+static constexpr uint32_t kModelMinSamples     = 30;         // samples before the model is trusted
+static constexpr float kModelMaxRecordSamples = 4294967040.0f; // largest float below 2^32
+static constexpr float kModelInitialA          = 1.0f / 120.0f; // 2 h time constant
+static constexpr float kModelInitialB          = 0.01f;
+static constexpr float kModelMaxB              = 1.0f;  // whole cabin per minute per level
+static constexpr float kModelInitialQ          = 0.0f;
+
+// Predictive level selection
+// Simulates every candidate level over a short horizon using the thermal model (or its initial
+// values until trusted) and picks the lowest level whose predicted state meets the targets of all
+// active controllers.  Fan power grows with level, so the lowest feasible level costs least.
+// CO2 is generated at the rate estimated by the CO2 controller once it has enough history.
+static constexpr int   kMpcHorizonMin           = 10;      // minutes, one Euler step per minute
+static constexpr float kMpcTemperatureToleranceC = 0.25f;  // slack on the thermal target
+static constexpr float kMpcOutdoorCO2PPM        = 420.0f;
+static constexpr float kMpcCO2GenerationPPMMin  = 20.0f;   // ~2 occupants, until estimated
+static constexpr float kMpcCO2GenerationMaxPPMMin = 100.0f; // clamp on the estimated generation
+static constexpr float kMpcMoistureGenerationGkgMin = 0.02f;
+static constexpr float kMpcAirChangeBaseMin     = 0.005f;  // leakage air changes per minute
+// Air exchange per level is taken from ventilation_gain().
+
+// Sensor front end
+// Each new reading enters a median window, whose median is then slew limited so that isolated
+// spikes are rejected and implausible steps are spread out.  A channel that hasn't reported within
+// its timeout is treated as missing.  The outdoor feeds update about every half hour, so a median
+// over several readings would hold back a real step for an hour or more; their readings are only
+// slew limited.
+static constexpr int   kMedianWindow        = 5;       // readings, and the largest window
+static constexpr int   kMedianWindowOutdoor = 1;
+static_assert(kMedianWindowOutdoor >= 1 && kMedianWindowOutdoor <= kMedianWindow);
+static constexpr float kMaxRateTempCPerS    = 0.05f;   // 3 °C/min
+static constexpr float kMaxRateRHPctPerS    = 0.25f;   // 15 %/min
+static constexpr float kMaxRateCO2PPMPerS   = 10.0f;   // 600 ppm/min
+static constexpr uint32_t kStaleIndoorMs    = 5 * 60 * 1000;
+static constexpr uint32_t kStaleOutdoorMs   = 30 * 60 * 1000;  // weather feeds update slowly
+
+// Indoor temperature failover
+// While both sensors report, the offset between the external sensor and the thermistor is learned
+// so that the thermistor reading can stand in for the external sensor when it fails.
+static constexpr float    kFailoverOffsetAlpha    = 0.02f;  // EMA weight per thermistor reading
+static constexpr uint32_t kFailoverOffsetMinSamples = 30;   // apply the offset once learned
+static constexpr uint32_t kFailoverOffsetFreshMs  = 60 * 1000;  // learn only from recent primary readings
+static constexpr uint8_t  kFailoverRecoverySamples = 3;     // good primary readings to switch back
+
 // Optional sensor low-pass (1.0 = disabled / passthrough)
 static constexpr float kAlphaTempLPF = 1.0f;
 static constexpr float kAlphaRHLPF   = 1.0f;
 static constexpr float kAlphaCO2LPF  = 1.0f;
 
+// Controller scheduling
+// A controller runs when any of its inputs changed or when its period elapsed, otherwise its last
+// determination is reused.  The periods bound how long time-driven parts (PI integral, CO2 history)
+// go without an update so kThermalPeriodMs must not exceed kPiMaxStepMs.
+static constexpr uint32_t kThermalPeriodMs = 2000;
+static constexpr uint32_t kCO2PeriodMs     = 10000;
+static constexpr uint32_t kRHPeriodMs      = 5000;
+
 // Levels
 static constexpr int   kMaxLevel     = 10;  // global max discrete level
 static constexpr int   kMinOnLevel   = 1;   // minimum running level
 static constexpr int   kMaxLevelQuiet = 6;
 static_assert(kMaxLevelQuiet >= kMinOnLevel && kMaxLevelQuiet <= kMaxLevel,
               "kMaxLevelQuiet must be in [kMinOnLevel, kMaxLevel]");
+static_assert(kThermalPeriodMs <= kPiMaxStepMs, "thermal period would truncate PI integration");
+static_assert(kCO2PeriodMs <= kCO2SlopeSampleMs, "CO2 period would skip history samples");
+
+// How the thermal controller maps error to level
+enum class ThermalMode : uint8_t { PROPORTIONAL = 0, PI = 1 };
+
+// How controller determinations are turned into a level
+enum class ControlStrategy : uint8_t { PROPORTIONAL = 0, PREDICTIVE = 1 };
+
+// Tunable parameters, defaulting to the constants above.  The YAML may override them at boot with
+// a designated initializer, see set_config().
+struct GovernorConfig {
+  // Thermal
+  float outside_margin_c{kOutsideMarginC};
+  float span_auto_c{kSpanAutoC};
+  float span_quiet_c{kSpanQuietC};
+  float gamma_auto{kGammaAuto};
+  float gamma_quiet{kGammaQuiet};
+  // CO2
+  float co2_target_ppm{kCO2TargetPPM};
+  float co2_deadband_ppm{kCO2DeadbandPPM};
+  float co2_span_ppm{kCO2SpanPPM};
+  float co2_gamma{kCO2Gamma};
+  // RH
+  float rh_target_pct{kRHTargetPct};
+  float rh_deadband_pct{kRHDeadbandPct};
+  float rh_gamma{kRHGamma};
+  float rh_span_lo_pct{kRHSpanLoPct};
+  float rh_span_hi_pct{kRHSpanHiPct};
+  float rh_outside_margin_pct{kRHOutsideMarginPct};
+  // Levels
+  int max_level_quiet{kMaxLevelQuiet};
+};
+
+inline GovernorConfig g_config{};
 
 // Runtime toggles (HA switches sync these at boot & on change)
 inline bool g_enable_co2_control = kEnableCO2Control;
 inline bool g_enable_rh_control  = kEnableRHControl;
+inline ControlStrategy g_control_strategy = ControlStrategy::PROPORTIONAL;
+inline ThermalMode g_thermal_mode = ThermalMode::PROPORTIONAL;
 
 // -----------------------------------------------------------------------------
 // Types
@@ -100,29 +243,52 @@ struct ControlInput {
   LidMode lid_mode;            // requested lid mode
 };
 
-// Active-controller reporting
-enum class ActiveController : uint8_t { OFF = 0, THERMAL = 1, CO2 = 2, RH = 3 };
+// Active-controller reporting: 0 when none, otherwise 1 + the controller's index in Controllers
+using ActiveController = uint8_t;
+static constexpr ActiveController kNoActiveController = 0;
 
-inline const char* active_controller_to_str(ActiveController c) {
-  switch (c) {
-    case ActiveController::THERMAL: return "Thermal";
-    case ActiveController::CO2:     return "CO2";
-    case ActiveController::RH:      return "RH";
-    case ActiveController::OFF:
-    default:                        return "Off";
+// Airflow direction chosen by the economizer
+enum class Direction : uint8_t { NONE = 0, EXHAUST = 1, INTAKE = 2 };
+
+inline const char* direction_to_str(Direction d) {
+  switch (d) {
+    case Direction::EXHAUST: return "Exhaust";
+    case Direction::INTAKE:  return "Intake";
+    case Direction::NONE:
+    default:                 return "None";
   }
 }
 
 struct ControlOutput {
   int  fan_speed{0};           // 0–10
   bool lid_open{false};        // lid state
-  ActiveController active_controller{ActiveController::OFF}; // intent (pre-override)
+  Direction direction{Direction::NONE}; // NONE if the economizer lacks the sensors to decide
+  ActiveController active_controller{kNoActiveController}; // intent (pre-override)
+};
+
+// Quality of a sensor channel
+enum class Quality : uint8_t {
+  MISSING = 0,  // no sensor or never reported
+  STALE = 1,    // hasn't reported within its timeout, the value is not used
+  LIMITED = 2,  // the last reading was slew limited, the value lags the sensor
+  GOOD = 3,
 };
 
-// Snapshot of raw reads (pre-massage)
+inline char quality_to_char(Quality q) {
+  switch (q) {
+    case Quality::GOOD:    return 'G';
+    case Quality::LIMITED: return 'L';
+    case Quality::STALE:   return 'S';
+    case Quality::MISSING:
+    default:               return '-';
+  }
+}
+
+// Snapshot of channel reads (pre-massage)
 struct SensorSample {
   bool has_Tin{false}, has_Tout{false}, has_RHi{false}, has_RHo{false}, has_CO2{false};
   float Tin{NAN}, Tout{NAN}, RHi{NAN}, RHo{NAN}, CO2{NAN};
+  Quality q_Tin{}, q_Tout{}, q_RHi{}, q_RHo{}, q_CO2{};
 };
 
 // Sanitized/filtered bundle every controller consumes
@@ -130,6 +296,7 @@ struct SensorBundle {
   bool has_Tin{false}, has_Tout{false}, has_RHi{false}, has_RHo{false}, has_CO2{false};
   float Tin{0}, Tout{0}, RHi{0}, RHo{0}, CO2{0};       // clamped
   float Tin_f{0}, RHi_f{0}, CO2_f{0};                  // filtered (LPF), if enabled
+  Quality q_Tin{}, q_Tout{}, q_RHi{}, q_RHo{}, q_CO2{};
 };
 
 // Controller-to-arbiter result
@@ -139,11 +306,122 @@ struct Determination {
   bool active{false};      // after internal hysteresis/gating
 };
 
+// Last inputs and determination of a controller.
+template <size_t N>
+struct ControllerCache {
+  std::array<float, N> inputs{};
+  Determination determination{};
+  uint32_t last_ms{0};
+  bool valid{false};
+};
+
+// Invocation counts of a controller, kept across resets.
+struct ControllerStats {
+  uint32_t runs{0};
+  uint32_t skips{0};
+};
+
+// Online estimate of the thermal model parameters, see kModel* tunables.
+struct ThermalModel {
+  static constexpr int N = 3;
+  using Vector = std::array<float, N>;
+  using Matrix = std::array<Vector, N>;
+
+  Vector theta{kModelInitialA, kModelInitialB, kModelInitialQ};  // {a, b, q}
+  Matrix P{};
+  uint32_t samples{0};
+
+  ThermalModel() { this->reset_covariance(); }
+
+  void reset_covariance() {
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) this->P[i][j] = (i == j) ? kModelInitialCovariance : 0.0f;
+    }
+  }
+
+  // Incorporates one observation y = phi . theta + noise.
+  void update(const Vector& phi, float y) {
+    Vector Pphi{};
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) Pphi[i] += this->P[i][j] * phi[j];
+    }
+    float denom = kModelForgetting;
+    for (int i = 0; i < N; i++) denom += phi[i] * Pphi[i];
+    if (!(denom > 0.0f) || !std::isfinite(denom)) return;
+
+    float error = y;
+    for (int i = 0; i < N; i++) error -= phi[i] * this->theta[i];
+
+    Vector gain{};
+    for (int i = 0; i < N; i++) gain[i] = Pphi[i] / denom;
+    Vector theta = this->theta;
+    for (int i = 0; i < N; i++) theta[i] += gain[i] * error;
+
+    Matrix P{};
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) {
+        P[i][j] = (this->P[i][j] - gain[i] * Pphi[j]) / kModelForgetting;
+      }
+    }
+    // Keep P symmetric to limit numerical drift
+    for (int i = 0; i < N; i++) {
+      for (int j = i + 1; j < N; j++) P[i][j] = P[j][i] = 0.5f * (P[i][j] + P[j][i]);
+    }
+
+    for (int i = 0; i < N; i++) {
+      if (!std::isfinite(theta[i])) return;
+      for (int j = 0; j < N; j++) if (!std::isfinite(P[i][j])) return;
+    }
+    this->theta = theta;
+    this->P = P;
+    this->samples++;
+  }
+
+  float a() const { return this->theta[0]; }
+  float b() const { return this->theta[1]; }
+  float q() const { return this->theta[2]; }
+
+  // True once enough samples were seen and the parameters are physically plausible.
+  bool is_trusted() const {
+    return this->samples >= kModelMinSamples && this->a() > 0.0f && this->b() > 0.0f;
+  }
+
+  // Passive time constant in minutes, or NAN if not identified.
+  float time_constant_min() const { return this->a() > 0.0f ? 1.0f / this->a() : NAN; }
+};
+
+// Persisted form of the thermal model: {a, b, q, samples}.
+using ThermalModelRecord = std::array<float, 4>;
+
 // Mutable state (hysteresis + LPF memory)
 struct GovernorState {
   // Hysteresis latches
   bool co2_active{false};
   bool rh_active{false};
+  bool economizer_intake{false};
+
+  // CO2 history for the slope estimate, oldest first once full
+  std::array<float, kCO2SlopeSamples> co2_history{};
+  uint8_t co2_history_count{0};
+  uint8_t co2_history_head{0};
+  uint32_t co2_history_last_ms{0};
+  float co2_generation{NAN};  // ppm/min estimated from the history, NAN until known
+
+  // Thermal PI: integral term in levels and the unsaturated output of the last update
+  float thermal_integral{0};
+  float thermal_pi_output{0};
+  bool thermal_pi_running{false};
+  int thermal_pi_level{0};
+  uint32_t thermal_pi_last_ms{0};
+  float thermal_pi_dt_s{0};
+
+  // Thermal model sampling: level-time integral since the last sample
+  bool model_sampling{false};
+  uint32_t model_last_ms{0};
+  float model_last_Tin{0};
+  float model_level_ms{0};
+  uint32_t model_level_last_ms{0};
+  int model_level{0};  // effective level commanded by the last update, zero with the lid closed
 
   // LPF memory
   bool lpf_init_Tin{false}, lpf_init_RHi{false}, lpf_init_CO2{false};
@@ -156,6 +434,12 @@ struct GovernorState {
 // Global persistent state
 inline GovernorState g_state{};
 
+// Learned thermal model, kept across reset() and persisted by the YAML.
+inline ThermalModel g_model{};
+
+// Drops the cached determinations of all controllers, defined with the registry below.
+inline void invalidate_controllers();
+
 inline bool sensor_valid(const esphome::sensor::Sensor* s) {
   return s && s->has_state() && std::isfinite(s->state);
 }
@@ -171,28 +455,481 @@ inline float lpf_step(float x, float prev, float alpha) {
 // Reset API clears hysteresis & LPF state
 inline void reset() {
   g_state = GovernorState{};
+  invalidate_controllers();
+}
+
+// Restores the thermal model from its persisted record.  Invalid records are ignored.
+inline void load_model(const ThermalModelRecord& record) {
+  if (!(record[3] >= 1.0f)) return;
+  for (float value : record) {
+    if (!std::isfinite(value)) return;
+  }
+  g_model = ThermalModel{};
+  g_model.theta = {record[0], record[1], record[2]};
+  // A corrupt count may not fit the integer
+  g_model.samples = static_cast<uint32_t>(std::min(record[3], kModelMaxRecordSamples));
+  // Leave some covariance so the estimate keeps tracking changes to the rig
+  for (int i = 0; i < ThermalModel::N; i++) g_model.P[i][i] = 1.0f;
+}
+
+inline ThermalModelRecord save_model() {
+  return {g_model.a(), g_model.b(), g_model.q(), static_cast<float>(g_model.samples)};
+}
+
+// Forgets everything learned about the rig.
+inline void reset_model() {
+  g_model = ThermalModel{};
+  g_state.model_sampling = false;
 }
 
 // -----------------------------------------------------------------------------
-// (1) Read sensors -> SensorSample
+// Warm start
 // -----------------------------------------------------------------------------
-inline SensorSample read_sensors() {
-  SensorSample s{};
-  if (sensor_valid(indoor_ambient_temperature_sensor)) {
-    s.has_Tin = true; s.Tin = indoor_ambient_temperature_sensor->state;
+// The first start of automatic control after a reset resumes from a recent snapshot of the state
+// instead of resetting so that latches, filters and the integral carry over.  Snapshots are kept
+// in two places:
+//  - RTC memory, often and stamped with the RTC timer.  Both are only relied upon across software,
+//    panic and watchdog resets: a loss of power clears them, and other resets may too, so this
+//    snapshot is discarded after any other reset.
+//  - Flash, every few minutes and stamped with the wall clock if it's set, for a brief loss of
+//    power.  If either stamp is unknown the age can't be told, so the snapshot is taken as fresh
+//    only if automatic control starts within the maximum age of the boot, and only once: it's
+//    erased when it's picked up.
+static_assert(std::is_trivially_copyable_v<GovernorState>);
+
+struct Snapshot {
+  static constexpr uint32_t MAGIC = 0x4d475332;  // "MGS2"
+
+  uint32_t magic;
+  uint32_t size;
+  uint64_t taken_us;        // RTC timer
+  int64_t taken_epoch_s;    // wall clock, 0 if it wasn't set
+  alignas(GovernorState) uint8_t state[sizeof(GovernorState)];
+  uint32_t checksum;
+
+  uint32_t compute_checksum() const {
+    // FNV-1a over everything before the checksum
+    uint32_t hash = 2166136261u;
+    const auto* bytes = reinterpret_cast<const uint8_t*>(this);
+    for (size_t i = 0; i < offsetof(Snapshot, checksum); i++) hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
   }
-  if (sensor_valid(outdoor_ambient_temperature_sensor)) {
-    s.has_Tout = true; s.Tout = outdoor_ambient_temperature_sensor->state;
+
+  bool is_valid() const {
+    return this->magic == MAGIC && this->size == sizeof(GovernorState) && this->checksum == this->compute_checksum();
   }
-  if (sensor_valid(indoor_relative_humidity_sensor)) {
-    s.has_RHi = true; s.RHi = indoor_relative_humidity_sensor->state;
+};
+
+// Deliberately left uninitialized so that it keeps its contents across resets.
+RTC_NOINIT_ATTR Snapshot g_snapshot;
+
+// Seconds since the Unix epoch, or 0 while the clock isn't set.  Provided by a time component if
+// one is configured.
+inline int64_t (*g_wall_clock_s)(){nullptr};
+
+enum class WarmSource : uint8_t { RTC, FLASH };
+
+inline esphome::ESPPreferenceObject g_snapshot_pref{};
+inline bool g_snapshot_persisted{false};
+inline GovernorState g_warm_state{};
+inline bool g_warm_pending{false};
+inline WarmSource g_warm_source{WarmSource::RTC};
+inline uint64_t g_warm_taken_us{0};
+inline int64_t g_warm_taken_epoch_s{0};
+inline uint32_t g_warm_max_age_s{0};
+
+inline int64_t wall_clock_s() {
+  return g_wall_clock_s ? g_wall_clock_s() : 0;
+}
+
+// Whether RTC memory and the RTC timer are trusted to have carried over from before the reset.
+inline bool is_warm_reset(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+      return true;
+    default:
+      return false;
   }
-  if (sensor_valid(outdoor_relative_humidity_sensor)) {
-    s.has_RHo = true; s.RHo = outdoor_relative_humidity_sensor->state;
+}
+
+// Seconds since a snapshot taken before the last reset, or UINT64_MAX if unknown.  The RTC timer
+// must have counted at least the uptime since then; if it counted less it restarted with the reset.
+inline uint64_t snapshot_age_s(uint64_t taken_us) {
+  const uint64_t now_us = esp_rtc_get_time_us();
+  const uint64_t uptime_us = static_cast<uint64_t>(esp_timer_get_time());
+  return now_us >= taken_us && now_us - taken_us >= uptime_us ? (now_us - taken_us) / 1000000u : UINT64_MAX;
+}
+
+// Whether the pending warm state is still no older than the maximum age.
+inline bool is_warm_state_fresh() {
+  if (g_warm_source == WarmSource::RTC) return snapshot_age_s(g_warm_taken_us) <= g_warm_max_age_s;
+  const int64_t now_s = wall_clock_s();
+  if (now_s != 0 && g_warm_taken_epoch_s != 0) {
+    return now_s >= g_warm_taken_epoch_s && now_s - g_warm_taken_epoch_s <= int64_t{g_warm_max_age_s};
+  }
+  return static_cast<uint64_t>(esp_timer_get_time()) / 1000000u <= g_warm_max_age_s;
+}
+
+// Records the current state in RTC memory.
+inline void snapshot() {
+  std::memset(&g_snapshot, 0, sizeof(g_snapshot));
+  g_snapshot.magic = Snapshot::MAGIC;
+  g_snapshot.size = sizeof(GovernorState);
+  g_snapshot.taken_us = esp_rtc_get_time_us();
+  g_snapshot.taken_epoch_s = wall_clock_s();
+  std::memcpy(g_snapshot.state, &g_state, sizeof(GovernorState));
+  g_snapshot.checksum = g_snapshot.compute_checksum();
+}
+
+// Records the current state in RTC memory and flash.
+inline void persist_snapshot() {
+  snapshot();
+  g_snapshot_persisted = g_snapshot_pref.save(&g_snapshot);
+}
+
+inline void erase_persisted_snapshot() {
+  if (!g_snapshot_persisted) return;
+  const Snapshot erased{};
+  g_snapshot_pref.save(&erased);
+  g_snapshot_persisted = false;
+}
+
+// Invalidates the snapshots, such as when automatic control stops, so they can't be resumed.
+inline void discard_snapshot() {
+  g_snapshot.magic = 0;
+  erase_persisted_snapshot();
+}
+
+// Called once on boot to pick up the most recent valid snapshot, which start() resumes if it's no
+// older than max_age_s by then.
+inline void restore_snapshot(uint32_t max_age_s) {
+  g_warm_pending = false;
+  g_snapshot_pref = esphome::global_preferences->make_preference<Snapshot>(esphome::fnv1_hash("minuet_governor_snapshot"));
+  Snapshot persisted;
+  g_snapshot_persisted = g_snapshot_pref.load(&persisted) && persisted.is_valid();
+
+  const Snapshot* snapshot = nullptr;
+  if (is_warm_reset(esp_reset_reason()) && g_snapshot.is_valid()) {
+    // Taken more recently than the one in flash
+    const uint64_t age_s = snapshot_age_s(g_snapshot.taken_us);
+    if (age_s > max_age_s) {
+      ESP_LOGD("governor", "Warm start: snapshot too old or of unknown age");
+      discard_snapshot();
+      return;
+    }
+    ESP_LOGI("governor", "Warm start: resuming from a snapshot taken %us ago", static_cast<unsigned>(age_s));
+    snapshot = &g_snapshot;
+    g_warm_source = WarmSource::RTC;
+  } else {
+    g_snapshot.magic = 0;
+    if (!g_snapshot_persisted) {
+      ESP_LOGD("governor", "Warm start: no snapshot");
+      return;
+    }
+    ESP_LOGI("governor", "Warm start: resuming from the snapshot saved to flash");
+    snapshot = &persisted;
+    g_warm_source = WarmSource::FLASH;
   }
-  if (sensor_valid(indoor_co2_sensor)) {
-    s.has_CO2 = true; s.CO2 = indoor_co2_sensor->state;
+  // Whichever snapshot is resumed, the one in flash is only resumed once
+  erase_persisted_snapshot();
+
+  std::memcpy(&g_warm_state, snapshot->state, sizeof(GovernorState));
+  // Every millis() stamp refers to the previous boot's clock, so whatever was sampled against one
+  // restarts: the CO2 history and the generation estimated from it, the PI step and the model
+  // sample.  The controllers' gating times aren't part of the state and restart in start().
+  GovernorState& st = g_warm_state;
+  st.co2_history_count = 0;
+  st.co2_history_head = 0;
+  st.co2_history_last_ms = 0;
+  st.co2_generation = NAN;
+  st.thermal_pi_last_ms = 0;
+  st.thermal_pi_dt_s = 0.0f;
+  st.model_sampling = false;
+  st.model_last_ms = 0;
+  st.model_level_ms = 0.0f;
+  st.model_level_last_ms = 0;
+  g_warm_taken_us = snapshot->taken_us;
+  g_warm_taken_epoch_s = snapshot->taken_epoch_s;
+  g_warm_max_age_s = max_age_s;
+  g_warm_pending = true;
+}
+
+// Starts automatic control: resumes the warm state if it's still recent enough, otherwise resets.
+inline void start() {
+  if (g_warm_pending && is_warm_state_fresh()) {
+    g_state = g_warm_state;
+    invalidate_controllers();
+  } else {
+    reset();
   }
+  g_warm_pending = false;
+}
+
+// Applies a configuration after bringing each parameter into its valid range.
+inline void set_config(const GovernorConfig& config) {
+  static constexpr float GovernorConfig::* FLOAT_FIELDS[] = {
+    &GovernorConfig::outside_margin_c, &GovernorConfig::span_auto_c, &GovernorConfig::span_quiet_c,
+    &GovernorConfig::gamma_auto, &GovernorConfig::gamma_quiet,
+    &GovernorConfig::co2_target_ppm, &GovernorConfig::co2_deadband_ppm, &GovernorConfig::co2_span_ppm,
+    &GovernorConfig::co2_gamma,
+    &GovernorConfig::rh_target_pct, &GovernorConfig::rh_deadband_pct, &GovernorConfig::rh_gamma,
+    &GovernorConfig::rh_span_lo_pct, &GovernorConfig::rh_span_hi_pct, &GovernorConfig::rh_outside_margin_pct,
+  };
+  static_assert(sizeof(FLOAT_FIELDS) / sizeof(FLOAT_FIELDS[0]) * sizeof(float) + sizeof(int) == sizeof(GovernorConfig),
+                "every float field of GovernorConfig must be listed");
+
+  // NaN and infinity slip through the range clamps below, so they fall back to the defaults first
+  GovernorConfig c = config;
+  const GovernorConfig defaults{};
+  for (const auto field : FLOAT_FIELDS) {
+    if (!std::isfinite(c.*field)) c.*field = defaults.*field;
+  }
+  c.span_auto_c           = std::max(c.span_auto_c, 0.1f);
+  c.span_quiet_c          = std::max(c.span_quiet_c, 0.1f);
+  c.gamma_auto            = clampf(c.gamma_auto, 0.1f, 10.0f);
+  c.gamma_quiet           = clampf(c.gamma_quiet, 0.1f, 10.0f);
+  c.co2_target_ppm        = clampf(c.co2_target_ppm, kMpcOutdoorCO2PPM + 50.0f, 5000.0f);
+  c.co2_deadband_ppm      = clampf(c.co2_deadband_ppm, 0.0f, c.co2_target_ppm - kMpcOutdoorCO2PPM);
+  c.co2_span_ppm          = std::max(c.co2_span_ppm, 1.0f);
+  c.co2_gamma             = clampf(c.co2_gamma, 0.1f, 10.0f);
+  c.rh_target_pct         = clampf(c.rh_target_pct, 0.0f, 100.0f);
+  c.rh_deadband_pct       = clampf(c.rh_deadband_pct, 0.0f, 50.0f);
+  c.rh_gamma              = clampf(c.rh_gamma, 0.1f, 10.0f);
+  c.rh_span_lo_pct        = clampf(c.rh_span_lo_pct, 0.0f, 100.0f);
+  c.rh_span_hi_pct        = std::max(c.rh_span_hi_pct, c.rh_span_lo_pct + 1.0f);
+  c.max_level_quiet       = std::clamp(c.max_level_quiet, kMinOnLevel, kMaxLevel);
+  if (std::memcmp(&c, &config, sizeof(c)) != 0) {
+    ESP_LOGW("governor", "Config: some parameters were out of range and have been adjusted");
+  }
+  g_config = c;
+  invalidate_controllers();
+}
+
+// Describes a configuration in the form accepted by the minuet_governor_config substitution.
+inline std::string describe_config(const GovernorConfig& c) {
+  return esphome::str_sprintf(
+      "{.outside_margin_c = %g, .span_auto_c = %g, .span_quiet_c = %g, .gamma_auto = %g, "
+      ".gamma_quiet = %g, .co2_target_ppm = %g, .co2_deadband_ppm = %g, .co2_span_ppm = %g, "
+      ".co2_gamma = %g, .rh_target_pct = %g, .rh_deadband_pct = %g, .rh_gamma = %g, "
+      ".rh_span_lo_pct = %g, .rh_span_hi_pct = %g, .rh_outside_margin_pct = %g, .max_level_quiet = %d}",
+      c.outside_margin_c, c.span_auto_c, c.span_quiet_c, c.gamma_auto, c.gamma_quiet,
+      c.co2_target_ppm, c.co2_deadband_ppm, c.co2_span_ppm, c.co2_gamma,
+      c.rh_target_pct, c.rh_deadband_pct, c.rh_gamma, c.rh_span_lo_pct, c.rh_span_hi_pct,
+      c.rh_outside_margin_pct, c.max_level_quiet);
+}
+
+// Logs the active configuration.
+inline void log_config() {
+  ESP_LOGCONFIG("governor", "Config: %s", describe_config(g_config).c_str());
+}
+
+// Fan ventilation gain: fraction of the cabin air replaced per minute per level.  The thermal
+// model's ventilation gain describes the same exchange, so it's used once trusted, bounded so that
+// a corrupt restored model can't push the CO2 mass balance out of range.
+inline float ventilation_gain() {
+  return g_model.is_trusted() ? std::min(g_model.b(), kModelMaxB) : kModelInitialB;
+}
+
+// -----------------------------------------------------------------------------
+// Sensor front end
+// -----------------------------------------------------------------------------
+// Conditions the readings of one sensor.  Readings are pushed as the sensor publishes them and
+// the conditioned value is read by the governor.  Fixed size and allocation-free.
+class SensorChannel {
+public:
+  // `window` is the number of readings the median is taken over, up to kMedianWindow.
+  constexpr SensorChannel(float max_rate_per_s, uint32_t stale_ms, uint8_t window = kMedianWindow)
+      : max_rate_per_s_(max_rate_per_s), stale_ms_(stale_ms), window_size_(std::clamp<uint8_t>(window, 1, kMedianWindow)) {}
+
+  void push(float value, uint32_t now_ms) {
+    if (!std::isfinite(value)) return;  // leaves the channel to go stale
+
+    this->window_[this->head_] = value;
+    this->head_ = (this->head_ + 1) % this->window_size_;
+    if (this->count_ < this->window_size_) this->count_++;
+    const float median = this->median();
+
+    if (!this->has_output_) {
+      this->output_ = median;
+      this->has_output_ = true;
+      this->limited_ = false;
+    } else {
+      const float dt_s = static_cast<float>(now_ms - this->last_ms_) * 0.001f;
+      const float step = this->max_rate_per_s_ * std::max(dt_s, 0.001f);
+      const float delta = median - this->output_;
+      this->limited_ = std::fabs(delta) > step;
+      this->output_ += clampf(delta, -step, step);
+    }
+    this->last_ms_ = now_ms;
+  }
+
+  Quality read(uint32_t now_ms, float& value) const {
+    if (!this->has_output_) return Quality::MISSING;
+    if (now_ms - this->last_ms_ > this->stale_ms_) return Quality::STALE;
+    value = this->output_;
+    return this->limited_ ? Quality::LIMITED : Quality::GOOD;
+  }
+
+  void clear() {
+    this->count_ = 0;
+    this->head_ = 0;
+    this->has_output_ = false;
+  }
+
+private:
+  float median() const {
+    std::array<float, kMedianWindow> sorted = this->window_;
+    const auto end = sorted.begin() + this->count_;
+    const auto middle = sorted.begin() + this->count_ / 2;
+    std::nth_element(sorted.begin(), middle, end);
+    return *middle;
+  }
+
+  const float max_rate_per_s_;
+  const uint32_t stale_ms_;
+  const uint8_t window_size_;
+  std::array<float, kMedianWindow> window_{};
+  uint8_t count_{0};
+  uint8_t head_{0};
+  bool has_output_{false};
+  bool limited_{false};
+  float output_{0};
+  uint32_t last_ms_{0};
+};
+
+inline SensorChannel g_channel_Tin{kMaxRateTempCPerS, kStaleIndoorMs};
+inline SensorChannel g_channel_Tout{kMaxRateTempCPerS, kStaleOutdoorMs, kMedianWindowOutdoor};
+inline SensorChannel g_channel_RHi{kMaxRateRHPctPerS, kStaleIndoorMs};
+inline SensorChannel g_channel_RHo{kMaxRateRHPctPerS, kStaleOutdoorMs, kMedianWindowOutdoor};
+inline SensorChannel g_channel_CO2{kMaxRateCO2PPMPerS, kStaleIndoorMs};
+
+// Feeds the channels from their sensors.  Called once after the sensor handles are wired.
+inline void attach_sensors() {
+  const auto attach = [](esphome::sensor::Sensor* sensor, SensorChannel& channel) {
+    channel.clear();
+    if (!sensor) return;
+    if (sensor_valid(sensor)) channel.push(sensor->state, esphome::millis());
+    sensor->add_on_state_callback([&channel](float value) { channel.push(value, esphome::millis()); });
+  };
+  attach(indoor_ambient_temperature_sensor, g_channel_Tin);
+  attach(outdoor_ambient_temperature_sensor, g_channel_Tout);
+  attach(indoor_relative_humidity_sensor, g_channel_RHi);
+  attach(outdoor_relative_humidity_sensor, g_channel_RHo);
+  attach(indoor_co2_sensor, g_channel_CO2);
+}
+
+// Switches the indoor temperature between a primary (external) sensor and the on-board thermistor.
+// The selected reading is republished on an output sensor which the governor and thermostat use.
+// The primary fails over when it reports a non-finite value or nothing within the timeout, and is
+// restored after a few consecutive good readings.
+class TemperatureFailover {
+public:
+  enum class Source : uint8_t { PRIMARY = 0, FALLBACK = 1 };
+
+  void init(esphome::sensor::Sensor* primary, esphome::sensor::Sensor* fallback,
+            esphome::sensor::Sensor* output, uint32_t timeout_ms) {
+    this->output_ = output;
+    this->timeout_ms_ = timeout_ms;
+    this->last_primary_ms_ = esphome::millis();
+    primary->add_on_state_callback([this](float value) { this->on_primary(value); });
+    fallback->add_on_state_callback([this](float value) { this->on_fallback(value); });
+  }
+
+  // Checks the primary for staleness.  Returns true on the first call and whenever the source
+  // changed since the last call.
+  bool check(uint32_t now_ms) {
+    if (this->output_ && this->source_ == Source::PRIMARY && now_ms - this->last_primary_ms_ > this->timeout_ms_) {
+      this->select(Source::FALLBACK, "timed out");
+    }
+    const bool changed = !this->reported_ || this->source_ != this->reported_source_;
+    this->reported_source_ = this->source_;
+    this->reported_ = true;
+    return changed;
+  }
+
+  Source source() const { return this->source_; }
+  const char* source_name() const { return this->source_ == Source::PRIMARY ? "Primary" : "Thermistor"; }
+  bool is_offset_learned() const { return this->offset_samples_ >= kFailoverOffsetMinSamples; }
+  float offset() const { return this->offset_; }
+
+private:
+  void on_primary(float value) {
+    if (!std::isfinite(value)) {
+      this->good_primary_ = 0;
+      this->primary_value_ = NAN;
+      if (this->source_ == Source::PRIMARY) this->select(Source::FALLBACK, "failed");
+      return;
+    }
+    this->primary_value_ = value;
+    this->last_primary_ms_ = esphome::millis();
+    if (this->good_primary_ < kFailoverRecoverySamples) this->good_primary_++;
+    if (this->source_ == Source::FALLBACK && this->good_primary_ >= kFailoverRecoverySamples) {
+      this->select(Source::PRIMARY, "recovered");
+    } else if (this->source_ == Source::PRIMARY) {
+      this->output_->publish_state(value);
+    }
+  }
+
+  void on_fallback(float value) {
+    if (!std::isfinite(value)) return;
+    this->fallback_value_ = value;
+    const bool primary_fresh = esphome::millis() - this->last_primary_ms_ <= kFailoverOffsetFreshMs;
+    if (this->source_ == Source::PRIMARY && std::isfinite(this->primary_value_) && primary_fresh) {
+      const float offset = this->primary_value_ - value;
+      this->offset_ = this->offset_samples_ ? this->offset_ + kFailoverOffsetAlpha * (offset - this->offset_) : offset;
+      if (this->offset_samples_ < kFailoverOffsetMinSamples) this->offset_samples_++;
+    } else if (this->source_ == Source::FALLBACK) {
+      this->publish_fallback();
+    }
+  }
+
+  void select(Source source, const char* reason) {
+    this->source_ = source;
+    if (source == Source::PRIMARY) {
+      ESP_LOGI("governor", "Indoor temperature: primary sensor %s, switching back", reason);
+      this->output_->publish_state(this->primary_value_);
+    } else {
+      ESP_LOGW("governor", "Indoor temperature: primary sensor %s, using thermistor with offset %.2f",
+               reason, this->is_offset_learned() ? this->offset_ : 0.0f);
+      this->good_primary_ = 0;
+      this->publish_fallback();
+    }
+  }
+
+  void publish_fallback() {
+    if (!std::isfinite(this->fallback_value_)) return;
+    this->output_->publish_state(this->fallback_value_ + (this->is_offset_learned() ? this->offset_ : 0.0f));
+  }
+
+  esphome::sensor::Sensor* output_{nullptr};
+  uint32_t timeout_ms_{0};
+  Source source_{Source::PRIMARY};
+  Source reported_source_{Source::PRIMARY};
+  bool reported_{false};
+  float primary_value_{NAN};
+  float fallback_value_{NAN};
+  uint32_t last_primary_ms_{0};
+  uint8_t good_primary_{0};
+  float offset_{0};
+  uint32_t offset_samples_{0};
+};
+
+inline TemperatureFailover g_indoor_temperature_failover{};
+
+// -----------------------------------------------------------------------------
+// (1) Read sensor channels -> SensorSample
+// -----------------------------------------------------------------------------
+inline SensorSample read_sensors(uint32_t now_ms) {
+  SensorSample s{};
+  s.q_Tin  = g_channel_Tin.read(now_ms, s.Tin);   s.has_Tin  = s.q_Tin  >= Quality::LIMITED;
+  s.q_Tout = g_channel_Tout.read(now_ms, s.Tout); s.has_Tout = s.q_Tout >= Quality::LIMITED;
+  s.q_RHi  = g_channel_RHi.read(now_ms, s.RHi);   s.has_RHi  = s.q_RHi  >= Quality::LIMITED;
+  s.q_RHo  = g_channel_RHo.read(now_ms, s.RHo);   s.has_RHo  = s.q_RHo  >= Quality::LIMITED;
+  s.q_CO2  = g_channel_CO2.read(now_ms, s.CO2);   s.has_CO2  = s.q_CO2  >= Quality::LIMITED;
   return s;
 }
 
@@ -201,6 +938,7 @@ inline SensorSample read_sensors() {
 // -----------------------------------------------------------------------------
 inline SensorBundle massage_bundle(const SensorSample& s) {
   SensorBundle b{};
+  b.q_Tin = s.q_Tin; b.q_Tout = s.q_Tout; b.q_RHi = s.q_RHi; b.q_RHo = s.q_RHo; b.q_CO2 = s.q_CO2;
 
   // Clamp ranges (adjust to your sensor specs if needed)
   // Temp: [-40, 85] °C, RH: [0,100] %, CO2: [0,5000] ppm
@@ -229,21 +967,107 @@ inline SensorBundle massage_bundle(const SensorSample& s) {
 
   // Diagnostics: one-line snapshot of bundle
   ESP_LOGD("governor",
-           "Bundle: Tin=%s Tout=%s RHi=%s RHo=%s CO2=%s",
+           "Bundle: Tin=%s Tout=%s RHi=%s RHo=%s CO2=%s quality=%c%c%c%c%c",
            b.has_Tin  ? esphome::str_sprintf("%.2f/%.2f", b.Tin, b.Tin_f).c_str() : "n/a",
            b.has_Tout ? esphome::str_sprintf("%.2f", b.Tout).c_str()               : "n/a",
            b.has_RHi  ? esphome::str_sprintf("%.1f/%.1f", b.RHi, b.RHi_f).c_str()  : "n/a",
            b.has_RHo  ? esphome::str_sprintf("%.1f", b.RHo).c_str()                : "n/a",
-           b.has_CO2  ? esphome::str_sprintf("%.0f/%.0f", b.CO2, b.CO2_f).c_str()  : "n/a");
+           b.has_CO2  ? esphome::str_sprintf("%.0f/%.0f", b.CO2, b.CO2_f).c_str()  : "n/a",
+           quality_to_char(b.q_Tin), quality_to_char(b.q_Tout), quality_to_char(b.q_RHi),
+           quality_to_char(b.q_RHo), quality_to_char(b.q_CO2));
 
   return b;
 }
 
+// -----------------------------------------------------------------------------
+// Thermal model identification
+// -----------------------------------------------------------------------------
+// Feeds the thermal model with the temperature change observed over each sample period and the
+// mean fan level that was applied meanwhile.
+inline void identify_model(const SensorBundle& b, GovernorState& st, uint32_t now_ms) {
+  if (!b.has_Tin || !b.has_Tout) {
+    st.model_sampling = false;
+    return;
+  }
+
+  if (!st.model_sampling) {
+    st.model_sampling = true;
+    st.model_last_ms = st.model_level_last_ms = now_ms;
+    st.model_last_Tin = b.Tin_f;
+    st.model_level_ms = 0.0f;
+    return;
+  }
+
+  st.model_level_ms += static_cast<float>(st.model_level) * static_cast<float>(now_ms - st.model_level_last_ms);
+  st.model_level_last_ms = now_ms;
+
+  const uint32_t elapsed_ms = now_ms - st.model_last_ms;
+  if (elapsed_ms < kModelSamplePeriodMs) return;
+
+  const float elapsed_min = static_cast<float>(elapsed_ms) / 60000.0f;
+  const float mean_level  = st.model_level_ms / static_cast<float>(elapsed_ms);
+  const float Tin_mid     = 0.5f * (st.model_last_Tin + b.Tin_f);
+  const float dT          = b.Tout - Tin_mid;
+  const float y           = (b.Tin_f - st.model_last_Tin) / elapsed_min;
+
+  // Large gaps mean updates were suspended, so the interval doesn't describe the applied level
+  if (elapsed_ms <= 2 * kModelSamplePeriodMs && std::fabs(dT) >= kModelMinExcitationC) {
+    g_model.update({dT, mean_level * dT, 1.0f}, y);
+    ESP_LOGD("governor", "Model: y=%.3f dT=%.2f level=%.2f a=%.5f b=%.5f q=%.4f tau=%.0fmin n=%u",
+             y, dT, mean_level, g_model.a(), g_model.b(), g_model.q(),
+             g_model.time_constant_min(), static_cast<unsigned>(g_model.samples));
+  }
+
+  st.model_last_ms = now_ms;
+  st.model_last_Tin = b.Tin_f;
+  st.model_level_ms = 0.0f;
+}
+
+// -----------------------------------------------------------------------------
+// Level mapping
+// -----------------------------------------------------------------------------
+// Pure per-sample arithmetic shared by the controllers and the batch evaluator so both produce
+// identical levels.
+
+// Maps a drive in [0, 1] onto a level in [0, kMaxLevel] along the gamma curve.
+inline int drive_level(float drive, float gamma) {
+  return static_cast<int>(std::ceil(static_cast<float>(kMaxLevel) * std::pow(drive, gamma)));
+}
+
+// Level of a latched deadband controller: kMinOnLevel at or below the target, rising along the
+// gamma curve above it.
+inline int deadband_level(float x, float target, float span, float gamma) {
+  if (x <= target) return kMinOnLevel;
+  return std::max(kMinOnLevel, drive_level(clampf((x - target) / span, 0.0f, 1.0f), gamma));
+}
+
+// Hysteresis latch: an inactive latch engages on `on`, an active one releases on `off`.
+inline bool latch(bool active, bool on, bool off) { return active ? !off : on; }
+
+// Applies the fan mode to the combined level.  `force_min` keeps the fan at kMinOnLevel or above
+// while cooling or while any controller is active; otherwise only OFF-like levels result.
+inline int fan_mode_level(ClimateFanMode fan_mode, int level_raw, bool force_min) {
+  const int cap = fan_mode == ClimateFanMode::CLIMATE_FAN_QUIET
+                  ? std::min(g_config.max_level_quiet, kMaxLevel)
+                  : kMaxLevel;
+  switch (fan_mode) {
+    case ClimateFanMode::CLIMATE_FAN_OFF:
+      return 0;  // manual OFF wins
+    case ClimateFanMode::CLIMATE_FAN_LOW:
+      // respect min run if needed
+      return force_min ? std::clamp(std::max(level_raw, kMinOnLevel), 0, cap) : 0;
+    default:
+      return force_min ? std::clamp(std::max(level_raw, kMinOnLevel), kMinOnLevel, cap) : 0;
+  }
+}
+
 // -----------------------------------------------------------------------------
 // (3) Controllers
 // -----------------------------------------------------------------------------
-inline Determination determine_thermal(const ControlInput& input, const SensorBundle& b) {
+inline Determination determine_thermal(const ControlInput& input, const SensorBundle& b,
+                                       GovernorState& st, uint32_t now_ms) {
   Determination d{};
+  st.thermal_pi_running = false;
   if (input.action != ClimateAction::CLIMATE_ACTION_COOLING) return d;
   if (!b.has_Tin) return d;
 
@@ -259,54 +1083,140 @@ inline Determination determine_thermal(const ControlInput& input, const SensorBu
   const bool has_out = b.has_Tout ? (Tout = b.Tout, true) : false;
 
   // Don't cool below outdoor + margin
-  const float target_floor = has_out ? std::max(Tset, Tout + kOutsideMarginC) : Tset;
+  const float target_floor = has_out ? std::max(Tset, Tout + g_config.outside_margin_c) : Tset;
   const float error        = Tin - target_floor;
 
   const bool  quiet = (input.fan_mode == ClimateFanMode::CLIMATE_FAN_QUIET);
-  const float span  = quiet ? kSpanQuietC : kSpanAutoC;
-  const float gamma = quiet ? kGammaQuiet  : kGammaAuto;
-
-  const float drive   = clampf(error / span, 0.0f, 1.0f);
-  const float level_f = static_cast<float>(kMaxLevel) * std::pow(drive, gamma);
-  d.level             = static_cast<int>(std::ceil(level_f));
-  d.active            = (d.level > 0);
-  d.lid_request       = d.active;
+  const float span  = quiet ? g_config.span_quiet_c : g_config.span_auto_c;
+  const float gamma = quiet ? g_config.gamma_quiet  : g_config.gamma_auto;
+
+  if (g_thermal_mode == ThermalMode::PI) {
+    // The integral is held while the thermostat idles so each cooling cycle resumes where the
+    // last one settled; it's only cleared by reset().
+    const uint32_t step_ms = st.thermal_pi_last_ms ? now_ms - st.thermal_pi_last_ms : 0;
+    st.thermal_pi_last_ms = now_ms;
+    st.thermal_pi_dt_s    = static_cast<float>(std::min(step_ms, kPiMaxStepMs)) * 0.001f;
+
+    // Bounded by the range of the Tin clamp so that an absurd setpoint or outdoor margin can't
+    // overflow the output
+    const float kp = static_cast<float>(kMaxLevel) / span;
+    const float pi_error = clampf(error, -125.0f, 125.0f);
+    st.thermal_integral = clampf(st.thermal_integral + kp * pi_error * st.thermal_pi_dt_s / kPiIntegralTimeS,
+                                 0.0f, static_cast<float>(kMaxLevel));
+    st.thermal_pi_output  = kp * pi_error + st.thermal_integral;
+    st.thermal_pi_running = true;
+    const float level_f = clampf(st.thermal_pi_output, 0.0f, static_cast<float>(kMaxLevel));
+
+    // Hold the previous level until the output leaves its band by the hysteresis margin
+    const int prev = st.thermal_pi_level;
+    if (level_f > prev + kPiLevelHysteresis || level_f <= prev - 1 - kPiLevelHysteresis) {
+      st.thermal_pi_level = static_cast<int>(std::ceil(level_f));
+    }
+    d.level = st.thermal_pi_level;
+  } else {
+    d.level = drive_level(clampf(error / span, 0.0f, 1.0f), gamma);
+  }
+  d.active      = (d.level > 0);
+  d.lid_request = d.active;
 
   ESP_LOGD("governor",
-           "Thermal: Tin=%.2f Tout=%s Tset=%.2f target_floor=%.2f error=%.2f level=%d",
+           "Thermal: Tin=%.2f Tout=%s Tset=%.2f target_floor=%.2f error=%.2f integral=%s level=%d",
            Tin,
            has_out ? esphome::str_sprintf("%.2f", Tout).c_str() : "n/a",
-           Tset, target_floor, error, d.level);
+           Tset, target_floor, error,
+           st.thermal_pi_running ? esphome::str_sprintf("%.2f", st.thermal_integral).c_str() : "n/a",
+           d.level);
   return d;
 }
 
-inline Determination determine_co2(const SensorBundle& b, GovernorState& st) {
-  Determination d{};
-  if (!(kEnableCO2Control && g_enable_co2_control) || !b.has_CO2) return d;
+// Records CO2_f once per sample period.  A gap in the samples restarts the history.
+inline void record_co2(const SensorBundle& b, GovernorState& st, uint32_t now_ms) {
+  if (!b.has_CO2) {
+    st.co2_history_count = 0;
+    return;
+  }
+  if (st.co2_history_count) {
+    const uint32_t elapsed_ms = now_ms - st.co2_history_last_ms;
+    if (elapsed_ms < kCO2SlopeSampleMs) return;
+    if (elapsed_ms > 2 * kCO2SlopeSampleMs) st.co2_history_count = 0;
+  }
+  if (!st.co2_history_count) st.co2_history_head = 0;
+  st.co2_history[st.co2_history_head] = b.CO2_f;
+  st.co2_history_head = (st.co2_history_head + 1) % kCO2SlopeSamples;
+  if (st.co2_history_count < kCO2SlopeSamples) st.co2_history_count++;
+  st.co2_history_last_ms = now_ms;
+}
 
-  const float co2 = b.CO2_f;
-  const float target_hi = kCO2TargetPPM + kCO2DeadbandPPM;
-  const float target_lo = kCO2TargetPPM - kCO2DeadbandPPM;
+// Theil-Sen slope of the CO2 history in ppm/min: the median of the slopes between all pairs of
+// samples, which tolerates outliers that would skew a least-squares fit.  NAN if too few samples.
+inline float co2_slope_ppm_per_min(const GovernorState& st) {
+  const int n = st.co2_history_count;
+  if (n < kCO2SlopeMinSamples) return NAN;
+
+  const int oldest = (st.co2_history_head + kCO2SlopeSamples - n) % kCO2SlopeSamples;
+  const float sample_min = static_cast<float>(kCO2SlopeSampleMs) / 60000.0f;
+  std::array<float, kCO2SlopeSamples * (kCO2SlopeSamples - 1) / 2> slopes;
+  int count = 0;
+  for (int i = 0; i < n; i++) {
+    const float xi = st.co2_history[(oldest + i) % kCO2SlopeSamples];
+    for (int j = i + 1; j < n; j++) {
+      const float xj = st.co2_history[(oldest + j) % kCO2SlopeSamples];
+      slopes[count++] = (xj - xi) / (static_cast<float>(j - i) * sample_min);
+    }
+  }
+  const auto middle = slopes.begin() + count / 2;
+  std::nth_element(slopes.begin(), middle, slopes.begin() + count);
+  return clampf(*middle, -kCO2MaxSlopePPMMin, kCO2MaxSlopePPMMin);
+}
+
+inline Determination determine_co2(const SensorBundle& b, GovernorState& st, uint32_t now_ms) {
+  Determination d{};
+  if (!(kEnableCO2Control && g_enable_co2_control) || !b.has_CO2) {
+    st.co2_history_count = 0;
+    st.co2_generation = NAN;
+    return d;
+  }
 
-  // Hysteresis transitions
-  if (!st.co2_active && co2 >= target_hi) st.co2_active = true;
-  else if (st.co2_active && co2 <= target_lo) st.co2_active = false;
+  record_co2(b, st, now_ms);
+  const float slope = co2_slope_ppm_per_min(st);
+
+  // Only a rising concentration is projected so falling CO2 is handled by the deadband as before
+  const float target_hi = g_config.co2_target_ppm + g_config.co2_deadband_ppm;
+  const float target_lo = g_config.co2_target_ppm - g_config.co2_deadband_ppm;
+  const float measured  = b.CO2_f;
+  const float co2 = std::isfinite(slope) && slope > 0.0f
+                    ? std::min(measured + slope * kCO2LookaheadMin, 5000.0f)
+                    : measured;
+
+  st.co2_active = latch(st.co2_active, co2 >= target_hi, co2 <= target_lo);
+
+  // Generation rate from the mass balance over the level applied since the last update
+  float generation = NAN;
+  int level_ff = 0;
+  if (std::isfinite(slope)) {
+    const float exchange = kMpcAirChangeBaseMin + ventilation_gain() * static_cast<float>(st.model_level);
+    generation = std::max(0.0f, slope + exchange * (measured - kMpcOutdoorCO2PPM));
+    const float hold = (generation / (g_config.co2_target_ppm - kMpcOutdoorCO2PPM) - kMpcAirChangeBaseMin)
+                       / ventilation_gain();
+    level_ff = static_cast<int>(std::ceil(clampf(hold, 0.0f, static_cast<float>(kMaxLevel))));
+  }
+  st.co2_generation = generation;
 
   if (st.co2_active) {
-    if (co2 <= kCO2TargetPPM) {
-      d.level = kMinOnLevel;
-    } else {
-      const float drive   = clampf((co2 - kCO2TargetPPM) / kCO2SpanPPM, 0.0f, 1.0f);
-      const float level_f = static_cast<float>(kMaxLevel) * std::pow(drive, kCO2Gamma);
-      d.level             = std::max(kMinOnLevel, static_cast<int>(std::ceil(level_f)));
-    }
+    d.level       = std::max(deadband_level(co2, g_config.co2_target_ppm, g_config.co2_span_ppm,
+                                            g_config.co2_gamma),
+                             level_ff);
     d.active      = (d.level > 0);
     d.lid_request = d.active;
   }
 
   ESP_LOGD("governor",
-           "CO2: co2=%.0f target=%.0f deadband=%.0f active=%d level=%d",
-           co2, kCO2TargetPPM, kCO2DeadbandPPM, st.co2_active, d.level);
+           "CO2: co2=%.0f slope=%s generation=%s projected=%.0f target=%.0f deadband=%.0f "
+           "active=%d level=%d",
+           measured,
+           std::isfinite(slope) ? esphome::str_sprintf("%.1f", slope).c_str() : "n/a",
+           std::isfinite(generation) ? esphome::str_sprintf("%.1f", generation).c_str() : "n/a",
+           co2, g_config.co2_target_ppm, g_config.co2_deadband_ppm, st.co2_active, d.level);
   return d;
 }
 
@@ -320,61 +1230,404 @@ inline Determination determine_rh(const SensorBundle& b, GovernorState& st) {
   const float RHo = b.RHo;
 
   // Block evacuation if outdoor humidity >= indoor + margin
-  const bool outdoor_block = (RHo >= (RHi + kRHOutsideMarginPct));
+  const bool outdoor_block = (RHo >= (RHi + g_config.rh_outside_margin_pct));
 
-  const float target_hi = kRHTargetPct + kRHDeadbandPct;
-  const float target_lo = kRHTargetPct - kRHDeadbandPct;
+  const float target_hi = g_config.rh_target_pct + g_config.rh_deadband_pct;
+  const float target_lo = g_config.rh_target_pct - g_config.rh_deadband_pct;
 
   // Hysteresis transitions (respect outdoor gating)
-  if (!st.rh_active && !outdoor_block && (RHi >= target_hi)) {
-    st.rh_active = true;
-  } else if (st.rh_active && (RHi <= target_lo || outdoor_block)) {
-    st.rh_active = false;
-  }
+  st.rh_active = latch(st.rh_active, !outdoor_block && RHi >= target_hi, RHi <= target_lo || outdoor_block);
 
   if (st.rh_active) {
-    if (RHi <= kRHTargetPct) {
-      d.level = kMinOnLevel;
-    } else {
-      const float span   = (kRHSpanHiPct - kRHSpanLoPct); // 40% per spec
-      const float drive  = clampf((RHi - kRHTargetPct) / span, 0.0f, 1.0f);
-      const float level_f= static_cast<float>(kMaxLevel) * std::pow(drive, kRHGamma);
-      d.level            = std::max(kMinOnLevel, static_cast<int>(std::ceil(level_f)));
-    }
+    const float span = (g_config.rh_span_hi_pct - g_config.rh_span_lo_pct); // 40% per spec
+    d.level       = deadband_level(RHi, g_config.rh_target_pct, span, g_config.rh_gamma);
     d.active      = (d.level > 0);
     d.lid_request = d.active;
   }
 
   ESP_LOGD("governor",
            "RH: RHi=%.1f RHo=%.1f target=%.1f deadband=%.1f block=%d active=%d level=%d",
-           RHi, RHo, kRHTargetPct, kRHDeadbandPct, outdoor_block, st.rh_active, d.level);
+           RHi, RHo, g_config.rh_target_pct, g_config.rh_deadband_pct, outdoor_block, st.rh_active, d.level);
   return d;
 }
 
 // -----------------------------------------------------------------------------
-// (4) Combine determinations
+// Psychrometrics
 // -----------------------------------------------------------------------------
-inline void combine(const Determination& t,
-                    const Determination& c,
-                    const Determination& h,
-                    int& level_raw,
-                    bool& any_controller_active,
-                    bool& any_lid_request,
-                    ActiveController& pre_override_active) {
-  level_raw = std::max({t.level, c.level, h.level});
-  any_controller_active = (t.active || c.active || h.active);
-  any_lid_request       = (t.lid_request || c.lid_request || h.lid_request);
+// Saturation vapor pressure in kPa over water (Magnus formula).
+inline float saturation_pressure_kpa(float t_c) {
+  return 0.61094f * std::exp(17.625f * t_c / (t_c + 243.04f));
+}
 
-  // Deterministic tie-breaker: Thermal > CO2 > RH
-  pre_override_active = ActiveController::OFF;
-  int best = 0;
-  if (t.level > best) { best = t.level; pre_override_active = ActiveController::THERMAL; }
-  if (c.level > best) { best = c.level; pre_override_active = ActiveController::CO2; }
-  if (h.level > best) { best = h.level; pre_override_active = ActiveController::RH; }
+// Humidity ratio in kg water per kg dry air.
+inline float humidity_ratio(float t_c, float rh_pct) {
+  const float pw = clampf(rh_pct, 0.0f, 100.0f) * 0.01f * saturation_pressure_kpa(t_c);
+  return 0.622f * pw / std::max(kEconomizerPressureKPa - pw, 1.0f);
+}
+
+// Relative humidity in percent of air at a given temperature and humidity ratio.
+inline float relative_humidity(float t_c, float w) {
+  const float pw = kEconomizerPressureKPa * w / (0.622f + w);
+  return 100.0f * pw / saturation_pressure_kpa(t_c);
+}
+
+// Specific enthalpy of moist air in kJ per kg dry air.
+inline float enthalpy_kjkg(float t_c, float rh_pct) {
+  const float w = humidity_ratio(t_c, rh_pct);
+  return 1.006f * t_c + w * (2501.0f + 1.86f * t_c);
 }
 
 // -----------------------------------------------------------------------------
-// (5) Apply inhibiting overrides (fan mode + min-speed rule + lid overrides)
+// Predictive model
+// -----------------------------------------------------------------------------
+// The horizon is simulated in fixed point for all candidates at once: the states are Q8,
+// the per-step rate coefficients are Q12 and each inner loop runs across the candidate levels.
+static constexpr int kMpcCandidates = kMaxLevel + 1;
+static constexpr int kMpcStateQ = 8;
+static constexpr int kMpcRateQ  = 12;
+// Bounds on the simulated inputs that keep the Q8 states and their products with the Q12 rates
+// within 32 bits over the horizon.  Only a misbehaving sensor or model leaves them.
+static constexpr float kMpcMaxAbsTempC      = 200.0f;
+static constexpr float kMpcMaxAbsHeatGainCMin = 10.0f;
+static constexpr float kMpcMaxCO2PPM        = 5000.0f;
+static constexpr float kMpcMaxHumidityGkg   = 500.0f;
+
+inline int32_t to_fixed(float x, int q) { return static_cast<int32_t>(std::lround(x * float(1 << q))); }
+inline float from_fixed(int32_t x, int q) { return static_cast<float>(x) / float(1 << q); }
+
+// Converts a simulated input to fixed point after bringing it into [lo, hi], taking NaN as lo.
+inline int32_t to_fixed_bounded(float x, float lo, float hi, int q) {
+  return to_fixed(std::isnan(x) ? lo : clampf(x, lo, hi), q);
+}
+
+// Predicted states after the horizon, indexed by candidate level.
+struct Prediction {
+  std::array<float, kMpcCandidates> Tin{}, CO2{}, RHi{};
+};
+
+inline Prediction predict(const SensorBundle& b, const GovernorState& st) {
+  const ThermalModel& m = g_model;
+  const bool trusted = m.is_trusted();
+  const float a = trusted ? m.a() : kModelInitialA;
+  const float g = ventilation_gain();
+  const float q = trusted ? m.q() : kModelInitialQ;
+
+  // Rate coefficients per candidate, clamped to 1 per step for Euler stability
+  std::array<int32_t, kMpcCandidates> kT{}, kA{};
+  for (int L = 0; L < kMpcCandidates; L++) {
+    kT[L] = to_fixed(clampf(a + g * L, 0.0f, 1.0f), kMpcRateQ);
+    kA[L] = to_fixed(clampf(kMpcAirChangeBaseMin + g * L, 0.0f, 1.0f), kMpcRateQ);
+  }
+
+  // Humidity ratio in g/kg so that it has enough resolution in Q8
+  const bool has_rh = b.has_RHi && b.has_RHo && b.has_Tout;
+  const float Wi = has_rh ? 1000.0f * humidity_ratio(b.Tin_f, b.RHi_f) : 0.0f;
+  const float Wo = has_rh ? 1000.0f * humidity_ratio(b.Tout, b.RHo) : 0.0f;
+
+  const int32_t To  = to_fixed_bounded(b.has_Tout ? b.Tout : b.Tin_f, -kMpcMaxAbsTempC, kMpcMaxAbsTempC, kMpcStateQ);
+  const int32_t Co  = to_fixed(kMpcOutdoorCO2PPM, kMpcStateQ - 4);  // CO2 in Q4 to fit 5000 ppm
+  const int32_t Wo_ = to_fixed_bounded(Wo, 0.0f, kMpcMaxHumidityGkg, kMpcStateQ);
+  const int32_t qT  = to_fixed_bounded(q, -kMpcMaxAbsHeatGainCMin, kMpcMaxAbsHeatGainCMin, kMpcStateQ);
+  const float generation = std::isfinite(st.co2_generation)
+                           ? clampf(st.co2_generation, 0.0f, kMpcCO2GenerationMaxPPMMin)
+                           : kMpcCO2GenerationPPMMin;
+  const int32_t qC  = to_fixed(generation, kMpcStateQ - 4);
+  const int32_t qW  = to_fixed(kMpcMoistureGenerationGkgMin, kMpcStateQ);
+
+  std::array<int32_t, kMpcCandidates> T, C, W;
+  T.fill(to_fixed_bounded(b.Tin_f, -kMpcMaxAbsTempC, kMpcMaxAbsTempC, kMpcStateQ));
+  C.fill(to_fixed_bounded(b.has_CO2 ? b.CO2_f : kMpcOutdoorCO2PPM, 0.0f, kMpcMaxCO2PPM, kMpcStateQ - 4));
+  W.fill(to_fixed_bounded(Wi, 0.0f, kMpcMaxHumidityGkg, kMpcStateQ));
+
+  for (int step = 0; step < kMpcHorizonMin; step++) {
+    for (int L = 0; L < kMpcCandidates; L++) T[L] += (((To - T[L]) * kT[L]) >> kMpcRateQ) + qT;
+    for (int L = 0; L < kMpcCandidates; L++) C[L] += (((Co - C[L]) * kA[L]) >> kMpcRateQ) + qC;
+    for (int L = 0; L < kMpcCandidates; L++) W[L] += (((Wo_ - W[L]) * kA[L]) >> kMpcRateQ) + qW;
+  }
+
+  Prediction p{};
+  for (int L = 0; L < kMpcCandidates; L++) {
+    p.Tin[L] = from_fixed(T[L], kMpcStateQ);
+    p.CO2[L] = from_fixed(C[L], kMpcStateQ - 4);
+    p.RHi[L] = has_rh ? relative_humidity(p.Tin[L], from_fixed(W[L], kMpcStateQ) * 0.001f) : NAN;
+  }
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+// (4) Controller registry
+// -----------------------------------------------------------------------------
+// A controller is a stateless type describing how to run one determine_* function:
+//  - NAME and PRIORITY: reporting name and tie-breaker when levels are equal (higher wins)
+//  - PERIOD_MS and inputs(): the controller reruns when its inputs change or the period elapses
+//  - determine(): produces the Determination
+//  - meets_target() (optional): whether a predicted state satisfies the controller, used by the
+//    predictive strategy; controllers without it don't constrain the search
+// Add a controller by defining such a type and listing it in Controllers.
+template <typename C>
+concept Controller = requires(const ControlInput& input, const SensorBundle& b, GovernorState& st) {
+  { C::NAME } -> std::convertible_to<const char*>;
+  { C::PRIORITY } -> std::convertible_to<uint8_t>;
+  { C::PERIOD_MS } -> std::convertible_to<uint32_t>;
+  { C::inputs(input, b, st) } -> std::same_as<std::array<float, C::INPUT_COUNT>>;
+  { C::determine(input, b, st, uint32_t{}) } -> std::same_as<Determination>;
+};
+
+template <typename C>
+concept PredictiveController = requires(const Prediction& p, const ControlInput& input, const SensorBundle& b) {
+  { C::meets_target(p, 0, input, b) } -> std::same_as<bool>;
+};
+
+struct ThermalController {
+  static constexpr const char* NAME = "Thermal";
+  static constexpr uint8_t PRIORITY = 3;
+  static constexpr uint32_t PERIOD_MS = kThermalPeriodMs;
+  static constexpr size_t INPUT_COUNT = 6;
+
+  static std::array<float, INPUT_COUNT> inputs(const ControlInput& input, const SensorBundle& b,
+                                               const GovernorState&) {
+    return {
+      b.has_Tin ? b.Tin_f : NAN, b.has_Tout ? b.Tout : NAN,
+      input.target_temperature, static_cast<float>(input.action),
+      static_cast<float>(input.fan_mode), static_cast<float>(g_thermal_mode),
+    };
+  }
+
+  static Determination determine(const ControlInput& input, const SensorBundle& b,
+                                 GovernorState& st, uint32_t now_ms) {
+    return determine_thermal(input, b, st, now_ms);
+  }
+
+  static bool meets_target(const Prediction& p, int level, const ControlInput& input, const SensorBundle& b) {
+    float Tmax = input.target_temperature + kMpcTemperatureToleranceC;
+    if (b.has_Tout) Tmax = std::max(Tmax, b.Tout + g_config.outside_margin_c);
+    return p.Tin[level] <= Tmax;
+  }
+};
+
+struct CO2Controller {
+  static constexpr const char* NAME = "CO2";
+  static constexpr uint8_t PRIORITY = 2;
+  static constexpr uint32_t PERIOD_MS = kCO2PeriodMs;
+  static constexpr size_t INPUT_COUNT = 4;
+
+  static std::array<float, INPUT_COUNT> inputs(const ControlInput&, const SensorBundle& b,
+                                               const GovernorState& st) {
+    return {
+      b.has_CO2 ? b.CO2_f : NAN, static_cast<float>(g_enable_co2_control),
+      static_cast<float>(st.model_level), static_cast<float>(st.co2_active),
+    };
+  }
+
+  static Determination determine(const ControlInput&, const SensorBundle& b,
+                                 GovernorState& st, uint32_t now_ms) {
+    return determine_co2(b, st, now_ms);
+  }
+
+  static bool meets_target(const Prediction& p, int level, const ControlInput&, const SensorBundle&) {
+    return p.CO2[level] <= g_config.co2_target_ppm;
+  }
+};
+
+struct RHController {
+  static constexpr const char* NAME = "RH";
+  static constexpr uint8_t PRIORITY = 1;
+  static constexpr uint32_t PERIOD_MS = kRHPeriodMs;
+  static constexpr size_t INPUT_COUNT = 4;
+
+  static std::array<float, INPUT_COUNT> inputs(const ControlInput&, const SensorBundle& b,
+                                               const GovernorState& st) {
+    return {
+      b.has_RHi ? b.RHi_f : NAN, b.has_RHo ? b.RHo : NAN,
+      static_cast<float>(g_enable_rh_control), static_cast<float>(st.rh_active),
+    };
+  }
+
+  static Determination determine(const ControlInput&, const SensorBundle& b,
+                                 GovernorState& st, uint32_t) {
+    return determine_rh(b, st);
+  }
+
+  static bool meets_target(const Prediction& p, int level, const ControlInput&, const SensorBundle&) {
+    return p.RHi[level] <= g_config.rh_target_pct;
+  }
+};
+
+// Combined view of all determinations.
+struct Combined {
+  int level_raw{0};
+  bool any_active{false};
+  bool any_lid_request{false};
+  ActiveController active{kNoActiveController};
+};
+
+// Runs and combines a fixed set of controllers.  Everything is expanded at compile time.
+template <Controller... Cs>
+class ControllerRegistry {
+public:
+  static constexpr size_t COUNT = sizeof...(Cs);
+  using Determinations = std::array<Determination, COUNT>;
+
+  // Runs each controller unless its inputs are bitwise unchanged and its period hasn't elapsed,
+  // in which case its last determination is reused.
+  Determinations determine(const ControlInput& input, const SensorBundle& b,
+                           GovernorState& st, uint32_t now_ms) {
+    Determinations d{};
+    this->determine_each(input, b, st, now_ms, d, std::index_sequence_for<Cs...>{});
+    return d;
+  }
+
+  void invalidate() {
+    std::apply([](auto&... slot) { ((slot.cache.valid = false), ...); }, this->slots_);
+  }
+
+  // Takes the maximum level.  The active controller is the one with the highest level, ties going
+  // to the higher PRIORITY.
+  static Combined combine(const Determinations& d) {
+    Combined c{};
+    int best_level = 0;
+    uint8_t best_priority = 0;
+    size_t i = 0;
+    ((combine_one(d[i], Cs::PRIORITY, i, c, best_level, best_priority), i++), ...);
+    return c;
+  }
+
+  // True if every active controller that can evaluate predictions is satisfied at this level.
+  static bool meets_targets(const Determinations& d, const Prediction& p, int level,
+                            const ControlInput& input, const SensorBundle& b) {
+    size_t i = 0;
+    bool ok = true;
+    ((ok = ok && (!d[i].active || meets_target<Cs>(p, level, input, b)), i++), ...);
+    return ok;
+  }
+
+  static const char* name(ActiveController active) {
+    static constexpr const char* NAMES[] = {"Off", Cs::NAME...};
+    return active <= COUNT ? NAMES[active] : "Off";
+  }
+
+  // Reports the invocation counts as runs/skips, such as "Thermal 120/480, CO2 30/570".
+  std::string describe_stats() const {
+    std::string text;
+    std::apply([&](const auto&... slot) {
+      size_t i = 0;
+      ((text += esphome::str_sprintf("%s%s %u/%u", i ? ", " : "", NAMES_[i],
+            static_cast<unsigned>(slot.stats.runs), static_cast<unsigned>(slot.stats.skips)), i++), ...);
+    }, this->slots_);
+    return text;
+  }
+
+private:
+  template <Controller C>
+  struct Slot {
+    ControllerCache<C::INPUT_COUNT> cache{};
+    ControllerStats stats{};
+  };
+
+  static constexpr const char* NAMES_[] = {Cs::NAME...};
+
+  template <size_t... Is>
+  void determine_each(const ControlInput& input, const SensorBundle& b, GovernorState& st,
+                      uint32_t now_ms, Determinations& d, std::index_sequence<Is...>) {
+    ((d[Is] = run<Cs>(std::get<Is>(this->slots_), input, b, st, now_ms)), ...);
+  }
+
+  template <Controller C>
+  static Determination run(Slot<C>& slot, const ControlInput& input, const SensorBundle& b,
+                           GovernorState& st, uint32_t now_ms) {
+    const auto inputs = C::inputs(input, b, st);
+    auto& cache = slot.cache;
+    if (cache.valid && now_ms - cache.last_ms < C::PERIOD_MS
+        && std::memcmp(cache.inputs.data(), inputs.data(), sizeof(inputs)) == 0) {
+      slot.stats.skips++;
+      return cache.determination;
+    }
+    slot.stats.runs++;
+    cache.inputs = inputs;
+    cache.determination = C::determine(input, b, st, now_ms);
+    cache.last_ms = now_ms;
+    cache.valid = true;
+    return cache.determination;
+  }
+
+  static void combine_one(const Determination& d, uint8_t priority, size_t index,
+                          Combined& c, int& best_level, uint8_t& best_priority) {
+    c.level_raw       = std::max(c.level_raw, d.level);
+    c.any_active      = c.any_active || d.active;
+    c.any_lid_request = c.any_lid_request || d.lid_request;
+    if (d.level > best_level || (d.level > 0 && d.level == best_level && priority > best_priority)) {
+      c.active      = static_cast<ActiveController>(index + 1);
+      best_level    = d.level;
+      best_priority = priority;
+    }
+  }
+
+  template <typename C>
+  static bool meets_target(const Prediction& p, int level, const ControlInput& input, const SensorBundle& b) {
+    if constexpr (PredictiveController<C>) return C::meets_target(p, level, input, b);
+    else return true;
+  }
+
+  std::tuple<Slot<Cs>...> slots_{};
+};
+
+using Controllers = ControllerRegistry<ThermalController, CO2Controller, RHController>;
+static_assert(Controllers::COUNT < 255, "ActiveController must fit the controller indices");
+
+inline Controllers g_controllers{};
+
+inline void invalidate_controllers() { g_controllers.invalidate(); }
+
+inline std::string describe_controller_stats() { return g_controllers.describe_stats(); }
+
+// Returns the lowest level predicted to meet the targets of all active controllers, or -1 if no
+// level does.
+inline int select_predictive_level(const ControlInput& input,
+                                   const SensorBundle& b,
+                                   const GovernorState& st,
+                                   const Controllers::Determinations& d) {
+  const Prediction p = predict(b, st);
+  for (int L = kMinOnLevel; L <= kMaxLevel; L++) {
+    if (!Controllers::meets_targets(d, p, L, input, b)) continue;
+    ESP_LOGD("governor", "Predictive: level=%d Tin=%.2f CO2=%.0f RHi=%.1f",
+             L, p.Tin[L], p.CO2[L], p.RHi[L]);
+    return L;
+  }
+  ESP_LOGD("governor", "Predictive: infeasible, Tin=%.2f CO2=%.0f RHi=%.1f at max level",
+           p.Tin[kMaxLevel], p.CO2[kMaxLevel], p.RHi[kMaxLevel]);
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// (5) Economizer: pick the direction that removes the most heat and moisture
+// -----------------------------------------------------------------------------
+inline Direction determine_direction(const SensorBundle& b, GovernorState& st) {
+  if (!b.has_Tin || !b.has_Tout) {
+    st.economizer_intake = false;
+    return Direction::NONE;
+  }
+
+  const bool use_enthalpy = b.has_RHi && b.has_RHo;
+  float advantage, on, off;
+  if (use_enthalpy) {
+    advantage = enthalpy_kjkg(b.Tin_f, b.RHi_f) - enthalpy_kjkg(b.Tout, b.RHo);
+    on = kEconomizerIntakeOnKJkg; off = kEconomizerIntakeOffKJkg;
+  } else {
+    advantage = b.Tin_f - b.Tout;
+    on = kEconomizerIntakeOnC; off = kEconomizerIntakeOffC;
+  }
+
+  if (!st.economizer_intake && advantage >= on) st.economizer_intake = true;
+  else if (st.economizer_intake && advantage <= off) st.economizer_intake = false;
+
+  const Direction direction = st.economizer_intake ? Direction::INTAKE : Direction::EXHAUST;
+  ESP_LOGD("governor", "Economizer: basis=%s advantage=%.2f direction=%s",
+           use_enthalpy ? "enthalpy" : "dry-bulb", advantage, direction_to_str(direction));
+  return direction;
+}
+
+// -----------------------------------------------------------------------------
+// (6) Apply inhibiting overrides (fan mode + min-speed rule + lid overrides)
 // -----------------------------------------------------------------------------
 inline void apply_overrides(const ControlInput& input,
                             int level_raw,
@@ -382,55 +1635,20 @@ inline void apply_overrides(const ControlInput& input,
                             bool any_lid_request,
                             ControlOutput& output) {
   // Publish active-controller intent with first-publish debounce
-  static ActiveController last_active = ActiveController::OFF;
+  static ActiveController last_active = kNoActiveController;
   static bool published_once = false;
   if (!published_once || output.active_controller != last_active) {
     last_active = output.active_controller;
     published_once = true;
     #ifdef ESPHOME_VERSION_CODE
-    id(minuet_active_controller).publish_state(active_controller_to_str(last_active));
+    id(minuet_active_controller).publish_state(Controllers::name(last_active));
     #endif
   }
 
   const bool cooling_active   = (input.action == ClimateAction::CLIMATE_ACTION_COOLING);
   const bool should_force_min = cooling_active || any_controller_active;
 
-  int level = level_raw;
-  switch (input.fan_mode) {
-    case ClimateFanMode::CLIMATE_FAN_OFF:
-      level = 0; // manual OFF wins
-      break;
-
-    case ClimateFanMode::CLIMATE_FAN_LOW:
-      // respect min run if needed
-      level = should_force_min ? std::max(level_raw, kMinOnLevel) : 0;
-      break;
-
-    case ClimateFanMode::CLIMATE_FAN_QUIET: {
-      const int cap = std::min(kMaxLevelQuiet, kMaxLevel);
-      if (should_force_min) {
-        level = std::clamp(std::max(level_raw, kMinOnLevel), kMinOnLevel, cap);
-      } else {
-        level = 0;
-      }
-      break;
-    }
-
-    case ClimateFanMode::CLIMATE_FAN_AUTO:
-    default:
-      if (should_force_min) {
-        level = std::clamp(std::max(level_raw, kMinOnLevel), kMinOnLevel, kMaxLevel);
-      } else {
-        level = 0;
-      }
-      break;
-  }
-
-  // Final clamp to correct cap for the current mode
-  const int global_cap = (input.fan_mode == ClimateFanMode::CLIMATE_FAN_QUIET)
-                         ? std::min(kMaxLevelQuiet, kMaxLevel)
-                         : kMaxLevel;
-  level = std::clamp(level, 0, global_cap);
+  const int level = fan_mode_level(input.fan_mode, level_raw, should_force_min);
 
   // Default lid policy: open if any controller requested airflow
   output.lid_open  = any_lid_request;
@@ -445,36 +1663,159 @@ inline void apply_overrides(const ControlInput& input,
   }
 }
 
+// Back-calculation anti-windup: bleeds the thermal integral toward what the fan actually ran at
+// when the fan mode caps or overrides kept the level below the PI output.  A higher level demanded
+// by another controller is not saturation, so it doesn't feed back.
+inline void unwind_thermal_integral(const ControlOutput& output, GovernorState& st) {
+  if (!st.thermal_pi_running) return;
+  const float applied = output.lid_open ? static_cast<float>(output.fan_speed) : 0.0f;
+  const float excess  = st.thermal_pi_output - clampf(st.thermal_pi_output, 0.0f, applied);
+  if (excess <= 0.0f) return;
+  st.thermal_integral = std::max(0.0f,
+      st.thermal_integral - excess * std::min(st.thermal_pi_dt_s / kPiTrackingTimeS, 1.0f));
+}
+
 // -----------------------------------------------------------------------------
-// (6) Main control entry
+// (7) Main control entry
 // -----------------------------------------------------------------------------
 [[nodiscard]] inline ControlOutput update(const ControlInput& input) {
   ControlOutput output{};
 
+  const uint32_t now_ms = esphome::millis();
+
   // (1) Read
-  SensorSample sample = read_sensors();
+  SensorSample sample = read_sensors(now_ms);
 
   // (2) Massage & bundle
   SensorBundle bundle = massage_bundle(sample);
+  identify_model(bundle, g_state, now_ms);
 
   // (3) Controllers
-  Determination det_thermal = determine_thermal(input, bundle);
-  Determination det_co2     = determine_co2(bundle, g_state);
-  Determination det_rh      = determine_rh(bundle, g_state);
+  g_state.thermal_pi_dt_s = 0.0f;  // nothing to unwind unless the thermal controller runs
+  const Controllers::Determinations determinations = g_controllers.determine(input, bundle, g_state, now_ms);
 
   // (4) Combine
-  int level_raw = 0;
-  bool any_controller_active = false;
-  bool any_lid_request = false;
-  ActiveController pre_override_active = ActiveController::OFF;
-  combine(det_thermal, det_co2, det_rh,
-          level_raw, any_controller_active, any_lid_request, pre_override_active);
-  output.active_controller = pre_override_active;
-
-  // (5) Overrides -> (6) Output
-  apply_overrides(input, level_raw, any_controller_active, any_lid_request, output);
+  const Combined combined = Controllers::combine(determinations);
+  int level_raw = combined.level_raw;
+  output.active_controller = combined.active;
+
+  // Predictive search replaces the proportional level; fall back to it when no level suffices
+  if (g_control_strategy == ControlStrategy::PREDICTIVE && combined.any_active && bundle.has_Tin) {
+    const int level = select_predictive_level(input, bundle, g_state, determinations);
+    if (level >= 0) level_raw = level;
+  }
+
+  // (5) Economizer
+  output.direction = determine_direction(bundle, g_state);
+
+  // (6) Overrides -> (7) Output
+  apply_overrides(input, level_raw, combined.any_active, combined.any_lid_request, output);
+  unwind_thermal_integral(output, g_state);
+  g_state.model_level = output.lid_open ? output.fan_speed : 0;
   return output;
 }
 
+// -----------------------------------------------------------------------------
+// Batch evaluation
+// -----------------------------------------------------------------------------
+// Evaluates the proportional decision over many independent samples laid out as structure of
+// arrays, for replaying recorded data and trying out configurations off the device.  Each lane
+// gets exactly the level and lid that update() returns for the same readings from a freshly reset
+// governor whose latches hold the lane's state, with the proportional thermal mode and strategy and
+// LidMode::AUTO.  There is no filtering, CO2 history, model or economizer.  A non-finite reading
+// counts as missing, as it does in the sensor channels.
+struct BatchInput {
+  const float* Tin;
+  const float* Tout;
+  const float* RHi;
+  const float* RHo;
+  const float* CO2;
+  const float* target;
+  const uint8_t* fan_mode;  // ClimateFanMode
+  const uint8_t* cooling;   // nonzero when the thermostat action is cooling
+};
+
+// Hysteresis latches, read and updated in place
+struct BatchState {
+  uint8_t* co2_active;
+  uint8_t* rh_active;
+};
+
+struct BatchOutput {
+  uint8_t* level;
+  uint8_t* lid;
+};
+
+// Lanes are processed in chunks.  Gating, clamping and the drive arithmetic are branch-free so the
+// compiler can vectorize them; the gamma curves go through the scalar drive_level() and
+// deadband_level() so every lane rounds exactly as the controllers do.
+inline void decide_batch(const BatchInput& in, const BatchState& st, const BatchOutput& out, size_t n) {
+  constexpr size_t kChunk = 64;
+
+  const bool  co2_enabled = kEnableCO2Control && g_enable_co2_control;
+  const bool  rh_enabled  = kEnableRHControl && g_enable_rh_control;
+  const float co2_hi  = g_config.co2_target_ppm + g_config.co2_deadband_ppm;
+  const float co2_lo  = g_config.co2_target_ppm - g_config.co2_deadband_ppm;
+  const float rh_hi   = g_config.rh_target_pct + g_config.rh_deadband_pct;
+  const float rh_lo   = g_config.rh_target_pct - g_config.rh_deadband_pct;
+  const float rh_span = g_config.rh_span_hi_pct - g_config.rh_span_lo_pct;
+
+  float   drive[kChunk], gamma[kChunk], co2[kChunk], rhi[kChunk];
+  uint8_t thermal_on[kChunk];
+  int     level_thermal[kChunk], level_co2[kChunk], level_rh[kChunk];
+
+  for (size_t base = 0; base < n; base += kChunk) {
+    const size_t m = std::min(kChunk, n - base);
+
+    // Gating, latches and thermal drive
+    for (size_t i = 0; i < m; i++) {
+      const size_t k = base + i;
+
+      const bool  quiet   = in.fan_mode[k] == static_cast<uint8_t>(ClimateFanMode::CLIMATE_FAN_QUIET);
+      const float Tin     = clampf(in.Tin[k], -40.0f, 85.0f);
+      const float Tout    = clampf(in.Tout[k], -40.0f, 85.0f);
+      const float Tset    = in.target[k];
+      const float floor_c = std::isfinite(in.Tout[k]) ? std::max(Tset, Tout + g_config.outside_margin_c) : Tset;
+      const float span    = quiet ? g_config.span_quiet_c : g_config.span_auto_c;
+      thermal_on[i] = in.cooling[k] && std::isfinite(in.Tin[k]) && std::isfinite(Tset);
+      drive[i] = clampf((Tin - floor_c) / span, 0.0f, 1.0f);
+      gamma[i] = quiet ? g_config.gamma_quiet : g_config.gamma_auto;
+
+      const bool has_co2 = co2_enabled && std::isfinite(in.CO2[k]);
+      co2[i] = clampf(in.CO2[k], 0.0f, 5000.0f);
+      const uint8_t co2_latch = latch(st.co2_active[k], co2[i] >= co2_hi, co2[i] <= co2_lo);
+      st.co2_active[k] = has_co2 ? co2_latch : st.co2_active[k];
+      level_co2[i] = has_co2 && co2_latch;  // nonzero marks lanes that need a CO2 level
+
+      const bool  has_rh = rh_enabled && std::isfinite(in.RHi[k]) && std::isfinite(in.RHo[k]);
+      rhi[i] = clampf(in.RHi[k], 0.0f, 100.0f);
+      const float rho   = clampf(in.RHo[k], 0.0f, 100.0f);
+      const bool  block = rho >= rhi[i] + g_config.rh_outside_margin_pct;
+      const uint8_t rh_latch = latch(st.rh_active[k], !block && rhi[i] >= rh_hi, rhi[i] <= rh_lo || block);
+      st.rh_active[k] = has_rh ? rh_latch : st.rh_active[k];
+      level_rh[i] = has_rh && rh_latch;
+    }
+
+    // Gamma curves
+    for (size_t i = 0; i < m; i++) {
+      level_thermal[i] = thermal_on[i] ? drive_level(drive[i], gamma[i]) : 0;
+      if (level_co2[i]) {
+        level_co2[i] = deadband_level(co2[i], g_config.co2_target_ppm, g_config.co2_span_ppm, g_config.co2_gamma);
+      }
+      if (level_rh[i]) level_rh[i] = deadband_level(rhi[i], g_config.rh_target_pct, rh_span, g_config.rh_gamma);
+    }
+
+    // Combine and fan mode
+    for (size_t i = 0; i < m; i++) {
+      const size_t k = base + i;
+      const int  level_raw  = std::max(std::max(level_thermal[i], level_co2[i]), level_rh[i]);
+      const bool any_active = level_raw > 0;
+      out.level[k] = static_cast<uint8_t>(
+          fan_mode_level(static_cast<ClimateFanMode>(in.fan_mode[k]), level_raw, in.cooling[k] || any_active));
+      out.lid[k]   = any_active;
+    }
+  }
+}
+
 }  // namespace governor
 }  // namespace minuet
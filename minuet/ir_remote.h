@@ -0,0 +1,414 @@
+// MINUET INFRARED REMOTE CONTROL
+//
+// Filters the frames received from the Maxxfan remote and lets the user teach Minuet to respond
+// to the keys of any NEC infrared remote.
+//
+// Maxxfan frames: the remote retransmits each frame several times and every frame carries the
+// complete state of the remote.  Identical frames received within a window are dropped and the
+// frames of a burst are coalesced so that only the latest one is applied.
+//
+// Learning: choose an action, press the learn button, then press a key on the remote.  The
+// key's address and command are bound to the action.  Learned codes take precedence over the
+// codes handled by accessories such as the light remote.
+//
+// Storage: each mapping is packed into 32 bits (address, command, action) in a global array
+// that is restored from flash.  The array is expanded into a 256-entry action table for each
+// distinct address so that dispatching a received code is a table lookup.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "core.h"
+#include "tone.h"
+#include "esphome/components/remote_base/nec_protocol.h"
+#include "esphome/core/log.h"
+
+namespace minuet {
+namespace ir_remote {
+
+// -----------------------------------------------------------------------------
+// Maxxfan remote frames
+// -----------------------------------------------------------------------------
+
+// The state carried by a Maxxfan remote frame.
+struct MaxxfanFrame {
+  bool auto_mode;
+  bool fan_exhaust;
+  bool fan_on;
+  bool cover_open;
+  bool warn;
+  uint8_t auto_temperature; // °F
+  uint8_t fan_speed;        // percent
+
+  // Packs the frame into a key that identifies it uniquely.
+  constexpr uint32_t pack() const {
+    return uint32_t(this->auto_mode) | (uint32_t(this->fan_exhaust) << 1) | (uint32_t(this->fan_on) << 2)
+        | (uint32_t(this->cover_open) << 3) | (uint32_t(this->warn) << 4)
+        | (uint32_t(this->auto_temperature) << 8) | (uint32_t(this->fan_speed) << 16);
+  }
+};
+
+struct MaxxfanCounters {
+  uint32_t received{0};
+  uint32_t dropped{0};
+  uint32_t applied{0};
+};
+
+inline MaxxfanCounters g_maxxfan_counters{};
+inline MaxxfanFrame g_maxxfan_pending{};
+inline bool g_maxxfan_has_pending{false};
+inline uint32_t g_maxxfan_last_key{0};
+inline uint32_t g_maxxfan_last_ms{0};
+inline bool g_maxxfan_has_last{false};
+
+// Accepts a frame unless it is identical to the previous frame and arrived within the window
+// after it.  The window restarts with each duplicate so that a retransmitting remote stays quiet.
+// An accepted frame replaces any pending frame that has not been applied yet.
+// Returns true if the frame was accepted and should be applied after the burst settles.
+bool receive_maxxfan(const MaxxfanFrame& frame, uint32_t now_ms, uint32_t duplicate_window_ms) {
+  g_maxxfan_counters.received++;
+  const uint32_t key = frame.pack();
+  const bool duplicate = g_maxxfan_has_last && key == g_maxxfan_last_key
+      && now_ms - g_maxxfan_last_ms < duplicate_window_ms;
+  g_maxxfan_last_key = key;
+  g_maxxfan_last_ms = now_ms;
+  g_maxxfan_has_last = true;
+  if (duplicate) {
+    g_maxxfan_counters.dropped++;
+    return false;
+  }
+  if (g_maxxfan_has_pending) {
+    g_maxxfan_counters.dropped++; // superseded before it was applied
+  }
+  g_maxxfan_pending = frame;
+  g_maxxfan_has_pending = true;
+  return true;
+}
+
+// Takes the latest accepted frame for application.  Returns false if there is none.
+bool take_maxxfan(MaxxfanFrame& frame) {
+  if (!g_maxxfan_has_pending) return false;
+  frame = g_maxxfan_pending;
+  g_maxxfan_has_pending = false;
+  g_maxxfan_counters.applied++;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Learned NEC remote codes
+// -----------------------------------------------------------------------------
+
+// Actions that can be bound to a key.
+// The values are stored in flash so existing values must not change.
+enum class Action : uint8_t {
+  NONE = 0,
+  LIGHT_TOGGLE = 1,
+  LIGHT_BRIGHTER = 2,
+  LIGHT_DIMMER = 3,
+  FAN_TOGGLE = 4,
+  FAN_FASTER = 5,
+  FAN_SLOWER = 6,
+  FAN_DIRECTION = 7,
+  LID_TOGGLE = 8,
+  PRESET_HOME = 9,
+  PRESET_SLEEP = 10,
+  PRESET_AWAY = 11,
+  PRESET_ECO = 12,
+  PRESET_OFF = 13,
+};
+
+constexpr Action LAST_ACTION = Action::PRESET_OFF;
+
+// Returns true if a value names an action other than NONE.  Stored mappings with any other action
+// are treated as empty slots.
+constexpr bool is_action(Action action) {
+  return action != Action::NONE && uint8_t(action) <= uint8_t(LAST_ACTION);
+}
+
+// Names of the actions in the order of their values starting with LIGHT_TOGGLE.
+// Must match the options of the learn action select.
+constexpr const char* ACTION_NAMES[] = {
+  "Light toggle",
+  "Light brighter",
+  "Light dimmer",
+  "Fan toggle",
+  "Fan faster",
+  "Fan slower",
+  "Fan direction",
+  "Lid toggle",
+  "Preset Home",
+  "Preset Sleep",
+  "Preset Away",
+  "Preset Eco",
+  "Preset Off",
+};
+
+static_assert(std::size(ACTION_NAMES) == size_t(LAST_ACTION));
+
+// A learned key packed for storage: address in bits 16-31, command in bits 8-15, action in bits 0-7.
+// An all-zero value is an empty slot.
+struct Mapping {
+  uint16_t address;
+  uint8_t command;
+  Action action;
+
+  static constexpr Mapping unpack(uint32_t packed) {
+    return {uint16_t(packed >> 16), uint8_t(packed >> 8), Action(packed & 0xff)};
+  }
+  constexpr uint32_t pack() const {
+    return (uint32_t(this->address) << 16) | (uint32_t(this->command) << 8) | uint32_t(this->action);
+  }
+};
+
+// Array of packed mappings held by the `minuet_ir_remote_mappings` global.
+using Storage = typename std::remove_reference<decltype(*minuet_ir_remote_mappings)>::type::value_type;
+
+// Maximum number of distinct remote addresses with learned keys.
+constexpr size_t MAX_ADDRESSES = 4;
+
+// Actions for each command of one remote address.
+struct AddressTable {
+  uint16_t address;
+  std::array<Action, 256> actions;
+};
+
+inline std::array<AddressTable, MAX_ADDRESSES> g_tables{};
+inline size_t g_table_count{0};
+inline Action g_learn_action{Action::NONE};
+
+Storage& mappings() {
+  return minuet_ir_remote_mappings->value();
+}
+
+// Rebuilds the address tables from the stored mappings.
+void rebuild_tables() {
+  g_table_count = 0;
+  for (uint32_t packed : mappings()) {
+    const Mapping mapping = Mapping::unpack(packed);
+    if (!is_action(mapping.action)) continue;
+    size_t i = 0;
+    while (i < g_table_count && g_tables[i].address != mapping.address) i++;
+    if (i == g_table_count) {
+      if (g_table_count == MAX_ADDRESSES) continue; // cannot happen after sanitize() since learn() enforces the limit
+      g_tables[i].address = mapping.address;
+      g_tables[i].actions.fill(Action::NONE);
+      g_table_count++;
+    }
+    g_tables[i].actions[mapping.command] = mapping.action;
+  }
+}
+
+const AddressTable* find_table(uint16_t address) {
+  for (size_t i = 0; i < g_table_count; i++) {
+    if (g_tables[i].address == address) return &g_tables[i];
+  }
+  return nullptr;
+}
+
+// Binds a key to an action, replacing any previous binding of the same key.
+// Returns false if there is no room for another mapping or address.
+bool learn(uint16_t address, uint8_t command, Action action) {
+  if (!is_action(action)) return false;
+  auto& slots = mappings();
+  uint32_t* free_slot = nullptr;
+  for (auto& packed : slots) {
+    const Mapping mapping = Mapping::unpack(packed);
+    if (!is_action(mapping.action)) {
+      if (!free_slot) free_slot = &packed;
+    } else if (mapping.address == address && mapping.command == command) {
+      free_slot = &packed;
+      break;
+    }
+  }
+  if (!free_slot) return false;
+  if (!find_table(address) && g_table_count == MAX_ADDRESSES) return false;
+  *free_slot = Mapping{address, command, action}.pack();
+  rebuild_tables();
+  return true;
+}
+
+void clear() {
+  mappings().fill(0);
+  rebuild_tables();
+}
+
+size_t count() {
+  size_t n = 0;
+  for (uint32_t packed : mappings()) {
+    if (is_action(Mapping::unpack(packed).action)) n++;
+  }
+  return n;
+}
+
+const char* action_name(Action action) {
+  return is_action(action) ? ACTION_NAMES[size_t(action) - 1] : "None";
+}
+
+// Clears the stored mappings of any address beyond the first MAX_ADDRESSES distinct ones, as
+// might be restored from a corrupted or older record, so that they don't linger unused.
+// Returns the number of mappings cleared.
+size_t sanitize() {
+  std::array<uint16_t, MAX_ADDRESSES> addresses;
+  size_t address_count = 0;
+  size_t cleared = 0;
+  for (uint32_t& packed : mappings()) {
+    const Mapping mapping = Mapping::unpack(packed);
+    if (!is_action(mapping.action)) continue;
+    const auto end = addresses.begin() + address_count;
+    if (std::find(addresses.begin(), end, mapping.address) != end) continue;
+    if (address_count < MAX_ADDRESSES) {
+      addresses[address_count++] = mapping.address;
+      continue;
+    }
+    ESP_LOGW(TAG, "Dropping IR remote code for too many remotes: address 0x%04x, command 0x%02x, action %s",
+        mapping.address, mapping.command, action_name(mapping.action));
+    packed = 0;
+    cleared++;
+  }
+  return cleared;
+}
+
+// Waits for the next key press to bind to an action.
+void start_learning(Action action) {
+  g_learn_action = action;
+  ESP_LOGI(TAG, "Learning IR remote code for action: %s", action_name(action));
+  minuet::tone::play("ir_learn_start");
+}
+
+void cancel_learning() {
+  if (g_learn_action == Action::NONE) return;
+  g_learn_action = Action::NONE;
+  ESP_LOGI(TAG, "Stopped learning IR remote code");
+  minuet::tone::play("ir_learn_cancel");
+}
+
+bool is_learning() {
+  return g_learn_action != Action::NONE;
+}
+
+void perform(Action action) {
+  auto& fan = minuet_fan;
+  auto& therm = minuet_thermostat;
+  switch (action) {
+    case Action::NONE:
+      return;
+    case Action::LIGHT_TOGGLE:
+    case Action::LIGHT_BRIGHTER:
+    case Action::LIGHT_DIMMER: {
+      const auto& fn = action == Action::LIGHT_TOGGLE ? minuet_keypad_accessory_toggle->value()
+          : action == Action::LIGHT_BRIGHTER ? minuet_keypad_accessory_up->value()
+          : minuet_keypad_accessory_down->value();
+      if (!fn || !fn()) {
+        minuet::tone::play("forbidden");
+      }
+      return;
+    }
+    case Action::FAN_TOGGLE:
+      if (fan->state) {
+        fan->turn_off().perform();
+        minuet::tone::play("manual_fan_off");
+      } else {
+        fan->turn_on().perform();
+        minuet::tone::play("manual_fan_on");
+      }
+      return;
+    case Action::FAN_FASTER:
+      if (fan->state) {
+        fan->make_call().set_speed(fan->speed + 1).perform();
+        minuet::tone::play("manual_speed_up");
+      } else {
+        fan->turn_on().perform();
+        minuet::tone::play("manual_fan_on");
+      }
+      return;
+    case Action::FAN_SLOWER:
+      if (fan->state) {
+        fan->make_call().set_speed(fan->speed - 1).perform();
+        minuet::tone::play("manual_speed_down");
+      }
+      return;
+    case Action::FAN_DIRECTION:
+      if (fan->state) {
+        const bool exhaust = !fan_direction_is_exhaust(fan->direction);
+        fan->make_call().set_direction(fan_direction(exhaust)).perform();
+        minuet::tone::play(exhaust ? "manual_dir_out" : "manual_dir_in");
+      }
+      return;
+    case Action::LID_TOGGLE:
+      if (minuet_lid->is_fully_closed()) {
+        minuet_lid->make_call().set_command_open().perform();
+        minuet::tone::play("manual_lid_open");
+      } else {
+        minuet_lid->make_call().set_command_close().perform();
+        minuet::tone::play("manual_lid_close");
+      }
+      return;
+    case Action::PRESET_HOME:
+      therm->make_call().set_preset(ClimatePreset::CLIMATE_PRESET_HOME).perform();
+      minuet::tone::play("ir_confirm");
+      return;
+    case Action::PRESET_SLEEP:
+      therm->make_call().set_preset(ClimatePreset::CLIMATE_PRESET_SLEEP).perform();
+      minuet::tone::play("ir_confirm");
+      return;
+    case Action::PRESET_AWAY:
+      therm->make_call().set_preset(ClimatePreset::CLIMATE_PRESET_AWAY).perform();
+      minuet::tone::play("ir_confirm");
+      return;
+    case Action::PRESET_ECO:
+      therm->make_call().set_preset(ClimatePreset::CLIMATE_PRESET_ECO).perform();
+      minuet::tone::play("ir_confirm");
+      return;
+    case Action::PRESET_OFF:
+      therm->make_call().set_preset("Off").perform(); // custom preset
+      minuet::tone::play("ir_confirm");
+      return;
+  }
+}
+
+// Extracts the command byte of an NEC code.  Accepts only a single frame whose command carries
+// the complement of its low byte in its high byte; repeats and corrupted frames are rejected.
+constexpr bool nec_command(const esphome::remote_base::NECData& code, uint8_t& command) {
+  if (code.command_repeats != 1) return false;
+  const uint8_t low = uint8_t(code.command);
+  const uint8_t high = uint8_t(code.command >> 8);
+  if (uint8_t(low ^ high) != 0xff) return false;
+  command = low;
+  return true;
+}
+
+// Handles an NEC code received by the infrared receiver.
+// Returns true if the code was learned or bound to an action, otherwise it should be passed on to accessories.
+bool handle_nec(esphome::remote_base::NECData code) {
+  uint8_t command;
+  if (!nec_command(code, command)) return false;
+
+  if (is_learning()) {
+    const Action action = g_learn_action;
+    g_learn_action = Action::NONE;
+    if (learn(code.address, command, action)) {
+      ESP_LOGI(TAG, "Learned IR remote code: address 0x%04x, command 0x%02x, action %s",
+          code.address, command, action_name(action));
+      minuet::tone::play("ir_learn_done");
+    } else {
+      ESP_LOGW(TAG, "No room to learn IR remote code: address 0x%04x, command 0x%02x", code.address, command);
+      minuet::tone::play("forbidden");
+    }
+    return true;
+  }
+
+  const AddressTable* table = find_table(code.address);
+  if (!table) return false;
+  const Action action = table->actions[command];
+  if (action == Action::NONE) return false;
+  ESP_LOGD(TAG, "Received learned IR remote code: %s", action_name(action));
+  perform(action);
+  return true;
+}
+
+} // namespace ir_remote
+} // namespace minuet
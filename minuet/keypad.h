@@ -0,0 +1,248 @@
+// MINUET KEYPAD
+//
+// Turns the scanned keypad state into key presses, holds and multiple taps, and sequences the
+// keypad indicators.
+//
+// Nothing here reads the clock or touches the hardware.  The keypad scan passes in the key bits
+// and the current time, and the actions are supplied by the caller, so that the timing can be
+// exercised with any sequence of key states and timestamps.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "core.h"
+#include "esphome/core/log.h"
+
+namespace minuet {
+namespace keypad {
+
+// One bit per key
+constexpr uint32_t KEY_UP = 1u << 0;
+constexpr uint32_t KEY_DOWN = 1u << 1;
+constexpr uint32_t KEY_RAIN = 1u << 2;
+constexpr uint32_t KEY_POWER = 1u << 3;
+constexpr uint32_t KEY_DIRECTION = 1u << 4;
+constexpr uint32_t KEY_AUTO = 1u << 5;
+constexpr uint32_t KEY_4_CLOSE = 1u << 6;
+constexpr uint32_t KEY_4_OPEN = 1u << 7;
+constexpr uint32_t KEY_4_OFF = 1u << 8;
+constexpr uint32_t KEY_4_ON = 1u << 9;
+
+// Key combinations
+constexpr uint32_t KEY_COMBO_OPEN_CLOSE = KEY_UP | KEY_DOWN;
+constexpr uint32_t KEY_COMBO_AUTO_UP = KEY_AUTO | KEY_UP;
+constexpr uint32_t KEY_COMBO_AUTO_DOWN = KEY_AUTO | KEY_DOWN;
+constexpr uint32_t KEY_COMBO_AUTO_DIRECTION = KEY_AUTO | KEY_DIRECTION;
+constexpr uint32_t KEY_COMBO_AUTO_POWER = KEY_AUTO | KEY_POWER;
+constexpr uint32_t KEY_COMBO_AUTO_OPEN_CLOSE = KEY_AUTO | KEY_COMBO_OPEN_CLOSE;
+constexpr uint32_t KEY_COMBO_POWER_UP = KEY_POWER | KEY_UP;
+constexpr uint32_t KEY_COMBO_POWER_DOWN = KEY_POWER | KEY_DOWN;
+constexpr uint32_t KEY_COMBO_POWER_DIRECTION = KEY_POWER | KEY_DIRECTION;
+constexpr uint32_t KEY_COMBO_DIRECTION_UP = KEY_DIRECTION | KEY_UP;
+constexpr uint32_t KEY_COMBO_DIRECTION_DOWN = KEY_DIRECTION | KEY_DOWN;
+
+struct KeyInfo {
+  uint32_t keys;
+  const char* name;
+  uint32_t min_hold_ms; // 0 if the keys have no hold action
+};
+
+// Timing in milliseconds
+constexpr uint32_t DEBOUNCE_DURATION = 40;
+constexpr uint32_t MIN_PRESS_DURATION = 100;
+constexpr uint32_t MAX_PRESS_DURATION = 800;
+constexpr uint32_t MIN_HOLD_UP_DOWN_DURATION = 1000;
+constexpr uint32_t MIN_HOLD_ACCESSORY_TOGGLE_DURATION = 1000;
+constexpr uint32_t MIN_HOLD_AUTO_DURATION = 3000;
+constexpr uint32_t MIN_HOLD_SETTING_DURATION = 5000;
+constexpr uint32_t MIN_HOLD_FACTORY_RESET_DURATION = 15000;
+
+// Every potentially valid key combination.  Any other combination cancels the keys involved.
+constexpr std::array<KeyInfo, 21> KEYS = {{
+  {KEY_UP, "KEY_UP", MIN_HOLD_UP_DOWN_DURATION},
+  {KEY_DOWN, "KEY_DOWN", MIN_HOLD_UP_DOWN_DURATION},
+  {KEY_RAIN, "KEY_RAIN", 0},
+  {KEY_POWER, "KEY_POWER", MIN_HOLD_FACTORY_RESET_DURATION},
+  {KEY_DIRECTION, "KEY_DIRECTION", MIN_HOLD_ACCESSORY_TOGGLE_DURATION},
+  {KEY_AUTO, "KEY_AUTO", MIN_HOLD_AUTO_DURATION},
+  {KEY_4_CLOSE, "KEY_4_CLOSE", 0},
+  {KEY_4_OPEN, "KEY_4_OPEN", 0},
+  {KEY_4_OFF, "KEY_4_OFF", 0},
+  {KEY_4_ON, "KEY_4_ON", 0},
+  {KEY_COMBO_OPEN_CLOSE, "KEY_COMBO_OPEN_CLOSE", 0},
+  {KEY_COMBO_AUTO_UP, "KEY_COMBO_AUTO_UP", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_AUTO_DOWN, "KEY_COMBO_AUTO_DOWN", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_AUTO_DIRECTION, "KEY_COMBO_AUTO_DIRECTION", 0},
+  {KEY_COMBO_AUTO_POWER, "KEY_COMBO_AUTO_POWER", 0},
+  {KEY_COMBO_AUTO_OPEN_CLOSE, "KEY_COMBO_AUTO_OPEN_CLOSE", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_POWER_UP, "KEY_COMBO_POWER_UP", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_POWER_DOWN, "KEY_COMBO_POWER_DOWN", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_POWER_DIRECTION, "KEY_COMBO_POWER_DIRECTION", MIN_HOLD_SETTING_DURATION},
+  {KEY_COMBO_DIRECTION_UP, "KEY_COMBO_DIRECTION_UP", 0},
+  {KEY_COMBO_DIRECTION_DOWN, "KEY_COMBO_DIRECTION_DOWN", 0},
+}};
+
+// Returns the entry for a key combination or nullptr if it isn't valid.
+constexpr const KeyInfo* find_key(uint32_t keys) {
+  for (const KeyInfo& info : KEYS) {
+    if (info.keys == keys) return &info;
+  }
+  return nullptr;
+}
+
+// Combinations whose presses are counted while the modifier stays held and reported as a
+// single tap count once all keys are released.  Earlier entries are reported first.
+constexpr std::array<uint32_t, 2> TAP_COMBOS = {KEY_COMBO_AUTO_POWER, KEY_COMBO_AUTO_DIRECTION};
+
+// Key press detection.  Call scan() with the raw key bits on every keypad scan.
+//
+// A press is reported when the keys are released after being held for between
+// MIN_PRESS_DURATION and MAX_PRESS_DURATION.  A combination can be formed by adding keys one at
+// a time, and a combination with AUTO or DIRECTION can be pressed repeatedly while the modifier
+// stays held.  A hold is reported on every scan once the keys have been held for their minimum
+// hold duration until the hold action accepts it, which cancels the keys until they are released.
+class Keypad {
+public:
+  // `on_press(keys)` handles a key press.
+  // `on_hold(keys, hold_ms)` handles a key hold and returns true if it acted upon it.
+  // `on_taps(keys, count)` handles the number of times one of the TAP_COMBOS was pressed.
+  template <typename OnPress, typename OnHold, typename OnTaps>
+  void scan(uint32_t keys, uint32_t now_ms, OnPress&& on_press, OnHold&& on_hold, OnTaps&& on_taps) {
+    // Debounce the keys
+    if (keys != this->bouncy_keys_) {
+      this->bouncy_keys_ = keys;
+      this->bouncy_time_ = now_ms;
+      return; // wait for key state to be debounced before processing it
+    }
+    if (now_ms - this->bouncy_time_ < DEBOUNCE_DURATION) {
+      return; // wait for key state to be debounced before processing it
+    }
+
+    const KeyInfo* info = find_key(keys);
+    bool valid = info != nullptr;
+
+    // Wake up suppressed indicators
+    if (keys) this->activity_ = true;
+
+    // Handle pending multiple-tap key presses after the modifier has been released
+    if (keys == 0) {
+      for (size_t i = 0; i < TAP_COMBOS.size(); i++) {
+        if (this->taps_[i]) {
+          on_taps(TAP_COMBOS[i], this->taps_[i]);
+          this->taps_[i] = 0;
+        }
+      }
+    }
+
+    const auto press = [&]() {
+      const uint32_t press_duration = now_ms - this->last_time_;
+      if (press_duration < MIN_PRESS_DURATION || press_duration > MAX_PRESS_DURATION) return;
+      ESP_LOGD(TAG, "Key press: %s", find_key(this->last_keys_)->name);
+      for (size_t i = 0; i < TAP_COMBOS.size(); i++) {
+        if (this->last_keys_ == TAP_COMBOS[i]) {
+          this->taps_[i] += 1;
+          return;
+        }
+      }
+      on_press(this->last_keys_);
+    };
+
+    if (keys == 0 && this->last_valid_) {
+      // A key was released
+      press();
+    } else if (valid && this->last_keys_ == 0) {
+      // A key was pressed on its own
+      this->last_time_ = now_ms;
+    } else if (valid && keys != this->last_keys_ && keys == (keys | this->last_keys_)) {
+      // A key was pressed that adds to a previously pressed key to form a combo
+      this->last_time_ = now_ms;
+    } else if (valid && this->last_valid_ && keys == this->last_keys_) {
+      // A key is being held
+      const uint32_t hold_duration = now_ms - this->last_time_;
+      if (info->min_hold_ms && hold_duration >= info->min_hold_ms) {
+        ESP_LOGD(TAG, "Key hold: %s", info->name);
+        if (on_hold(keys, hold_duration)) {
+          valid = false; // cancel further processing of this key
+        }
+      }
+    } else if (valid && (keys == KEY_AUTO || keys == KEY_DIRECTION) && this->last_valid_ &&
+               (this->last_keys_ & keys) != 0) {
+      // A key that was previously combined with the modifier has been released while the
+      // modifier remains held
+      press();
+      valid = false; // cancel processing of the modifier itself
+    } else if (valid) {
+      // A different key is pressed now than was pressed before and does not form a valid combo sequence
+      valid = false; // cancel further processing of this key
+    }
+    this->last_keys_ = keys;
+    this->last_valid_ = valid;
+  }
+
+  // Returns true if any key was down since the last call.
+  bool take_activity() {
+    const bool activity = this->activity_;
+    this->activity_ = false;
+    return activity;
+  }
+
+private:
+  uint32_t bouncy_keys_{0};
+  uint32_t bouncy_time_{0};
+  uint32_t last_keys_{0};
+  bool last_valid_{false};
+  uint32_t last_time_{0};
+  std::array<uint8_t, TAP_COMBOS.size()> taps_{};
+  bool activity_{false};
+};
+
+// A keypad indicator LED.  Call tick() periodically with the condition it shows:
+//   0: off
+//   1: blinking
+//   2: steady
+// A change of condition or a key press shows the indicator for IDLE_TICKS even while the
+// indicators are suppressed.
+class Indicator {
+public:
+  static constexpr uint8_t IDLE_TICKS = 10;
+
+  // Overrides the condition with the given number of ticks of a slow blink.
+  void blink(uint8_t ticks) { this->blinks_ = ticks; }
+
+  // Advances by one tick.  Returns true if the indicator is lit.
+  bool tick(uint8_t condition, bool key_pressed, bool suppressed) {
+    if (this->blinks_) {
+      this->blinks_ -= 1;
+      this->state_ = (this->blinks_ & 2);
+      this->duration_ = 0;
+    } else {
+      if (this->condition_ != condition || key_pressed) {
+        this->condition_ = condition;
+        this->duration_ = IDLE_TICKS;
+      } else if (this->duration_) {
+        this->duration_ -= 1;
+      }
+      if (!this->condition_ || (!this->duration_ && suppressed)) {
+        this->state_ = false;
+      } else {
+        this->state_ = (this->condition_ == 1) ? !this->state_ : true;
+      }
+    }
+    return this->state_;
+  }
+
+private:
+  bool state_{false};
+  uint8_t blinks_{0};
+  uint8_t condition_{0};
+  uint8_t duration_{0};
+};
+
+inline Keypad g_keypad{};
+inline Indicator g_auto_indicator{};
+inline Indicator g_rain_indicator{};
+
+} // namespace keypad
+} // namespace minuet
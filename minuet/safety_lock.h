@@ -0,0 +1,91 @@
+// MINUET SAFETY LOCK
+//
+// Aggregates the individual safety lock reasons into a bitmask.
+//
+// Each source sets or clears its own bit as its state changes and the safety lock update script
+// runs only when the mask actually changes.  The script commits the mask to learn whether the
+// safety lock was just engaged or released so that it acts once per edge.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace minuet {
+
+class SafetyLock {
+public:
+  // Safety lock reasons in priority order, highest first.
+  enum Reason : uint8_t {
+    BATTERY = 0,
+    RAIN = 1,
+    ACCESSORY = 2,
+    MANUAL = 3,
+    AUTOMATION = 4,
+    REASON_COUNT = 5,
+  };
+
+  using Mask = uint8_t;
+
+  static constexpr const char* REASON_NAMES[REASON_COUNT] = {
+    "Battery",
+    "Rain",
+    "Accessory",
+    "Manual",
+    "Automation",
+  };
+
+  static constexpr Mask bit(Reason reason) { return Mask(1u << reason); }
+
+  // Sets or clears a reason.  Returns true if the mask changed.
+  constexpr bool set(Reason reason, bool active) {
+    const Mask mask = active ? this->mask_ | bit(reason) : this->mask_ & ~bit(reason);
+    if (mask == this->mask_) return false;
+    this->mask_ = mask;
+    return true;
+  }
+
+  constexpr Mask mask() const { return this->mask_; }
+  constexpr bool is_locked() const { return this->mask_ != 0; }
+  constexpr bool is_active(Reason reason) const { return (this->mask_ & bit(reason)) != 0; }
+
+  // Returns the highest priority active reason or REASON_COUNT if none are active.
+  constexpr Reason top_reason() const {
+    return this->mask_ ? Reason(__builtin_ctz(this->mask_)) : REASON_COUNT;
+  }
+
+  // Marks the current mask as handled.  Returns the mask that was handled previously.
+  constexpr Mask commit() {
+    const Mask previous = this->committed_mask_;
+    this->committed_mask_ = this->mask_;
+    return previous;
+  }
+
+  // Returns the name of the highest priority active reason or "None".
+  const char* top_reason_name() const {
+    const Reason reason = this->top_reason();
+    return reason == REASON_COUNT ? "None" : REASON_NAMES[reason];
+  }
+
+  // Returns the names of all active reasons in priority order, such as "Battery, Manual", or "None".
+  std::string describe() const {
+    if (!this->mask_) return "None";
+    std::string text;
+    for (uint8_t reason = 0; reason < REASON_COUNT; reason++) {
+      if (this->mask_ & bit(Reason(reason))) {
+        if (!text.empty()) text += ", ";
+        text += REASON_NAMES[reason];
+      }
+    }
+    return text;
+  }
+
+private:
+  Mask mask_{0};
+  Mask committed_mask_{0};
+};
+
+static_assert(SafetyLock::REASON_COUNT <= sizeof(SafetyLock::Mask) * 8);
+
+inline SafetyLock g_safety_lock{};
+
+} // namespace minuet
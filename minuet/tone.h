@@ -0,0 +1,561 @@
+// MINUET AUDIBLE FEEDBACK
+//
+// Compiles the table of RTTTL tones into notes at build time and plays them
+// on the tone PWM output.
+//
+// The tone table is parsed by the compiler so that playing a tone is just a
+// perfect-hash lookup by name followed by stepping through an array of notes.
+// No strings are parsed and nothing is allocated on the heap when a tone plays.
+// Notes are sequenced by a hardware timer so playback does not depend on the main loop.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "core.h"
+#include "esphome/core/log.h"
+
+namespace minuet {
+namespace tone {
+
+// A pre-parsed note.
+struct Note {
+  uint16_t frequency_hz; // 0 for a pause
+  uint16_t duration_ms;
+};
+
+// A named sequence of notes.
+struct Tone {
+  const char* name;    // not NUL-terminated, see `name_length`
+  uint8_t name_length;
+  bool important;      // name starts with '!', cannot be suppressed
+  uint16_t first_note; // index of the first note in the note table
+  uint16_t note_count;
+
+  constexpr std::string_view get_name() const { return std::string_view(name, name_length); }
+};
+
+// -----------------------------------------------------------------------------
+// RTTTL parser
+// -----------------------------------------------------------------------------
+
+// Note frequencies from C4 to B7, the same range supported by the ESPHome RTTTL component.
+constexpr uint16_t NOTE_FREQUENCIES[] = {
+  262, 277, 294, 311, 330, 349, 370, 392, 415, 440, 466, 494,
+  523, 554, 587, 622, 659, 698, 740, 784, 831, 880, 932, 988,
+  1047, 1109, 1175, 1245, 1319, 1397, 1480, 1568, 1661, 1760, 1865, 1976,
+  2093, 2217, 2349, 2489, 2637, 2794, 2960, 3136, 3322, 3520, 3729, 3951,
+};
+
+// Consecutive notes of the same pitch are separated by a short pause so they can be told apart.
+constexpr uint16_t NOTE_GAP_MS = 10;
+
+// Sink that counts the notes without storing them.
+struct NoteCounter {
+  size_t count{0};
+  constexpr bool add(Note) { count++; return true; }
+};
+
+// Sink that stores the notes in a fixed-capacity buffer.
+struct NoteWriter {
+  Note* notes;
+  size_t capacity;
+  size_t count{0};
+  constexpr bool add(Note note) {
+    if (count == capacity) return false;
+    notes[count++] = note;
+    return true;
+  }
+};
+
+constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Parses a decimal integer, saturating at MAX_INTEGER rather than wrapping around.
+constexpr unsigned MAX_INTEGER = 999999;
+constexpr unsigned parse_integer(std::string_view text, size_t& pos) {
+  unsigned value = 0;
+  while (pos < text.size() && is_digit(text[pos])) {
+    value = std::min(value * 10 + unsigned(text[pos++] - '0'), MAX_INTEGER);
+  }
+  return value;
+}
+
+constexpr void skip_spaces(std::string_view text, size_t& pos) {
+  while (pos < text.size() && text[pos] == ' ') pos++;
+}
+
+// Splits an RTTTL tone into its name and the remainder after the first colon.
+// Returns false if the tone has no name.
+constexpr bool split_name(std::string_view rtttl, std::string_view& name, std::string_view& rest) {
+  const size_t colon = rtttl.find(':');
+  if (colon == std::string_view::npos || colon == 0) return false;
+  name = rtttl.substr(0, colon);
+  rest = rtttl.substr(colon + 1);
+  return true;
+}
+
+// Parses the settings and notes of an RTTTL tone (everything after the name) and
+// adds the notes to the sink.  An empty tone has no notes.  Returns false if malformed.
+template <typename Sink>
+constexpr bool parse_notes(std::string_view rtttl, Sink& sink) {
+  if (rtttl.empty()) return true;
+
+  // Settings
+  unsigned default_duration = 4;
+  unsigned default_octave = 6;
+  unsigned bpm = 63;
+  size_t pos = 0;
+  while (pos < rtttl.size() && rtttl[pos] != ':') {
+    skip_spaces(rtttl, pos);
+    if (pos + 1 >= rtttl.size() || rtttl[pos + 1] != '=') return false;
+    const char key = rtttl[pos];
+    pos += 2;
+    const unsigned value = parse_integer(rtttl, pos);
+    switch (key) {
+      case 'd': default_duration = value; break;
+      case 'o': default_octave = value; break;
+      case 'b': bpm = value; break;
+      default: return false;
+    }
+    skip_spaces(rtttl, pos);
+    if (pos < rtttl.size() && rtttl[pos] == ',') pos++;
+  }
+  if (pos == rtttl.size() || default_duration == 0 || bpm == 0) return false;
+  pos++; // skip ':'
+
+  // Notes
+  const unsigned whole_note_ms = 60u * 1000u * 4u / bpm;
+  Note pending{};
+  bool has_pending = false;
+  while (pos < rtttl.size()) {
+    skip_spaces(rtttl, pos);
+    const unsigned duration = parse_integer(rtttl, pos);
+    unsigned duration_ms = whole_note_ms / (duration ? duration : default_duration);
+    if (pos == rtttl.size()) return false;
+
+    int semitone;
+    switch (rtttl[pos++]) {
+      case 'c': semitone = 0; break;
+      case 'd': semitone = 2; break;
+      case 'e': semitone = 4; break;
+      case 'f': semitone = 5; break;
+      case 'g': semitone = 7; break;
+      case 'a': semitone = 9; break;
+      case 'b': semitone = 11; break;
+      case 'p': semitone = -1; break;
+      default: return false;
+    }
+    if (pos < rtttl.size() && rtttl[pos] == '#') {
+      if (semitone < 0) return false;
+      semitone++;
+      pos++;
+    }
+    bool dotted = false;
+    if (pos < rtttl.size() && rtttl[pos] == '.') {
+      dotted = true;
+      pos++;
+    }
+    unsigned octave = parse_integer(rtttl, pos);
+    if (octave == 0) octave = default_octave;
+    if (pos < rtttl.size() && rtttl[pos] == '.') {
+      dotted = true;
+      pos++;
+    }
+    if (dotted) duration_ms += duration_ms / 2;
+    // Very slow tempos can produce notes longer than a Note can hold.
+    duration_ms = std::min(duration_ms, unsigned(UINT16_MAX));
+    skip_spaces(rtttl, pos);
+    if (pos < rtttl.size()) {
+      if (rtttl[pos] != ',') return false;
+      pos++;
+    }
+
+    uint16_t frequency_hz = 0;
+    if (semitone >= 0) {
+      const int index = (int(octave) - 4) * 12 + semitone;
+      if (index < 0 || index >= int(std::size(NOTE_FREQUENCIES))) return false;
+      frequency_hz = NOTE_FREQUENCIES[index];
+    }
+    const Note note{frequency_hz, uint16_t(duration_ms)};
+
+    // Hold each note back until the next one is known so that a gap can be inserted
+    // between consecutive notes of the same pitch.
+    if (has_pending) {
+      if (pending.frequency_hz != 0 && pending.frequency_hz == note.frequency_hz
+          && pending.duration_ms > NOTE_GAP_MS) {
+        pending.duration_ms -= NOTE_GAP_MS;
+        if (!sink.add(pending) || !sink.add(Note{0, NOTE_GAP_MS})) return false;
+      } else if (!sink.add(pending)) {
+        return false;
+      }
+    }
+    pending = note;
+    has_pending = true;
+  }
+  return !has_pending || sink.add(pending);
+}
+
+// -----------------------------------------------------------------------------
+// Compiled tone table
+// -----------------------------------------------------------------------------
+
+// Hashes a tone name for the perfect-hash lookup (FNV-1a with a murmur finalizer).
+constexpr uint32_t hash_name(std::string_view name, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : name) {
+    h ^= uint8_t(c);
+    h *= 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+// Number of hash slots for a given number of tones: a power of two at least twice as large.
+constexpr size_t slot_count(size_t tone_count) {
+  size_t n = 1;
+  while (n < tone_count * 2) n <<= 1;
+  return n;
+}
+
+// Maximum number of seeds to try when searching for a collision-free hash.
+constexpr uint32_t MAX_HASH_SEEDS = 10000;
+
+// Type-erased view of a compiled tone table.
+struct Catalog {
+  const Tone* tones{nullptr};
+  const Note* notes{nullptr};
+  const uint8_t* slots{nullptr}; // tone index + 1, or 0 if the slot is empty
+  size_t slot_mask{0};
+  uint32_t seed{0};
+
+  // Finds a tone by name in constant time.  Returns nullptr if not found.
+  const Tone* find(std::string_view name) const {
+    if (!slots) return nullptr;
+    const uint8_t slot = slots[hash_name(name, seed) & slot_mask];
+    if (slot == 0) return nullptr;
+    const Tone* tone = &tones[slot - 1];
+    return tone->get_name() == name ? tone : nullptr;
+  }
+};
+
+template <size_t TONE_COUNT, size_t NOTE_COUNT>
+struct CompiledTones {
+  static_assert(TONE_COUNT < 255, "Too many tones");
+  static constexpr size_t SLOT_COUNT = slot_count(TONE_COUNT);
+
+  std::array<Tone, TONE_COUNT> tones{};
+  std::array<Note, NOTE_COUNT == 0 ? 1 : NOTE_COUNT> notes{};
+  std::array<uint8_t, SLOT_COUNT> slots{};
+  uint32_t seed{0};
+  bool valid_tones{true};
+  bool valid_hash{false};
+
+  constexpr Catalog catalog() const {
+    return Catalog{tones.data(), notes.data(), slots.data(), SLOT_COUNT - 1, seed};
+  }
+};
+
+// Counts the notes in a table of RTTTL tones.  Malformed tones count as empty
+// and are reported by `compile`.
+template <size_t N>
+constexpr size_t count_notes(const char* const (&rtttl_tones)[N]) {
+  size_t count = 0;
+  for (const char* rtttl : rtttl_tones) {
+    std::string_view name, rest;
+    NoteCounter counter;
+    if (split_name(rtttl, name, rest) && parse_notes(rest, counter)) {
+      count += counter.count;
+    }
+  }
+  return count;
+}
+
+// Parses a table of RTTTL tones and builds a perfect hash of their names.
+// Intended to be evaluated at compile time:
+//
+//   static constexpr const char* TONES[] = { ... };
+//   static constexpr auto TABLE = compile<std::size(TONES), count_notes(TONES)>(TONES);
+template <size_t TONE_COUNT, size_t NOTE_COUNT>
+constexpr CompiledTones<TONE_COUNT, NOTE_COUNT> compile(const char* const (&rtttl_tones)[TONE_COUNT]) {
+  using Table = CompiledTones<TONE_COUNT, NOTE_COUNT>;
+  Table table{};
+
+  // Parse the notes
+  size_t note_index = 0;
+  for (size_t i = 0; i < TONE_COUNT; i++) {
+    std::string_view name, rest;
+    if (!split_name(rtttl_tones[i], name, rest) || name.size() > 255) {
+      table.valid_tones = false;
+      continue;
+    }
+    NoteWriter writer{table.notes.data() + note_index, NOTE_COUNT - note_index};
+    if (!parse_notes(rest, writer)) {
+      table.valid_tones = false;
+      writer.count = 0;
+    }
+    table.tones[i] = Tone{name.data(), uint8_t(name.size()), name[0] == '!',
+                          uint16_t(note_index), uint16_t(writer.count)};
+    note_index += writer.count;
+  }
+
+  // Search for a seed that hashes every name into a distinct slot
+  for (uint32_t seed = 0; seed < MAX_HASH_SEEDS && !table.valid_hash; seed++) {
+    std::array<uint8_t, Table::SLOT_COUNT> slots{};
+    bool collision = false;
+    for (size_t i = 0; i < TONE_COUNT && !collision; i++) {
+      uint8_t& slot = slots[hash_name(table.tones[i].get_name(), seed) & (Table::SLOT_COUNT - 1)];
+      collision = slot != 0;
+      slot = uint8_t(i + 1);
+    }
+    if (!collision) {
+      table.slots = slots;
+      table.seed = seed;
+      table.valid_hash = true;
+    }
+  }
+  return table;
+}
+
+// -----------------------------------------------------------------------------
+// Player
+// -----------------------------------------------------------------------------
+
+// Maximum number of notes in a tone supplied at runtime by the API.
+constexpr size_t MAX_RUNTIME_NOTES = 256;
+
+// Tones of higher priority interrupt tones of lower priority.
+// Tones of lower priority are dropped while a tone of higher priority is playing.
+enum class Priority : uint8_t {
+  NORMAL = 0,
+  IMPORTANT = 1,
+};
+
+// Plays notes on the tone LEDC channel independently of the main loop.
+//
+// Each note boundary is scheduled on a one-shot esp_timer against an absolute
+// deadline so that note timing neither drifts nor stretches when the main loop
+// is busy with I2C transactions, Wi-Fi, or logging.  The timer callback runs
+// in the esp_timer task rather than in the ISR because the LEDC driver is not
+// safe to call from an interrupt; the esp_timer task preempts the loop task so
+// the latency is comparable.
+//
+// The player programs the LEDC timer and channel directly.  The ledc output
+// component is only responsible for attaching the channel to the pin.
+class Player {
+public:
+  // Takes over the LEDC channel, which must already be attached to its pin.
+  void setup(uint8_t channel);
+
+  // Starts playing notes unless a tone of higher priority is playing.
+  // Requests with the same non-null key as the tone that is playing are coalesced
+  // so that repeated requests do not restart the tone.
+  // The notes must remain valid until the tone finishes or is stopped.
+  void play(const Note* notes, size_t count, Priority priority, const void* key = nullptr);
+  void stop();
+  bool is_playing() const { return this->notes_ != nullptr; }
+
+  // Returns true if a tone of the given priority would be allowed to play now.
+  bool accepts(Priority priority) const { return !this->notes_ || priority >= this->priority_; }
+
+private:
+  // Duty cycle for a square wave at the LEDC duty resolution.
+  static constexpr ledc_timer_bit_t DUTY_RESOLUTION = LEDC_TIMER_10_BIT;
+  static constexpr uint32_t DUTY_HALF = 1u << (DUTY_RESOLUTION - 1);
+  static constexpr ledc_mode_t SPEED_MODE = LEDC_LOW_SPEED_MODE;
+
+  static void timer_callback_(void* arg) { static_cast<Player*>(arg)->advance_(); }
+  void advance_();
+  void output_(uint16_t frequency_hz);
+
+  ledc_channel_t channel_{};
+  ledc_timer_t ledc_timer_{};
+  esp_timer_handle_t timer_{nullptr};
+
+  // Shared with the timer callback.
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+  const Note* volatile notes_{nullptr};
+  size_t count_{0};
+  size_t index_{0};
+  Priority priority_{Priority::NORMAL};
+  const void* key_{nullptr};
+  int64_t deadline_us_{0};
+};
+
+void Player::setup(uint8_t channel) {
+  this->channel_ = ledc_channel_t(channel);
+  // The ledc output component assigns two channels to each timer.
+  this->ledc_timer_ = ledc_timer_t((channel % 8) / 2);
+
+  ledc_timer_config_t timer_config{};
+  timer_config.speed_mode = SPEED_MODE;
+  timer_config.duty_resolution = DUTY_RESOLUTION;
+  timer_config.timer_num = this->ledc_timer_;
+  timer_config.freq_hz = 1000;
+  timer_config.clk_cfg = LEDC_AUTO_CLK;
+  if (ledc_timer_config(&timer_config) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to configure the tone LEDC timer");
+    return;
+  }
+  this->output_(0);
+
+  esp_timer_create_args_t timer_args{};
+  timer_args.callback = &Player::timer_callback_;
+  timer_args.arg = this;
+  timer_args.dispatch_method = ESP_TIMER_TASK;
+  timer_args.name = "minuet_tone";
+  if (esp_timer_create(&timer_args, &this->timer_) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to create the tone timer");
+    this->timer_ = nullptr;
+  }
+}
+
+void Player::play(const Note* notes, size_t count, Priority priority, const void* key) {
+  if (!this->timer_ || count == 0) return;
+
+  portENTER_CRITICAL(&this->lock_);
+  if (this->notes_ && (priority < this->priority_ || (key && key == this->key_))) {
+    portEXIT_CRITICAL(&this->lock_);
+    return;
+  }
+  portEXIT_CRITICAL(&this->lock_);
+
+  // Once stopped, the callback cannot run again until the timer is restarted.
+  esp_timer_stop(this->timer_);
+  portENTER_CRITICAL(&this->lock_);
+  this->notes_ = notes;
+  this->count_ = count;
+  this->index_ = 0;
+  this->priority_ = priority;
+  this->key_ = key;
+  this->deadline_us_ = esp_timer_get_time();
+  portEXIT_CRITICAL(&this->lock_);
+  this->advance_();
+}
+
+void Player::stop() {
+  if (!this->timer_) return;
+  esp_timer_stop(this->timer_);
+  portENTER_CRITICAL(&this->lock_);
+  const bool was_playing = this->notes_ != nullptr;
+  this->notes_ = nullptr;
+  this->key_ = nullptr;
+  portEXIT_CRITICAL(&this->lock_);
+  if (was_playing) {
+    this->output_(0);
+  }
+}
+
+// Starts the next note and schedules the one after it, or silences the output at the end.
+void Player::advance_() {
+  portENTER_CRITICAL(&this->lock_);
+  if (!this->notes_) {
+    portEXIT_CRITICAL(&this->lock_);
+    return;
+  }
+  if (this->index_ == this->count_) {
+    this->notes_ = nullptr;
+    this->key_ = nullptr;
+    portEXIT_CRITICAL(&this->lock_);
+    this->output_(0);
+    return;
+  }
+  const Note note = this->notes_[this->index_++];
+  this->deadline_us_ += int64_t(note.duration_ms) * 1000;
+  const int64_t delay_us = this->deadline_us_ - esp_timer_get_time();
+  portEXIT_CRITICAL(&this->lock_);
+
+  this->output_(note.frequency_hz);
+  esp_timer_start_once(this->timer_, delay_us > 0 ? uint64_t(delay_us) : 0);
+}
+
+void Player::output_(uint16_t frequency_hz) {
+  if (frequency_hz) {
+    ledc_set_freq(SPEED_MODE, this->ledc_timer_, frequency_hz);
+    ledc_set_duty(SPEED_MODE, this->channel_, DUTY_HALF);
+  } else {
+    ledc_set_duty(SPEED_MODE, this->channel_, 0);
+  }
+  ledc_update_duty(SPEED_MODE, this->channel_);
+}
+
+// -----------------------------------------------------------------------------
+// Module state and API
+// -----------------------------------------------------------------------------
+
+inline Catalog g_catalog{};
+inline const char* g_default_if_unknown{""};
+inline Player g_player{};
+// Runtime tones alternate between two buffers so that a new tone can be parsed while the
+// previous one is still playing from the other.
+inline std::array<std::array<Note, MAX_RUNTIME_NOTES>, 2> g_runtime_notes{};
+inline size_t g_runtime_buffer{0};
+
+// Installs the compiled tone table and takes over the LEDC channel on which to play it.
+void init(const Catalog& catalog, const char* default_if_unknown, uint8_t ledc_channel) {
+  g_catalog = catalog;
+  g_default_if_unknown = default_if_unknown;
+  g_player.setup(ledc_channel);
+}
+
+// Plays a tone from the tone table by name.
+// Plays the default tone if the name is unknown.  Empty tones play nothing.
+// Important tones play even when audible feedback has been disabled and interrupt
+// other tones.  Requesting the tone that is already playing does not restart it.
+void play(std::string_view name) {
+  const Tone* tone = g_catalog.find(name);
+  if (!tone) {
+    ESP_LOGD(TAG, "Tone not found: '%.*s'", int(name.size()), name.data());
+    tone = g_catalog.find(g_default_if_unknown);
+    if (!tone) return;
+  }
+  if (tone->note_count == 0) return;
+  if (!tone->important && !minuet_tone_enable->state) return;
+  g_player.play(&g_catalog.notes[tone->first_note], tone->note_count,
+      tone->important ? Priority::IMPORTANT : Priority::NORMAL, tone);
+}
+
+// Parses and plays a tone written in the RTTTL language, such as one supplied by the API.
+// The name of the tone is ignored except that names starting with '!' are important.
+void play_rtttl(std::string_view rtttl) {
+  std::string_view name, rest;
+  if (!split_name(rtttl, name, rest)) {
+    ESP_LOGW(TAG, "Malformed RTTTL tone: '%.*s'", int(rtttl.size()), rtttl.data());
+    return;
+  }
+  const Priority priority = name[0] == '!' ? Priority::IMPORTANT : Priority::NORMAL;
+  if (priority == Priority::NORMAL && !minuet_tone_enable->state) return;
+  if (!g_player.accepts(priority)) return;
+
+  // Parse into the buffer that the tone that is playing isn't using so that a malformed tone
+  // leaves it playing.
+  std::array<Note, MAX_RUNTIME_NOTES>& notes = g_runtime_notes[g_runtime_buffer ^ 1];
+  NoteWriter writer{notes.data(), notes.size()};
+  if (!parse_notes(rest, writer)) {
+    ESP_LOGW(TAG, "Malformed RTTTL tone: '%.*s'", int(rtttl.size()), rtttl.data());
+    return;
+  }
+  g_runtime_buffer ^= 1;
+  if (writer.count == 0) {
+    g_player.stop();
+    return;
+  }
+  g_player.play(notes.data(), writer.count, priority);
+}
+
+void stop() {
+  g_player.stop();
+}
+
+} // namespace tone
+} // namespace minuet